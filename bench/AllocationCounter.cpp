@@ -0,0 +1,28 @@
+// Counting global operator new for movie_booker_parser_bench. Kept in its own
+// translation unit so the replacements are never inlined into callers.
+
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local std::size_t g_allocations = 0;            // per thread: no contention in the threaded benchmarks
+}
+
+std::size_t AllocationCount()
+{
+    return g_allocations;
+}
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
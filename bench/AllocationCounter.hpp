@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Allocation counting for movie_booker_parser_bench only: AllocationCounter.cpp
+// replaces the global operator new/delete, which must not leak into the other
+// benchmarks, so it is linked into that executable alone.
+
+/**
+ * @brief Return the number of operator new calls made by the calling thread so far.
+ */
+std::size_t AllocationCount();
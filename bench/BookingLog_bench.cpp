@@ -0,0 +1,101 @@
+// Booking throughput with the write-ahead log in each durability mode.
+//
+// Every iteration is one successful MovieBooker::BookSeats of two seats with
+// the log attached. Threads walk disjoint seat ranges spread over many
+// showings, so bookings never conflict and only the log is shared. Without
+// a log a booking is a single CAS; Group mode only appends to a buffer;
+// Fsync mode makes every call durable, with concurrent callers sharing
+// fsyncs ("syncs" counts them).
+
+#include <benchmark/benchmark.h>
+#include <BookingLog.hpp>
+#include <MovieBooker.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace
+{
+    constexpr unsigned int kShowings = 64;
+    constexpr unsigned int kSeats = 1 << 16;            // per showing: 4M seats, 2M bookings per run
+    constexpr std::int64_t kPairs = std::int64_t(kShowings) * kSeats / 2;
+
+    std::unique_ptr<MovieBooker> booker;
+    std::unique_ptr<BookingLog> booking_log;
+    std::vector<IMovieBooker::ShowingId> showings;
+
+    std::string LogPath()
+    {
+        return (std::filesystem::temp_directory_path() / "movie_booker_bench.wal").string();
+    }
+
+    void Setup(bool withLog, Durability mode)
+    {
+        booker = std::make_unique<MovieBooker>();
+        std::vector<std::string> theaters;
+        for (unsigned int t = 0; t < kShowings; ++t)
+        {
+            theaters.push_back("Hall " + std::to_string(t));
+            booker->AddTheater(theaters.back(), kSeats);
+        }
+        booker->AddMovie("Matrix", theaters);
+        showings.clear();
+        for (const auto &theater : theaters)
+            showings.push_back(*booker->ResolveShowing(*booker->ResolveMovie("Matrix"), *booker->ResolveTheater(theater)));
+
+        if (!withLog)
+            return;
+        std::filesystem::remove(LogPath());
+        booking_log = std::make_unique<BookingLog>();
+        booking_log->Open(LogPath(), mode);
+        booker->SetBookingLog(booking_log.get());
+    }
+
+    void Teardown(const benchmark::State&)
+    {
+        booker.reset();
+        if (booking_log)
+        {
+            booking_log.reset();
+            std::filesystem::remove(LogPath());
+        }
+    }
+
+    void Book(benchmark::State& state)
+    {
+        // thread i books seat pairs i, i + threads, ... across all showings
+        const unsigned int pairsPerShowing = kSeats / 2;
+        std::uint64_t pair = static_cast<std::uint64_t>(state.thread_index());
+        const std::uint64_t step = static_cast<std::uint64_t>(state.threads());
+        std::vector<unsigned int> seats(2);
+        std::int64_t fails = 0;
+
+        for (auto _ : state)
+        {
+            const IMovieBooker::ShowingId showing = showings[(pair / pairsPerShowing) % kShowings];
+            seats[0] = static_cast<unsigned int>(pair % pairsPerShowing) * 2 + 1;
+            seats[1] = seats[0] + 1;
+            pair += step;
+            if (!booker->BookSeats(showing, seats))
+                ++fails;                                // only once the 2M pairs are used up
+        }
+        state.counters["fails"] = benchmark::Counter(static_cast<double>(fails), benchmark::Counter::kAvgThreads);
+        if (booking_log && state.thread_index() == 0)
+            state.counters["syncs"] = static_cast<double>(booking_log->SyncCount());
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    const int kMaxThreads = static_cast<int>(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1);
+}
+
+// without a log a run would book every pair before the minimum time is up
+BENCHMARK(Book)->Name("BookWithLog/no_log")->Setup([](const benchmark::State&) { Setup(false, Durability::None); })
+    ->Teardown(Teardown)->ThreadRange(1, kMaxThreads)->Iterations(kPairs / kMaxThreads)->UseRealTime();
+BENCHMARK(Book)->Name("BookWithLog/none")->Setup([](const benchmark::State&) { Setup(true, Durability::None); })
+    ->Teardown(Teardown)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK(Book)->Name("BookWithLog/group")->Setup([](const benchmark::State&) { Setup(true, Durability::Group); })
+    ->Teardown(Teardown)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK(Book)->Name("BookWithLog/fsync")->Setup([](const benchmark::State&) { Setup(true, Durability::Fsync); })
+    ->Teardown(Teardown)->ThreadRange(1, kMaxThreads)->UseRealTime();
@@ -0,0 +1,96 @@
+// Catalog build time: one AddMovie per movie against AddCatalog with the
+// whole catalog, or in chunks that double like the streaming JSON loader's.
+//
+// Catalogs have 10 showings per movie over 1000 theaters with listed
+// capacities, like the snapshot benchmark. AddMovie copies the catalog for
+// every movie, so it is only run up to 10k showings.
+
+#include <benchmark/benchmark.h>
+#include <MovieBooker.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned int kTheaters = 1000;
+    constexpr unsigned int kShowingsPerMovie = 10;
+
+    IMovieBooker::CatalogChunk MakeCatalog(std::int64_t showings)
+    {
+        IMovieBooker::CatalogChunk catalog;
+        for (unsigned int t = 0; t < kTheaters; ++t)
+            catalog.theaters.emplace_back("Theater " + std::to_string(t), 100 + t % 400);
+        for (std::int64_t m = 0; m < showings / kShowingsPerMovie; ++m)
+        {
+            std::vector<std::string> theaters;
+            for (unsigned int s = 0; s < kShowingsPerMovie; ++s)
+                theaters.push_back("Theater " + std::to_string((m + s * 97) % kTheaters));
+            catalog.movies.emplace_back("Movie " + std::to_string(m), std::move(theaters));
+        }
+        return catalog;
+    }
+
+    // run `load` on a fresh booker per iteration; teardown is not timed
+    template <typename Load>
+    void TimeLoads(benchmark::State& state, Load load)
+    {
+        for (auto _ : state)
+        {
+            auto booker = std::make_unique<MovieBooker>();
+            load(*booker);
+            benchmark::DoNotOptimize(booker->GetCatalogVersion());
+            state.PauseTiming();
+            booker.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_IngestAddMovie(benchmark::State& state)
+    {
+        const auto catalog = MakeCatalog(state.range(0));
+        TimeLoads(state, [&](MovieBooker& booker) {
+            for (const auto &theater : catalog.theaters)
+                booker.AddTheater(theater.first, theater.second);
+            for (const auto &movie : catalog.movies)
+                booker.AddMovie(movie.first, movie.second);
+        });
+    }
+    BENCHMARK(BM_IngestAddMovie)->Arg(3000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+    void BM_IngestAddCatalog(benchmark::State& state)
+    {
+        const auto catalog = MakeCatalog(state.range(0));
+        TimeLoads(state, [&](MovieBooker& booker) { booker.AddCatalog(catalog); });
+    }
+    BENCHMARK(BM_IngestAddCatalog)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+    void BM_IngestAddCatalogChunked(benchmark::State& state)
+    {
+        // 4096 showings first, then each chunk as large as everything before it
+        const auto catalog = MakeCatalog(state.range(0));
+        std::vector<IMovieBooker::CatalogChunk> chunks(1);
+        chunks.back().theaters = catalog.theaters;
+        std::size_t loaded = 0, pending = 0;
+        for (const auto &movie : catalog.movies)
+        {
+            chunks.back().movies.push_back(movie);
+            pending += movie.second.size();
+            if (pending >= std::max<std::size_t>(4096, loaded))
+            {
+                loaded += pending;
+                pending = 0;
+                chunks.emplace_back();
+            }
+        }
+        TimeLoads(state, [&](MovieBooker& booker) {
+            for (const auto &chunk : chunks)
+                booker.AddCatalog(chunk);
+        });
+        state.counters["chunks"] = static_cast<double>(chunks.size());
+    }
+    BENCHMARK(BM_IngestAddCatalogChunked)->Arg(1000000)->Unit(benchmark::kMillisecond);
+}
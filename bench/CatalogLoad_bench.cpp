@@ -0,0 +1,168 @@
+// Catalog load time and peak memory: RapidJSON DOM loader against the
+// streaming SAX loader (MovieDataLoader::LoadFromFile / StreamFromFile).
+//
+// Synthetic catalogs have 10000 theaters and 10000 showings per movie, with
+// capacities listed first. Both loaders add the same movies to the booker,
+// so the difference is parsing and the memory held while parsing.
+// "peak_rss_MB" is the growth of the peak resident set while one more load
+// runs in a forked child that first returned its free heap to the OS and
+// reset its high-water mark (Linux only), so earlier runs do not mask it.
+//
+// BM_LoadSplitCatalog loads the 1M showing catalog split over kParts files
+// (capacities in the first) with MovieDataLoader::LoadFiles on 1..8 threads.
+
+#include <benchmark/benchmark.h>
+#include <MovieDataLoader.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+    #include <fstream>
+    #include <malloc.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr unsigned int kTheaters = 10000;
+    constexpr unsigned int kShowingsPerMovie = 10000;
+    constexpr unsigned int kParts = 20;
+    constexpr std::int64_t kSplitShowings = 1000000;
+
+    std::string CatalogPath(std::int64_t showings)
+    {
+        return (std::filesystem::temp_directory_path() / ("movie_booker_bench_" + std::to_string(showings) + ".json")).string();
+    }
+
+    // movies [first, last), with the theater capacities if `theaters`
+    void WriteCatalog(const std::string& path, std::int64_t first, std::int64_t last, bool theaters)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        std::fputs("{\n  \"theaters\": [\n", file);
+        for (unsigned int t = 0; theaters && t < kTheaters; ++t)
+            std::fprintf(file, "    { \"name\": \"Theater %u\", \"seats\": %u }%s\n", t, 100 + t % 400, t + 1 < kTheaters ? "," : "");
+        std::fputs("  ],\n  \"movies\": [\n", file);
+        for (std::int64_t m = first; m < last; ++m)
+        {
+            std::fprintf(file, "    { \"title\": \"Movie %lld\", \"theaters\": [", static_cast<long long>(m));
+            for (unsigned int s = 0; s < kShowingsPerMovie; ++s)
+                std::fprintf(file, "%s\"Theater %u\"", s ? ", " : "", s);
+            std::fprintf(file, "] }%s\n", m + 1 < last ? "," : "");
+        }
+        std::fputs("  ]\n}\n", file);
+        std::fclose(file);
+    }
+
+    // the kSplitShowings catalog as kParts files; returns their paths
+    std::vector<std::string> SplitCatalog()
+    {
+        const auto dir = std::filesystem::temp_directory_path() / "movie_booker_bench_split";
+        const std::int64_t movies = kSplitShowings / kShowingsPerMovie;
+        if (!std::filesystem::exists(dir))
+        {
+            std::filesystem::create_directory(dir);
+            for (unsigned int p = 0; p < kParts; ++p)
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "part%03u.json", p);
+                WriteCatalog((dir / name).string(), movies * p / kParts, movies * (p + 1) / kParts, p == 0);
+            }
+        }
+        return MovieDataLoader::ExpandPaths(dir.string());
+    }
+
+    bool Load(const std::string& path, bool streaming, MovieBooker& booker)
+    {
+        return streaming ? MovieDataLoader::StreamFromFile(path, booker) : MovieDataLoader::LoadFromFile(path, booker);
+    }
+
+#ifdef __linux__
+    // a "VmRSS:" / "VmHWM:" line of /proc/self/status, in KB
+    long StatusKb(const std::string& field)
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.compare(0, field.size(), field) == 0)
+                return std::strtol(line.c_str() + field.size(), nullptr, 10);
+        return 0;
+    }
+
+    // peak RSS growth in MB of one load, measured in a child process
+    double PeakLoadRss(const std::string& path, bool streaming)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return 0;
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            malloc_trim(0);                             // pages freed by earlier runs would hide growth
+            std::ofstream("/proc/self/clear_refs") << "5";   // reset VmHWM to the current RSS
+            const long before = StatusKb("VmRSS:");
+            {
+                MovieBooker booker;
+                Load(path, streaming, booker);
+            }
+            const double mb = static_cast<double>(StatusKb("VmHWM:") - before) / 1024.0;
+            (void)!write(fds[1], &mb, sizeof(mb));
+            _exit(0);
+        }
+        close(fds[1]);
+        double mb = 0;
+        if (child < 0 || read(fds[0], &mb, sizeof(mb)) != static_cast<ssize_t>(sizeof(mb)))
+            mb = 0;
+        close(fds[0]);
+        if (child > 0)
+            waitpid(child, nullptr, 0);
+        return mb;
+    }
+#endif
+
+    void BM_LoadCatalog(benchmark::State& state, bool streaming)
+    {
+        const std::string path = CatalogPath(state.range(0));
+        if (!std::filesystem::exists(path))
+            WriteCatalog(path, 0, state.range(0) / kShowingsPerMovie, true);
+
+        for (auto _ : state)
+        {
+            auto booker = std::make_unique<MovieBooker>();
+            if (!Load(path, streaming, *booker))
+                state.SkipWithError("catalog not loaded");
+            state.PauseTiming();
+            booker.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["file_MB"] = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+#ifdef __linux__
+        state.counters["peak_rss_MB"] = PeakLoadRss(path, streaming);
+#endif
+    }
+    BENCHMARK_CAPTURE(BM_LoadCatalog, dom, false)->Arg(100000)->Arg(1000000)->Iterations(1)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_LoadCatalog, streaming, true)->Arg(100000)->Arg(1000000)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+    void BM_LoadSplitCatalog(benchmark::State& state)
+    {
+        const std::vector<std::string> paths = SplitCatalog();
+        const unsigned int threads = static_cast<unsigned int>(state.range(0));
+        for (auto _ : state)
+        {
+            auto booker = std::make_unique<MovieBooker>();
+            std::vector<CatalogLoadError> errors;
+            if (!MovieDataLoader::LoadFiles(paths, threads, *booker, errors))
+                state.SkipWithError("catalog not loaded");
+            state.PauseTiming();
+            booker.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * kSplitShowings);
+    }
+    BENCHMARK(BM_LoadSplitCatalog)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Iterations(3)->Unit(benchmark::kMillisecond);
+}
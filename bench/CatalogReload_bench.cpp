@@ -0,0 +1,131 @@
+// Catalog hot reload (MovieBooker::ReplaceCatalog): time of one reload, and
+// the latency of BookSeats calls made while reloads run back to back.
+//
+// Catalogs have 10 showings per movie over 1000 theaters, like the ingest
+// benchmark. Each reload alternates between two versions of the catalog
+// that differ in the last theater of every 100th movie, so 1% of showings
+// are removed and 1% added while the rest keep their seats.
+// BM_BookDuringReload books a single seat every 10 us from the benchmark
+// thread, for as long as a second thread takes to reload the 1M showing
+// catalog kReloads times (reload:1) or for a fixed 2 s (reload:0), and
+// reports the latency percentiles of those bookings.
+
+#include <benchmark/benchmark.h>
+#include <MovieBooker.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned int kTheaters = 1000;
+    constexpr unsigned int kShowingsPerMovie = 10;
+    constexpr unsigned int kSeats = 500;
+    constexpr std::size_t kReloads = 3;
+    constexpr std::chrono::microseconds kPace{ 10 };
+
+    // the catalog, with every 100th movie's last theater shifted if `variant`
+    IMovieBooker::CatalogChunk MakeCatalog(std::int64_t showings, bool variant)
+    {
+        IMovieBooker::CatalogChunk catalog;
+        for (unsigned int t = 0; t < kTheaters; ++t)
+            catalog.theaters.emplace_back("Theater " + std::to_string(t), kSeats);
+        for (std::int64_t m = 0; m < showings / kShowingsPerMovie; ++m)
+        {
+            std::vector<std::string> theaters;
+            for (unsigned int s = 0; s < kShowingsPerMovie; ++s)
+            {
+                const bool shifted = variant && m % 100 == 0 && s + 1 == kShowingsPerMovie;
+                theaters.push_back("Theater " + std::to_string((m + s * 97 + (shifted ? 1 : 0)) % kTheaters));
+            }
+            catalog.movies.emplace_back("Movie " + std::to_string(m), std::move(theaters));
+        }
+        return catalog;
+    }
+
+    void BM_ReplaceCatalog(benchmark::State& state)
+    {
+        const IMovieBooker::CatalogChunk versions[2] = { MakeCatalog(state.range(0), false), MakeCatalog(state.range(0), true) };
+        MovieBooker booker;
+        booker.AddCatalog(versions[0]);
+
+        std::size_t round = 0;
+        CatalogDiff diff;
+        for (auto _ : state)
+            booker.ReplaceCatalog(versions[++round % 2], &diff);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["changed"] = static_cast<double>(diff.added_showings + diff.removed_showings);
+        state.counters["kept"] = static_cast<double>(diff.kept_showings);
+    }
+    BENCHMARK(BM_ReplaceCatalog)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+    void BM_BookDuringReload(benchmark::State& state)
+    {
+        const IMovieBooker::CatalogChunk versions[2] = { MakeCatalog(1000000, false), MakeCatalog(1000000, true) };
+        const bool reload = state.range(0) != 0;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            MovieBooker booker;
+            booker.AddCatalog(versions[0]);
+            // showings no reload removes: movies 1..99 of every hundred
+            std::vector<IMovieBooker::ShowingId> showings;
+            for (int m = 1; m < 100; ++m)
+            {
+                const auto movie = *booker.ResolveMovie("Movie " + std::to_string(m));
+                for (const auto &theater : booker.GetTheaterList(movie))
+                    showings.push_back(*booker.ResolveShowing(movie, theater.first));
+            }
+
+            std::atomic<bool> stop{ false };
+            std::atomic<std::size_t> reloads{ 0 };
+            std::thread reloader;
+            if (reload)
+                reloader = std::thread([&]() {
+                    for (std::size_t round = 1; !stop.load(std::memory_order_relaxed); ++round)
+                    {
+                        booker.ReplaceCatalog(versions[round % 2]);
+                        reloads.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            state.ResumeTiming();
+
+            std::vector<double> latencies;
+            const std::size_t capacity = showings.size() * kSeats;
+            std::vector<unsigned int> seat(1);
+            const auto begin = std::chrono::steady_clock::now();
+            auto next = begin;
+            while (latencies.size() < capacity
+                   && (reload ? reloads.load(std::memory_order_relaxed) < kReloads : next - begin < std::chrono::seconds(2)))
+            {
+                while (std::chrono::steady_clock::now() < next)
+                    ;                                   // paced like independent clients, not back to back
+                next += kPace;
+                const std::size_t i = latencies.size();
+                seat[0] = static_cast<unsigned int>(i / showings.size()) + 1;
+                const auto start = std::chrono::steady_clock::now();
+                if (!booker.BookSeats(showings[i % showings.size()], seat))
+                    state.SkipWithError("booking failed");
+                latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            state.PauseTiming();
+            stop = true;
+            if (reloader.joinable())
+                reloader.join();
+            std::sort(latencies.begin(), latencies.end());
+            state.counters["p50_us"] = latencies[latencies.size() / 2];
+            state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+            state.counters["max_us"] = latencies.back();
+            state.counters["reloads"] = static_cast<double>(reloads.load());
+            state.counters["bookings"] = static_cast<double>(latencies.size());
+            state.ResumeTiming();
+        }
+    }
+    BENCHMARK(BM_BookDuringReload)->ArgName("reload")->Arg(0)->Arg(1)->Iterations(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
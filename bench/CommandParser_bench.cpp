@@ -0,0 +1,87 @@
+// Command line parsing: CommandParser against the stringstream parser it replaced.
+//
+// Both parse a "book_seats 1,2,3" line (the hot command) and a select_movie
+// line into reused output objects. The allocs/iter counter comes from the
+// counting operator new of AllocationCounter.cpp, which is why this suite is
+// its own executable (movie_booker_parser_bench); CommandParser is expected
+// to report 0.
+
+#include <benchmark/benchmark.h>
+#include <CommandParser.hpp>
+#include "AllocationCounter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // the parser tcp_connection::handle_read_end used before CommandParser
+    void LegacyParse(const std::string& line, std::string& argument, std::vector<unsigned int>& seats)
+    {
+        std::stringstream stream(line, std::ios::in);
+        std::string command;
+        if (!(stream >> command))
+            return;
+        std::transform(command.begin(), command.end(), command.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (command == "book_seats")
+        {
+            long seat = 0;
+            seats.clear();
+            stream >> std::ws;
+            while (stream >> seat)
+            {
+                seats.push_back(static_cast<unsigned int>(seat));
+                if (stream.peek() == ',')
+                    stream.ignore(1);
+                else
+                    break;
+            }
+        }
+        else if (command == "select_movie")
+        {
+            stream >> std::ws;
+            std::getline(stream, argument);
+        }
+    }
+
+    void Parse(const std::string& line, std::string& argument, std::vector<unsigned int>& seats)
+    {
+        ParsedCommand parsed = CommandParser::Parse(line);
+        if (parsed.command == Command::BookSeats)
+            CommandParser::ParseSeats(parsed.argument, 20, seats);
+        else if (parsed.command == Command::SelectMovie)
+            argument.assign(parsed.argument);
+    }
+
+    template <void (*ParseFn)(const std::string&, std::string&, std::vector<unsigned int>&)>
+    void ParseLine(benchmark::State& state, const char* text)
+    {
+        const std::string line(text);
+        std::string argument;
+        argument.reserve(64);
+        std::vector<unsigned int> seats;
+        seats.reserve(64);
+
+        const std::size_t before = AllocationCount();
+        for (auto _ : state)
+        {
+            ParseFn(line, argument, seats);
+            benchmark::DoNotOptimize(seats.data());
+            benchmark::DoNotOptimize(argument.data());
+        }
+        const std::size_t allocations = AllocationCount() - before;
+        state.counters["allocs/iter"] = static_cast<double>(allocations) / static_cast<double>(state.iterations());
+    }
+
+    void StringStreamParser(benchmark::State& state, const char* text) { ParseLine<LegacyParse>(state, text); }
+    void ViewParser(benchmark::State& state, const char* text) { ParseLine<Parse>(state, text); }
+}
+
+BENCHMARK_CAPTURE(StringStreamParser, book_seats, "book_seats 1,2,3\r");
+BENCHMARK_CAPTURE(ViewParser, book_seats, "book_seats 1,2,3\r");
+BENCHMARK_CAPTURE(StringStreamParser, select_movie, "select_movie The Matrix Reloaded\r");
+BENCHMARK_CAPTURE(ViewParser, select_movie, "select_movie The Matrix Reloaded\r");
@@ -0,0 +1,72 @@
+// Free-seat enumeration for small, medium and arena sized theaters.
+//
+// GetFreeSeats goes through MovieBooker by showing id (the server's hot path)
+// on an empty hall and on a half-sold hall with a random seat pattern. The
+// VectorBool variant is the bit-by-bit scan the booker used before seat
+// bitmaps, kept as the baseline.
+
+#include <benchmark/benchmark.h>
+#include <MovieBooker.hpp>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // books roughly `percent` % of the seats of `showing` in a reproducible pattern
+    void Fill(MovieBooker& booker, IMovieBooker::ShowingId showing, std::size_t seats, unsigned int percent)
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<unsigned int> roll(0, 99);
+        std::vector<unsigned int> ids;
+        for (unsigned int id = 1; id <= seats; ++id)
+            if (roll(rng) < percent)
+                ids.push_back(id);
+        if (!ids.empty())
+            booker.BookSeats(showing, ids);
+    }
+
+    void GetFreeSeats(benchmark::State& state)
+    {
+        const std::size_t seats = static_cast<std::size_t>(state.range(0));
+        const unsigned int soldPercent = static_cast<unsigned int>(state.range(1));
+
+        MovieBooker booker;
+        booker.AddTheater("Hall", seats);
+        booker.AddMovie("M", {"Hall"});
+        auto showing = *booker.ResolveShowing(*booker.ResolveMovie("M"), *booker.ResolveTheater("Hall"));
+        Fill(booker, showing, seats, soldPercent);
+
+        for (auto _ : state)
+        {
+            auto free = booker.GetFreeSeats(showing);
+            benchmark::DoNotOptimize(free.data());
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(seats));
+    }
+
+    void VectorBoolScan(benchmark::State& state)
+    {
+        const std::size_t seats = static_cast<std::size_t>(state.range(0));
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<unsigned int> roll(0, 99);
+        std::vector<bool> booked(seats);
+        for (std::size_t i = 0; i < seats; ++i)
+            booked[i] = roll(rng) < static_cast<unsigned int>(state.range(1));
+
+        for (auto _ : state)
+        {
+            std::vector<unsigned int> free;
+            free.reserve(seats);
+            for (std::size_t i = 0; i < seats; ++i)
+                if (!booked[i])
+                    free.push_back(static_cast<unsigned int>(i + 1));
+            benchmark::DoNotOptimize(free.data());
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(seats));
+    }
+}
+
+// small theater, medium hall, arena; empty and half sold
+BENCHMARK(GetFreeSeats)->ArgsProduct({ { 20, 500, 2000, 20000 }, { 0, 50 } })->ArgNames({ "seats", "sold%" });
+BENCHMARK(VectorBoolScan)->ArgsProduct({ { 20, 500, 2000, 20000 }, { 0, 50 } })->ArgNames({ "seats", "sold%" });
@@ -0,0 +1,93 @@
+// list_movies / list_theaters reply cost: building the reply from the
+// booker on every request (copy every title out, then concatenate) against
+// taking the shared buffer of a ListingCache, on catalogs of 30, 1k and 100k
+// movies with 10 theaters each, from 1 to all hardware threads.
+
+#include <benchmark/benchmark.h>
+#include <ListingCache.hpp>
+#include <MovieBooker.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr int kTheatersPerMovie = 10;
+
+    const int kMaxThreads = static_cast<int>(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1);
+
+    struct Listings
+    {
+        MovieBooker booker;
+        ListingCache cache{ booker };
+        std::string movie;                  // a movie in the middle of the catalog
+        IMovieBooker::MovieId id = 0;
+    };
+
+    std::mutex listings_mutex;
+    std::map<std::int64_t, std::unique_ptr<Listings>> listings;     // by movie count
+
+    Listings& GetListings(std::int64_t movies)
+    {
+        std::lock_guard<std::mutex> lock(listings_mutex);
+        std::unique_ptr<Listings> &entry = listings[movies];
+        if (entry)
+            return *entry;
+
+        entry = std::make_unique<Listings>();
+        IMovieBooker::CatalogChunk chunk;
+        for (int t = 0; t < 100; ++t)
+            chunk.theaters.emplace_back("Theater " + std::to_string(t), 200);
+        for (std::int64_t m = 0; m < movies; ++m)
+        {
+            std::vector<std::string> theaters;
+            for (int s = 0; s < kTheatersPerMovie; ++s)
+                theaters.push_back("Theater " + std::to_string((m + s * 7) % 100));
+            chunk.movies.emplace_back("Movie " + std::to_string(m), theaters);
+        }
+        entry->booker.AddCatalog(chunk);
+        entry->movie = "Movie " + std::to_string(movies / 2);
+        entry->id = *entry->booker.ResolveMovie(entry->movie);
+        return *entry;
+    }
+
+    void BM_ListMovies(benchmark::State& state, bool cached)
+    {
+        Listings &l = GetListings(state.range(0));
+        for (auto _ : state)
+        {
+            if (cached)
+                benchmark::DoNotOptimize(l.cache.Movies());
+            else
+                benchmark::DoNotOptimize(ListingCache::Format(l.booker.GetMovies(), "No movies running\n"));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_ListTheaters(benchmark::State& state, bool cached)
+    {
+        Listings &l = GetListings(state.range(0));
+        for (auto _ : state)
+        {
+            if (cached)
+                benchmark::DoNotOptimize(l.cache.Theaters(l.id));
+            else
+                benchmark::DoNotOptimize(ListingCache::Format(l.booker.GetTheatersForMovie(l.movie), "Movie is not running in any theater\n"));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void Sizes(benchmark::internal::Benchmark* b)
+    {
+        b->Arg(30)->Arg(1000)->Arg(100000)->ArgName("movies")->ThreadRange(1, kMaxThreads)->UseRealTime();
+    }
+}
+
+BENCHMARK_CAPTURE(BM_ListMovies, build, false)->Apply(Sizes);
+BENCHMARK_CAPTURE(BM_ListMovies, cached, true)->Apply(Sizes);
+BENCHMARK_CAPTURE(BM_ListTheaters, build, false)->Apply(Sizes);
+BENCHMARK_CAPTURE(BM_ListTheaters, cached, true)->Apply(Sizes);
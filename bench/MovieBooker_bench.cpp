@@ -0,0 +1,213 @@
+// MovieBooker API under contention: AddMovie, GetMovies, GetTheatersForMovie,
+// GetFreeSeats and BookSeats from 1 to all hardware threads, on catalogs of
+// 30, 10k and 1M showings, with every showing (or movie) equally popular
+// (zipf:0) or Zipf-distributed with exponent 1 (zipf:1), where the first
+// few showings take most of the traffic.
+//
+// Catalogs have 10 showings per movie and 500 seats per theater; each size
+// is built once and shared by the read benchmarks and threads. Targets are
+// drawn before the timed loop. GetFreeSeats and BookSeats run through both
+// the string API (IMovieBooker's names) and showing ids (the server's path).
+// Every BookSeats run starts on an unbooked catalog of its own and books two
+// random adjacent seats per call, so as showings fill a growing share of
+// attempts fails like it would during an on-sale (small catalogs sell out
+// early in the run); the booked% counter gives the mix. AddMovie re-adds a
+// movie with the theaters it already has: the full copy and publish of the
+// catalog a new movie costs, without growing it.
+//
+// Compare builds with the JSON output, e.g.
+//   movie_booker_bench --benchmark_filter=MovieBooker/ --benchmark_out=before.json --benchmark_out_format=json
+// and Google Benchmark's tools/compare.py benchmarks before.json after.json.
+
+#include <benchmark/benchmark.h>
+#include <MovieBooker.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned int kShowingsPerMovie = 10;
+    constexpr unsigned int kSeats = 500;
+    constexpr std::size_t kPicks = 1u << 16;        // targets drawn per thread, used round robin
+
+    const int kMaxThreads = static_cast<int>(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1);
+
+    struct Catalog
+    {
+        MovieBooker booker;
+        std::vector<std::string> movies;
+        std::vector<std::vector<std::string>> theaters;                 // per movie
+        std::vector<std::pair<std::string, std::string>> showings;      // (movie, theater), most popular first
+        std::vector<IMovieBooker::ShowingId> ids;                       // per showing
+    };
+
+    std::mutex catalogs_mutex;
+    std::map<std::pair<std::int64_t, bool>, std::unique_ptr<Catalog>> catalogs;     // by size, for bookings
+
+    // catalog of `showings` showings, built on first use; `bookings` gets the one BookSeats writes to
+    Catalog& GetCatalog(std::int64_t showings, bool bookings = false)
+    {
+        std::lock_guard<std::mutex> lock(catalogs_mutex);
+        std::unique_ptr<Catalog> &catalog = catalogs[{ showings, bookings }];
+        if (catalog)
+            return *catalog;
+
+        catalog = std::make_unique<Catalog>();
+        const std::int64_t movies = showings / kShowingsPerMovie;
+        const std::int64_t theaters = std::min<std::int64_t>(1000, std::max<std::int64_t>(kShowingsPerMovie, movies));
+        IMovieBooker::CatalogChunk chunk;
+        for (std::int64_t t = 0; t < theaters; ++t)
+            chunk.theaters.emplace_back("Theater " + std::to_string(t), kSeats);
+        for (std::int64_t m = 0; m < movies; ++m)
+        {
+            catalog->movies.push_back("Movie " + std::to_string(m));
+            catalog->theaters.emplace_back();
+            for (unsigned int s = 0; s < kShowingsPerMovie; ++s)
+                catalog->theaters.back().push_back("Theater " + std::to_string((m + s * 97) % theaters));
+            chunk.movies.emplace_back(catalog->movies.back(), catalog->theaters.back());
+        }
+        catalog->booker.AddCatalog(chunk);
+
+        // rank showings movie by movie, so popular showings also make popular movies
+        for (std::int64_t m = 0; m < movies; ++m)
+        {
+            const auto movie = *catalog->booker.ResolveMovie(catalog->movies[m]);
+            for (const auto &theater : catalog->theaters[m])
+            {
+                catalog->showings.emplace_back(catalog->movies[m], theater);
+                catalog->ids.push_back(*catalog->booker.ResolveShowing(movie, *catalog->booker.ResolveTheater(theater)));
+            }
+        }
+        return *catalog;
+    }
+
+    // kPicks indices below `n`: uniform, or item r drawn with weight 1 / (r + 1)
+    std::vector<std::uint32_t> Picks(std::size_t n, bool zipf, std::uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::vector<std::uint32_t> picks(kPicks);
+        if (!zipf)
+        {
+            std::uniform_int_distribution<std::uint32_t> pick(0, static_cast<std::uint32_t>(n - 1));
+            for (auto &p : picks)
+                p = pick(rng);
+            return picks;
+        }
+        std::vector<double> cdf(n);
+        double total = 0.0;
+        for (std::size_t r = 0; r < n; ++r)
+            cdf[r] = total += 1.0 / static_cast<double>(r + 1);
+        std::uniform_real_distribution<double> roll(0.0, total);
+        for (auto &p : picks)
+            p = static_cast<std::uint32_t>(std::min<std::size_t>(std::upper_bound(cdf.begin(), cdf.end(), roll(rng)) - cdf.begin(), n - 1));
+        return picks;
+    }
+
+    std::vector<std::uint32_t> ThreadPicks(const benchmark::State& state, std::size_t n)
+    {
+        return Picks(n, state.range(1) != 0, 1000 + static_cast<std::uint64_t>(state.thread_index()));
+    }
+
+    void AddMovie(benchmark::State& state)
+    {
+        Catalog &catalog = GetCatalog(state.range(0));
+        const auto picks = ThreadPicks(state, catalog.movies.size());
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::uint32_t m = picks[i++ % kPicks];
+            benchmark::DoNotOptimize(catalog.booker.AddMovie(catalog.movies[m], catalog.theaters[m]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void GetMovies(benchmark::State& state)
+    {
+        Catalog &catalog = GetCatalog(state.range(0));
+        for (auto _ : state)
+            benchmark::DoNotOptimize(catalog.booker.GetMovies());
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void GetTheatersForMovie(benchmark::State& state)
+    {
+        Catalog &catalog = GetCatalog(state.range(0));
+        const auto picks = ThreadPicks(state, catalog.movies.size());
+        std::size_t i = 0;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(catalog.booker.GetTheatersForMovie(catalog.movies[picks[i++ % kPicks]]));
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void GetFreeSeats(benchmark::State& state, bool byId)
+    {
+        Catalog &catalog = GetCatalog(state.range(0));
+        const auto picks = ThreadPicks(state, catalog.showings.size());
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::uint32_t s = picks[i++ % kPicks];
+            if (byId)
+                benchmark::DoNotOptimize(catalog.booker.GetFreeSeats(catalog.ids[s]));
+            else
+                benchmark::DoNotOptimize(catalog.booker.GetFreeSeats(catalog.showings[s].second, catalog.showings[s].first));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // runs before the threads of a BookSeats run start
+    void DropBookedCatalog(const benchmark::State& state)
+    {
+        std::lock_guard<std::mutex> lock(catalogs_mutex);
+        catalogs.erase({ state.range(0), true });
+    }
+
+    void BookSeats(benchmark::State& state, bool byId)
+    {
+        Catalog &catalog = GetCatalog(state.range(0), true);
+        const auto picks = ThreadPicks(state, catalog.showings.size());
+        std::mt19937 rng(static_cast<std::uint32_t>(state.thread_index()));
+        std::uniform_int_distribution<unsigned int> first(1, kSeats - 1);
+        std::vector<unsigned int> seats(2);
+        std::size_t i = 0;
+        std::int64_t booked = 0;
+        for (auto _ : state)
+        {
+            const std::uint32_t s = picks[i++ % kPicks];
+            seats[0] = first(rng);
+            seats[1] = seats[0] + 1;
+            booked += byId ? catalog.booker.BookSeats(catalog.ids[s], seats)
+                           : catalog.booker.BookSeats(catalog.showings[s].second, catalog.showings[s].first, seats);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["booked%"] = benchmark::Counter(100.0 * static_cast<double>(booked) / static_cast<double>(state.iterations()),
+                                                       benchmark::Counter::kAvgThreads);
+    }
+
+    // every benchmark over catalog size x popularity, 1 to all threads
+    void Sweep(benchmark::internal::Benchmark* b)
+    {
+        b->ArgsProduct({ { 30, 10000, 1000000 }, { 0, 1 } })->ArgNames({ "showings", "zipf" })
+            ->ThreadRange(1, kMaxThreads)->UseRealTime();
+    }
+}
+
+BENCHMARK(GetMovies)->Name("MovieBooker/GetMovies")->Apply([](benchmark::internal::Benchmark* b) {
+    // popularity does not matter to a full listing
+    b->ArgsProduct({ { 30, 10000, 1000000 }, { 0 } })->ArgNames({ "showings", "zipf" })->ThreadRange(1, kMaxThreads)->UseRealTime();
+});
+BENCHMARK(GetTheatersForMovie)->Name("MovieBooker/GetTheatersForMovie")->Apply(Sweep);
+BENCHMARK_CAPTURE(GetFreeSeats, by_name, false)->Name("MovieBooker/GetFreeSeats/by_name")->Apply(Sweep);
+BENCHMARK_CAPTURE(GetFreeSeats, by_id, true)->Name("MovieBooker/GetFreeSeats/by_id")->Apply(Sweep);
+BENCHMARK_CAPTURE(BookSeats, by_name, false)->Name("MovieBooker/BookSeats/by_name")->Apply(Sweep)->Setup(DropBookedCatalog);
+BENCHMARK_CAPTURE(BookSeats, by_id, true)->Name("MovieBooker/BookSeats/by_id")->Apply(Sweep)->Setup(DropBookedCatalog);
+BENCHMARK(AddMovie)->Name("MovieBooker/AddMovie")->Apply(Sweep);
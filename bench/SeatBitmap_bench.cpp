@@ -0,0 +1,185 @@
+// Contention benchmark: lock-free SeatBitmap vs. the previous mutex-protected std::vector<bool>.
+//
+// Every thread books a pair of seats picked from a hot range of the same
+// showing and then frees them again, so the showing never fills up and all
+// threads keep competing for the same words. The mixed variant adds the
+// free-seat queries a client issues before booking. The group variants book
+// four adjacent seats either the way a client does it (fetch free seats,
+// pick, book, retry on a lost race) or with one ClaimBest call.
+
+#include <benchmark/benchmark.h>
+#include <SeatBitmap.hpp>
+
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The seat store MovieBooker::TheaterEntry used before SeatBitmap, kept here as the baseline.
+    class MutexSeats
+    {
+    public:
+        explicit MutexSeats(std::size_t seats) : seats_(seats, false) {}
+
+        bool TryClaim(const unsigned int* ids, std::size_t count)
+        {
+            std::set<unsigned int> unique;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (ids[i] == 0 || ids[i] > seats_.size())
+                    return false;
+                unique.insert(ids[i]);
+            }
+            if (unique.size() != count)
+                return false;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t i = 0; i < count; ++i)
+                if (seats_[ids[i] - 1])
+                    return false;
+            for (std::size_t i = 0; i < count; ++i)
+                seats_[ids[i] - 1] = true;
+            return true;
+        }
+
+        void Release(const unsigned int* ids, std::size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t i = 0; i < count; ++i)
+                seats_[ids[i] - 1] = false;
+        }
+
+        void CollectFree(std::vector<unsigned int>& out)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t i = 0; i < seats_.size(); ++i)
+                if (!seats_[i])
+                    out.push_back(static_cast<unsigned int>(i + 1));
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<bool> seats_;
+    };
+
+    constexpr std::size_t kSeats = 20;          // today's theater size: a single bitmap word
+
+    template <typename Seats>
+    std::unique_ptr<Seats> shared_seats;
+
+    template <typename Seats>
+    void BookRelease(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+            shared_seats<Seats> = std::make_unique<Seats>(kSeats);
+
+        std::mt19937 rng(static_cast<unsigned int>(state.thread_index()) + 1);
+        std::uniform_int_distribution<unsigned int> seat(1, kSeats - 1);
+        std::int64_t booked = 0;
+
+        for (auto _ : state)
+        {
+            unsigned int s = seat(rng);
+            const unsigned int ids[] = { s, s + 1 };
+            if (shared_seats<Seats>->TryClaim(ids, 2))
+            {
+                ++booked;
+                shared_seats<Seats>->Release(ids, 2);
+            }
+        }
+        state.counters["booked"] = benchmark::Counter(static_cast<double>(booked), benchmark::Counter::kIsRate);
+    }
+
+    template <typename Seats>
+    void Mixed(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+            shared_seats<Seats> = std::make_unique<Seats>(kSeats);
+
+        std::mt19937 rng(static_cast<unsigned int>(state.thread_index()) + 1);
+        std::uniform_int_distribution<unsigned int> seat(1, kSeats);
+        std::vector<unsigned int> free;
+        free.reserve(kSeats);
+        unsigned int n = 0;
+
+        for (auto _ : state)
+        {
+            if (++n % 10)                                   // 9 reads per booking attempt
+            {
+                free.clear();
+                shared_seats<Seats>->CollectFree(free);
+                benchmark::DoNotOptimize(free.data());
+            }
+            else
+            {
+                const unsigned int ids[] = { seat(rng) };
+                if (shared_seats<Seats>->TryClaim(ids, 1))
+                    shared_seats<Seats>->Release(ids, 1);
+            }
+        }
+    }
+
+    constexpr std::size_t kGroupSeats = 256;
+    constexpr std::size_t kGroupSize = 4;
+
+    std::unique_ptr<SeatBitmap> group_seats;
+
+    // client-side selection: first run of kGroupSize adjacent seats in the free list
+    void GroupPickAndRetry(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+            group_seats = std::make_unique<SeatBitmap>(kGroupSeats);
+
+        std::vector<unsigned int> free;
+        free.reserve(kGroupSeats);
+        std::int64_t attempts = 0;
+        for (auto _ : state)
+        {
+            while (true)
+            {
+                ++attempts;
+                free.clear();
+                group_seats->CollectFree(free);
+                std::size_t start = 0;
+                for (std::size_t i = 1; i < free.size() && i - start + 1 < kGroupSize; ++i)
+                    if (free[i] != free[i - 1] + 1)
+                        start = i;
+                if (free.size() < start + kGroupSize)
+                    continue;
+                if (group_seats->TryClaim(&free[start], kGroupSize))
+                {
+                    group_seats->Release(&free[start], kGroupSize);
+                    break;
+                }
+            }
+        }
+        state.counters["attempts"] = benchmark::Counter(static_cast<double>(attempts), benchmark::Counter::kAvgIterations);
+    }
+
+    void GroupClaimBest(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+            group_seats = std::make_unique<SeatBitmap>(kGroupSeats);
+
+        std::vector<unsigned int> best;
+        best.reserve(kGroupSize);
+        for (auto _ : state)
+        {
+            if (group_seats->ClaimBest(kGroupSize, true, best))
+                group_seats->Release(best.data(), best.size());
+        }
+    }
+
+    const int kMaxThreads = static_cast<int>(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1);
+}
+
+BENCHMARK_TEMPLATE(BookRelease, MutexSeats)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK_TEMPLATE(BookRelease, SeatBitmap)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK_TEMPLATE(Mixed, MutexSeats)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK_TEMPLATE(Mixed, SeatBitmap)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK(GroupPickAndRetry)->ThreadRange(1, kMaxThreads)->UseRealTime();
+BENCHMARK(GroupClaimBest)->ThreadRange(1, kMaxThreads)->UseRealTime();
@@ -0,0 +1,83 @@
+// Cost of ServerMetrics on the request path: what the server adds per
+// book_seats (CountCommand, the sampled clock reads and RecordLatency, the
+// booking outcome). BM_Instrument runs just that, with every command timed
+// (sample:1) or the default sampling, from 1 to 4 threads sharing one
+// ServerMetrics. BM_BookSeats runs a single-seat BookSeats with and without
+// it, for scale.
+
+#include <benchmark/benchmark.h>
+#include <MovieBooker.hpp>
+#include <ServerMetrics.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t kSeats = 1u << 20;
+
+    // what handle_command adds around one booking command
+    template <typename Body>
+    void Instrumented(ServerMetrics& metrics, Body&& body)
+    {
+        if (!metrics.CountCommand(Command::BookSeats))
+        {
+            metrics.CountBooking(body());
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        metrics.CountBooking(body());
+        metrics.RecordLatency(Command::BookSeats, std::chrono::steady_clock::now() - start);
+    }
+
+    void BM_Instrument(benchmark::State& state)
+    {
+        static std::unique_ptr<ServerMetrics> metrics;
+        if (state.thread_index() == 0)
+            metrics = std::make_unique<ServerMetrics>(static_cast<std::uint32_t>(state.range(0)));
+        for (auto _ : state)
+            Instrumented(*metrics, []() { return true; });      // the other threads see it once the loop starts
+        state.SetItemsProcessed(state.iterations());
+        if (state.thread_index() == 0)
+            state.counters["samples"] = static_cast<double>(metrics->Snapshot().commands[static_cast<std::size_t>(Command::BookSeats)].samples);
+    }
+    BENCHMARK(BM_Instrument)->ArgName("sample")->Arg(1)->Arg(ServerMetrics::kDefaultLatencySample)->ThreadRange(1, 4);
+
+    struct Showing
+    {
+        MovieBooker booker;
+        IMovieBooker::ShowingId id = 0;
+
+        Showing()
+        {
+            booker.AddTheater("Hall", kSeats);
+            booker.AddMovie("Film", { "Hall" });
+            id = *booker.ResolveShowing(*booker.ResolveMovie("Film"), *booker.ResolveTheater("Hall"));
+        }
+    };
+
+    void BM_BookSeats(benchmark::State& state)
+    {
+        const bool instrumented = state.range(0) != 0;
+        ServerMetrics metrics;
+        auto showing = std::make_unique<Showing>();
+        std::vector<unsigned int> seat(1, 0);
+        for (auto _ : state)
+        {
+            if (++seat[0] > kSeats)
+            {
+                state.PauseTiming();                    // sold out: start over on an empty showing
+                showing = std::make_unique<Showing>();
+                seat[0] = 1;
+                state.ResumeTiming();
+            }
+            if (instrumented)
+                Instrumented(metrics, [&]() { return showing->booker.BookSeats(showing->id, seat); });
+            else
+                benchmark::DoNotOptimize(showing->booker.BookSeats(showing->id, seat));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_BookSeats)->ArgName("metrics")->Arg(0)->Arg(1);
+}
@@ -0,0 +1,137 @@
+// Restart cost: rebuilding the catalog through AddMovie (what the JSON
+// loader does after parsing) against MovieBooker::LoadSnapshot.
+//
+// The catalog has one movie per 10 showings over 1000 theaters. AddMovie
+// copies the catalog for every movie, so it grows quadratically and is only
+// run up to 10k showings; the snapshot is mapped and built in one pass.
+// Snapshots are generated directly in the CatalogSnapshot.hpp layout so
+// the large ones need no catalog to be built first.
+
+#include <benchmark/benchmark.h>
+#include <CatalogSnapshot.hpp>
+#include <MovieBooker.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::uint32_t kTheaters = 1000;
+    constexpr std::uint32_t kShowingsPerMovie = 10;
+    constexpr std::uint32_t kSeats = 200;
+
+    std::string SnapshotPath()
+    {
+        return (std::filesystem::temp_directory_path() / "movie_booker_bench.snap").string();
+    }
+
+    std::string TheaterName(std::uint32_t t) { return "Theater " + std::to_string(t); }
+    std::string MovieName(std::uint32_t m) { return "Movie " + std::to_string(m); }
+
+    // write a snapshot of `showingCount` showings with every 3rd seat booked
+    void WriteSyntheticSnapshot(const std::string& path, std::uint32_t showingCount)
+    {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+        header.byte_order = kSnapshotByteOrder;
+        header.theater_count = kTheaters;
+        header.movie_count = showingCount / kShowingsPerMovie;
+        header.showing_count = showingCount;
+
+        std::string strings;
+        std::vector<SnapshotTheater> theaters;
+        for (std::uint32_t t = 0; t < kTheaters; ++t)
+        {
+            const std::string name = TheaterName(t);
+            theaters.push_back({ strings.size(), static_cast<std::uint32_t>(name.size()), kSeats });
+            strings += name;
+        }
+        std::vector<SnapshotMovie> movies;
+        std::vector<SnapshotShowing> showings;
+        const std::uint64_t wordsPerShowing = (kSeats + 63) / 64;
+        for (std::uint32_t m = 0; m < header.movie_count; ++m)
+        {
+            const std::string name = MovieName(m);
+            movies.push_back({ strings.size(), static_cast<std::uint32_t>(name.size()), 0 });
+            strings += name;
+            for (std::uint32_t s = 0; s < kShowingsPerMovie; ++s)
+                showings.push_back({ m, (m + s * 97) % kTheaters, showings.size() * wordsPerShowing });
+        }
+        header.word_count = showings.size() * wordsPerShowing;
+        header.string_bytes = strings.size();
+
+        std::vector<std::uint64_t> words(wordsPerShowing, 0x4924924924924924ull);   // every 3rd seat
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fwrite(theaters.data(), sizeof(SnapshotTheater), theaters.size(), file);
+        std::fwrite(movies.data(), sizeof(SnapshotMovie), movies.size(), file);
+        std::fwrite(showings.data(), sizeof(SnapshotShowing), showings.size(), file);
+        for (std::size_t i = 0; i < showings.size(); ++i)
+            std::fwrite(words.data(), sizeof(std::uint64_t), words.size(), file);
+        std::fwrite(strings.data(), 1, strings.size(), file);
+        std::fclose(file);
+    }
+
+    void BM_RestartAddMovie(benchmark::State& state)
+    {
+        const auto showingCount = static_cast<std::uint32_t>(state.range(0));
+        std::vector<std::vector<std::string>> theaters(showingCount / kShowingsPerMovie);
+        for (std::uint32_t m = 0; m < theaters.size(); ++m)
+            for (std::uint32_t s = 0; s < kShowingsPerMovie; ++s)
+                theaters[m].push_back(TheaterName((m + s * 97) % kTheaters));
+
+        for (auto _ : state)
+        {
+            auto booker = std::make_unique<MovieBooker>();
+            for (std::uint32_t t = 0; t < kTheaters; ++t)
+                booker->AddTheater(TheaterName(t), kSeats);
+            for (std::uint32_t m = 0; m < theaters.size(); ++m)
+                booker->AddMovie(MovieName(m), theaters[m]);
+            benchmark::DoNotOptimize(booker->GetCatalogVersion());
+            state.PauseTiming();                        // teardown is not part of a restart
+            booker.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * showingCount);
+    }
+    BENCHMARK(BM_RestartAddMovie)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+    void BM_RestartSnapshot(benchmark::State& state)
+    {
+        const auto showingCount = static_cast<std::uint32_t>(state.range(0));
+        WriteSyntheticSnapshot(SnapshotPath(), showingCount);
+        for (auto _ : state)
+        {
+            auto booker = std::make_unique<MovieBooker>();
+            std::uint64_t offset = 0;
+            if (!booker->LoadSnapshot(SnapshotPath(), offset))
+                state.SkipWithError("snapshot refused");
+            benchmark::DoNotOptimize(booker->GetCatalogVersion());
+            state.PauseTiming();                        // teardown is not part of a restart
+            booker.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * showingCount);
+        std::filesystem::remove(SnapshotPath());
+    }
+    BENCHMARK(BM_RestartSnapshot)->Arg(1000)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+    void BM_WriteSnapshot(benchmark::State& state)
+    {
+        const auto showingCount = static_cast<std::uint32_t>(state.range(0));
+        WriteSyntheticSnapshot(SnapshotPath(), showingCount);
+        MovieBooker booker;
+        std::uint64_t offset = 0;
+        booker.LoadSnapshot(SnapshotPath(), offset);
+        for (auto _ : state)
+            benchmark::DoNotOptimize(booker.WriteSnapshot(SnapshotPath(), 0));
+        state.SetItemsProcessed(state.iterations() * showingCount);
+        state.counters["bytes"] = static_cast<double>(std::filesystem::file_size(SnapshotPath()));
+        std::filesystem::remove(SnapshotPath());
+    }
+    BENCHMARK(BM_WriteSnapshot)->Arg(1000000)->Unit(benchmark::kMillisecond);
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include <boost/asio.hpp>
+#include <BinaryProtocol.hpp>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 // A syncronous TCP client modelled after the Boost.Asio examples
 
@@ -16,6 +20,12 @@
  *   std::string resp = c.ReadLine();
  * }
  * @endcode
+ *
+ * After EnterBinaryMode() the session uses the frames of `BinaryProtocol.hpp`
+ * through Request() and the typed helpers instead of text lines.
+ *
+ * Each call blocks for a round trip; AsyncClient and AsyncClientPool
+ * (`AsyncClient.hpp`) pipeline text commands without blocking.
  */
 class AsioClient
 {
@@ -57,8 +67,50 @@ public:
 	 */
 	void WriteLine(const std::string& msg);
 
+	/**
+	 * @brief Switch the session to binary frames.
+	 *
+	 * Sends "binary" and skips text lines (e.g. the greeting) until the server
+	 * confirms with "OK binary".
+	 * @return true once the server has switched.
+	 */
+	bool EnterBinaryMode();
+
+	/**
+	 * @brief Send one binary request and wait for its response (blocking).
+	 * @param opcode Request opcode.
+	 * @param payload Request payload.
+	 * @param response Receives the response payload.
+	 * @return The response status; FrameStatus::ConnectionError if the exchange failed.
+	 */
+	FrameStatus Request(Opcode opcode, const std::string& payload, std::string& response);
+
+	/**
+	 * @brief Binary ListMovies: fill `movies` with (movie id, title) pairs.
+	 */
+	FrameStatus ListMovies(std::vector<std::pair<std::uint32_t, std::string>>& movies);
+
+	/**
+	 * @brief Binary ListTheaters: fill `theaters` with (theater id, name) pairs for a movie.
+	 */
+	FrameStatus ListTheaters(std::uint32_t movie, std::vector<std::pair<std::uint32_t, std::string>>& theaters);
+
+	/**
+	 * @brief Binary GetFreeSeats: fill `seats` with the 1-based free seats of a showing.
+	 */
+	FrameStatus GetFreeSeats(std::uint32_t movie, std::uint32_t theater, std::vector<unsigned int>& seats);
+
+	/**
+	 * @brief Binary BookSeats: book the 1-based `seats` of a showing, all or nothing.
+	 */
+	FrameStatus BookSeats(std::uint32_t movie, std::uint32_t theater, const std::vector<unsigned int>& seats);
+
 private:
-	
+	// read one line into `line`, without its line ending; false on error/EOF
+	bool read_line(std::string& line);
+
 	boost::asio::io_context io_context_;
 	boost::asio::ip::tcp::socket socket_;
+	boost::asio::streambuf read_buffer_;	// bytes read past the last line or frame are kept for the next read
+	std::uint32_t next_request_id_ = 1;
 };
\ No newline at end of file
@@ -1,7 +1,19 @@
 #pragma once
 #include <boost/asio.hpp>
+#include <chrono>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <IMovieBooker.hpp>
+#include <BinaryProtocol.hpp>
+#include <ServerMetrics.hpp>
+#include <ListingCache.hpp>
 
 /// Simple implementation of an async IO server that accepts movie booking commands, modelled after the Boost.Asio examples
 /**
@@ -10,10 +22,13 @@
  *
  * The server is modeled after the Boost.Asio examples and exposes a small set
  * of text commands (list_movies, select_movie, list_theaters, select_theater,
- * book_seats) which are delegated to an `IMovieBooker` implementation.
+ * book_seats, book_best, book_batch, hold_seats, confirm_hold, release_hold) which are
+ * delegated to an `IMovieBooker` implementation, plus "stats" for the
+ * server's own metrics.
  */
 
 
+class connection_registry;
 
 /**
  * @class tcp_connection
@@ -22,16 +37,43 @@
  * Instances are created for each accepted client and manage async reads and
  * writes on the socket. The connection holds a reference to an
  * `IMovieBooker` to perform queries and booking operations.
+ *
+ * The socket is bound to its own strand, so every completion handler of a
+ * connection is serialized even when several threads run the io_context.
+ * Per-session state (selected movie/theater, buffers) needs no extra locking.
+ *
+ * Clients may pipeline commands: the complete lines received by one read are
+ * processed in order and their replies are queued as one buffer.
+ *
+ * Replies go through an outbound queue of reference-counted buffers. One
+ * gather write at a time drains the queue while reads continue; when
+ * `kHighWaterMark` bytes are waiting for a slow client, the session stops
+ * executing commands (even ones already received) and reading until the
+ * queue drops below `kLowWaterMark`, so a burst of pipelined commands
+ * cannot queue more than the mark plus one reply. Shared buffers (e.g. the greeting,
+ * the list_movies / list_theaters replies of a `ListingCache`) are queued
+ * without copying, and reply buffers owned only by the queue are
+ * recycled once written.
+ *
+ * The "binary" command switches the session to the length-prefixed frames of
+ * `BinaryProtocol.hpp`; binary requests carry their own movie and theater ids
+ * and are served by the same `IMovieBooker`.
  */
 class tcp_connection : public std::enable_shared_from_this<tcp_connection>
 {
 public:
     typedef std::shared_ptr<tcp_connection> pointer;
+    typedef std::shared_ptr<const std::string> buffer_ptr;
+
+    static constexpr std::size_t kHighWaterMark = 64 * 1024;   ///< queued bytes that pause reading
+    static constexpr std::size_t kLowWaterMark = 16 * 1024;    ///< queued bytes that resume reading
+    static constexpr std::size_t kMaxGather = 64;              ///< buffers per gather write
+    static constexpr std::chrono::milliseconds kDefaultHoldTtl{ 5 * 60 * 1000 };    ///< lifetime of seat holds
 
     ~tcp_connection();
 
     /**
-     * @brief Create a new connection object.
+     * @brief Create a new connection object running on its own strand.
      * @param io_context The io_context used for socket operations.
      * @param booker Reference to the movie booker used to service requests.
      * @return Shared pointer to the created connection.
@@ -49,22 +91,112 @@ public:
      */
     void start();
 
+    /**
+     * @brief Refuse the session: send a "server busy" error and close the socket.
+     */
+    void reject();
+
+    /**
+     * @brief Close the socket and hand the slot back to the registry (once per session).
+     */
+    void close();
+
+    /**
+     * @brief Set the time-to-live of holds created by this session; call before start().
+     */
+    void set_hold_ttl(std::chrono::milliseconds ttl);
+
+    /**
+     * @brief Record commands, bookings and bytes in `metrics` (null: not recorded); call before start().
+     */
+    void set_metrics(ServerMetrics* metrics);
+
+    /**
+     * @brief Serve list_movies / list_theaters from `listings` (null: built per request); call before start().
+     */
+    void set_listings(ListingCache* listings);
+
 private:
+    friend class connection_registry;
+
     tcp_connection(boost::asio::io_context& io_context_, IMovieBooker& booker);
-    
 
     /**
-     * @brief Asynchronously write a message to the client.
-     * @param msg Message to send.
+     * @brief Clear per-session state so the object can serve a new client.
+     */
+    void reset();
+
+    /**
+     * @brief Append a reply to `out_buffer`; it is queued with the other replies of the same read.
+     * @param msg Reply text including its '\n'.
      */
-    void write_out(const std::string&);
+    void respond(std::string_view msg);
 
     /**
-     * @brief Trim a trailing '\r' from a string if present.
-     * @param s String to trim.
-     * @return Reference to the trimmed string.
+     * @brief Queue a buffer for writing and start a write if none is in flight.
+     * @param buffer Buffer to send; it is kept alive until written.
      */
-    static std::string& trim_trailing(std::string&, char);
+    void enqueue(buffer_ptr buffer);
+
+    /**
+     * @brief Move the replies accumulated in `out_buffer` onto the outbound queue.
+     */
+    void flush_out_buffer();
+
+    /**
+     * @brief Count a booking command's outcome if metrics are recorded.
+     */
+    void count_booking(bool booked);
+
+    /**
+     * @brief Check that a showing is selected (a movie and a theater showing it), replying with an error otherwise.
+     */
+    bool check_selection();
+
+    /**
+     * @brief Serve "book_best <n> [contiguous]" for the selected showing.
+     */
+    void book_best(std::string_view args);
+
+    /**
+     * @brief Validate the selection and parse a seat list into `seat_buffer`, replying on errors.
+     * @return true if `seat_buffer` holds a valid list for the selected showing.
+     */
+    bool parse_selected_seats(std::string_view args);
+
+    /**
+     * @brief Serve "book_batch <movie>|<theater>|<s1,s2,..>;..." as one all-or-nothing booking.
+     */
+    void book_batch(std::string_view args);
+
+    /**
+     * @brief Process the complete binary frames in `command_buffer` from `offset` on.
+     * @return Offset just past the last processed frame.
+     */
+    std::size_t drain_frames(std::size_t offset);
+
+    /**
+     * @brief Serve one binary request, appending its response frame to `out_buffer`.
+     */
+    void handle_frame(const FrameHeader& request, std::string_view payload);
+
+    /**
+     * @brief Run the buffered commands up to the high-water mark, then read more unless paused.
+     */
+    void process_input();
+
+    /**
+     * @brief Return true while the replies queued and pending reach `kHighWaterMark`.
+     */
+    bool paused() const { return queued_bytes_ + out_buffer.size() >= kHighWaterMark; }
+
+    void start_read();
+    void start_write();
+
+    /**
+     * @brief Dispatch one command line (without its '\n'), appending its reply to `out_buffer`.
+     */
+    void handle_command(std::string_view line);
 
     void handle_write_end(const boost::system::error_code&, size_t);
     void handle_read_end(const boost::system::error_code&, size_t);
@@ -73,6 +205,93 @@ private:
     boost::asio::ip::tcp::socket socket_;
     std::string command_buffer, out_buffer;
     std::string last_movie, last_theater;
+    std::vector<unsigned int> seat_buffer;      // parsed book_seats ids; capacity is kept across commands
+    std::vector<IMovieBooker::BookingItem> batch_buffer;  // items of the current book_batch
+
+    std::deque<buffer_ptr> out_queue_;          // buffers waiting for the next write
+    std::vector<buffer_ptr> in_flight_;         // buffers of the current gather write
+    std::vector<boost::asio::const_buffer> gather_;
+    std::vector<std::shared_ptr<std::string>> spare_;   // written reply buffers kept for reuse
+    std::size_t queued_bytes_ = 0;              // bytes queued or in flight
+    bool reading_ = false;                      // a read is armed
+    bool writing_ = false;                      // a write is in flight
+    bool binary_ = false;                       // session switched to binary frames (BinaryProtocol.hpp)
+
+    // ids resolved by select_movie / select_theater; the showing is cached for
+    // get_free_seats and book_seats so they skip the name lookups
+    std::optional<IMovieBooker::MovieId> movie_id;
+    std::optional<IMovieBooker::TheaterId> theater_id;
+    std::optional<IMovieBooker::ShowingId> showing_id;
+    std::size_t seat_count = 0;                 // capacity of the selected showing
+    std::chrono::milliseconds hold_ttl_ = kDefaultHoldTtl;
+
+    connection_registry* registry_ = nullptr;   // owner of this connection's slot
+    std::size_t slot_ = 0;                      // index in the registry
+    bool closed_ = false;                       // set once the session's read/write chain has ended
+    bool rejecting_ = false;                    // stop reading; close once the queue is written
+
+    ServerMetrics* metrics_ = nullptr;
+    ListingCache* listings_ = nullptr;
+    std::size_t buffered_ = 0;                  // command_buffer bytes already counted as received
+};
+
+
+
+/**
+ * @class connection_registry
+ * @brief Owns the server's connections and recycles them once their session ends.
+ *
+ * Every connection lives in a slot. When a session's read/write chain ends the
+ * slot goes back on a free list; the next accept reuses both the slot and, if
+ * nothing else still references it, the connection object with its socket and
+ * reserved buffers, so steady-state accepts do not allocate. The registry also
+ * enforces the max-connections limit and tracks live and peak session counts.
+ * All methods are thread-safe.
+ */
+class connection_registry
+{
+public:
+    /**
+     * @brief Construct the registry.
+     * @param max_connections Maximum number of live sessions; 0 means no limit.
+     */
+    explicit connection_registry(std::size_t max_connections = 0);
+
+    /**
+     * @brief Return an idle connection ready to accept a client into.
+     * @param io_context The io_context used when a new connection must be created.
+     * @param booker Booker used when a new connection must be created.
+     */
+    tcp_connection::pointer acquire(boost::asio::io_context& io_context, IMovieBooker& booker);
+
+    /**
+     * @brief Count an accepted connection as live if the limit allows it.
+     * @return false when the server is at max-connections; the caller should reject the client.
+     */
+    bool admit(const tcp_connection::pointer& connection);
+
+    /**
+     * @brief Return a slot to the free list; called once when a session ends.
+     */
+    void release(std::size_t slot);
+
+    /**
+     * @brief Drop every connection (used on server shutdown).
+     */
+    void clear();
+
+    std::size_t live() const;                   ///< sessions currently running
+    std::size_t peak() const;                   ///< highest number of simultaneous sessions
+    std::size_t slots() const;                  ///< connection objects owned by the registry
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<tcp_connection::pointer> slots_;
+    std::vector<bool> active_;                  // slot counts towards live_
+    std::vector<std::size_t> free_;             // released slots, reused LIFO
+    std::size_t max_connections_;
+    std::size_t live_ = 0;
+    std::size_t peak_ = 0;
 };
 
 
@@ -83,23 +302,41 @@ private:
  *
  * Construct with a reference to an `IMovieBooker` implementation. Call `Run()`
  * to start the server's event loop. `Stop()` will stop the io_context.
+ * The io_context is shared by a configurable number of worker threads.
+ *
+ * While running, a timer on the io_context calls `IMovieBooker::ExpireHolds`
+ * every `kHoldExpiryInterval` to free the seats of holds that timed out.
+ *
+ * Sessions record into the server's `ServerMetrics`. `EnableAdmin` opens a
+ * second, loopback-only port that answers every HTTP request for /metrics
+ * with the metrics in Prometheus text format.
+ *
+ * The list_movies / list_theaters replies are built once per catalog version
+ * by the server's `ListingCache` and shared by every session.
  */
 class AsioServer
 {
 public:
+    static constexpr std::chrono::milliseconds kHoldExpiryInterval{ 100 };  ///< period of the hold expiry timer
+
     AsioServer() = delete;
 
     /**
      * @brief Construct the server.
      * @param booker Reference to an IMovieBooker used to service requests.
      * @param port TCP port to bind the server on (default 8080). Use 0 to pick an ephemeral port.
+     * @param threads Number of threads running the io_context (0 is treated as 1).
+     * @param max_connections Maximum number of simultaneous sessions; 0 means no limit.
      */
-    AsioServer(IMovieBooker &booker, unsigned short port = 8080);
+    AsioServer(IMovieBooker &booker, unsigned short port = 8080, unsigned int threads = 1, std::size_t max_connections = 0);
 
     ~AsioServer();
 
     /**
      * @brief Run the server event loop (blocks until stopped).
+     *
+     * The calling thread becomes one of the workers; the remaining threads
+     * are started here and joined before returning.
      */
     void Run();
 
@@ -113,16 +350,62 @@ public:
      */
     unsigned short GetPort() const;
 
+    /**
+     * @brief Return the number of threads running the io_context.
+     */
+    unsigned int GetThreadCount() const;
+
+    /**
+     * @brief Return the number of client sessions currently open.
+     */
+    std::size_t GetLiveConnections() const;
+
+    /**
+     * @brief Return the highest number of simultaneous client sessions seen so far.
+     */
+    std::size_t GetPeakConnections() const;
+
+    /**
+     * @brief Set the time-to-live of seat holds for sessions accepted from now on.
+     */
+    void SetHoldTtl(std::chrono::milliseconds ttl);
+
+    /**
+     * @brief Serve GET /metrics (Prometheus text format) on 127.0.0.1:`port`; call before Run().
+     * @param port Admin port; 0 picks an ephemeral port (see GetAdminPort()).
+     * @throws boost::system::system_error if the port cannot be bound.
+     */
+    void EnableAdmin(unsigned short port);
+
+    /**
+     * @brief Return the admin port, 0 if EnableAdmin() was not called.
+     */
+    unsigned short GetAdminPort() const;
+
+    /**
+     * @brief Return the counters of every session, with the connection gauges filled in.
+     */
+    MetricsSnapshot GetMetrics() const;
+
 private:
     void start_accept();
+    void start_admin_accept();
+    void start_expiry_timer();
+    void handle_expiry_timer(const boost::system::error_code& error);
     void handle_accept(tcp_connection::pointer new_connection, const boost::system::error_code& error);
 
-	std::vector<tcp_connection::pointer> connections;
+    connection_registry connections;
     boost::asio::io_context io_context_;
     boost::asio::ip::tcp::acceptor acceptor;
     IMovieBooker& booker_;
     bool run_once;
     unsigned short port_; // bound port
+    unsigned int threads_; // worker threads running io_context_
+    std::chrono::milliseconds hold_ttl_; // passed to every accepted connection
+    boost::asio::steady_timer expiry_timer_; // drives booker_.ExpireHolds
+    ServerMetrics metrics_;
+    ListingCache listings_; // list replies shared by every session
+    boost::asio::ip::tcp::acceptor admin_acceptor_; // open once EnableAdmin() was called
 };
 
 
@@ -0,0 +1,175 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file AsyncClient.hpp
+ * @brief Asynchronous, pipelining text-protocol sessions and a pool of them.
+ */
+
+/**
+ * @class AsyncClient
+ * @brief One text-protocol session driven by a caller's io_context, the non-blocking counterpart of AsioClient.
+ *
+ * AsyncConnect() and AsyncCommand() return at once; handlers run later on
+ * a thread running the io_context, never inside the call that started the
+ * operation. Many sessions can share one io_context, which is how
+ * movie_booker_loadgen keeps thousands of them open on a few threads.
+ *
+ * Commands are pipelined: any number may be in flight, including ones
+ * issued before the connection is up. Commands issued together are written
+ * in one go, and replies are matched to commands in order, since the server
+ * answers in order. Reads go into one buffer kept for the life of the
+ * session. A reply is passed to its handler as a view, valid for the
+ * duration of the call.
+ *
+ * All methods are thread-safe; the session's work is serialized on a
+ * strand, and calls made from its own handlers skip the hop. When the
+ * connection fails or is closed, every pending handler gets the error.
+ *
+ * @code
+ * auto session = AsyncClient::Create(io);
+ * session->AsyncConnect(endpoints, [](const boost::system::error_code& error) { ... });
+ * session->AsyncCommand("list_movies", [](const boost::system::error_code& error, std::string_view reply) { ... });
+ * std::future<std::string> stats = session->Command("stats");     // from a thread not running io
+ * @endcode
+ */
+class AsyncClient : public std::enable_shared_from_this<AsyncClient>
+{
+public:
+    typedef std::shared_ptr<AsyncClient> pointer;
+    typedef std::function<void(const boost::system::error_code& error)> ConnectHandler;
+    typedef std::function<void(const boost::system::error_code& error, std::string_view reply)> ReplyHandler;
+
+    /**
+     * @brief Create an unconnected session whose operations run on `io_context`.
+     */
+    static pointer Create(boost::asio::io_context& io_context);
+
+    /**
+     * @brief Connect to the first reachable endpoint and read the server's greeting.
+     *
+     * A server at its connection limit answers "Error! Server busy" and hangs
+     * up; that fails with boost::asio::error::connection_refused.
+     */
+    void AsyncConnect(const boost::asio::ip::tcp::resolver::results_type& endpoints, ConnectHandler handler);
+
+    /**
+     * @brief Queue one command line and call `handler` with its reply.
+     * @param line Command without the terminating '\n'.
+     * @param handler Gets the reply without its line ending; the lines of a
+     *        multi-line reply ("stats") are separated by '\n'.
+     */
+    void AsyncCommand(std::string_view line, ReplyHandler handler);
+
+    /**
+     * @brief Queue one command line; the future holds its reply.
+     *
+     * A failed exchange stores a boost::system::system_error. Do not wait on
+     * the future from a thread running the io_context.
+     */
+    std::future<std::string> Command(std::string_view line);
+
+    /**
+     * @brief Close the connection; pending handlers get operation_aborted.
+     */
+    void Close();
+
+    /**
+     * @brief Return false once the connection failed or was closed.
+     */
+    bool IsOpen() const { return open_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Return the number of commands whose handler has not run yet.
+     */
+    std::size_t Pending() const { return in_flight_.load(std::memory_order_relaxed); }
+
+private:
+    explicit AsyncClient(boost::asio::io_context& io_context);
+
+    struct PendingReply
+    {
+        ReplyHandler handler;
+        bool multiline = false;         // "stats": ends with an empty line
+        bool greeting = false;
+    };
+
+    // the rest run on the strand
+    void enqueue(std::string_view line, ReplyHandler handler);
+    void start_write();
+    void start_read();
+    void fail(const boost::system::error_code& error);
+
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    boost::asio::ip::tcp::socket socket_;
+    std::deque<PendingReply> pending_;  // replies expected, oldest first; the greeting's while connecting
+    std::string queued_;                // commands not yet handed to the socket
+    std::string write_buffer_;          // commands being written; swapped with queued_
+    std::string read_buffer_;           // bytes received and not yet returned; keeps its capacity
+    std::string reply_;                 // the reply being handed out
+    boost::system::error_code error_;   // why the session closed
+    bool connected_ = false;           // TCP connection up; writes may start
+    bool writing_ = false;
+    bool reading_ = false;
+    std::atomic<bool> open_{ true };
+    std::atomic<std::size_t> in_flight_{ 0 };
+};
+
+/**
+ * @class AsyncClientPool
+ * @brief A fixed number of pipelining AsyncClient sessions to one server.
+ *
+ * Each command goes to the open session with the fewest replies pending; a
+ * session that failed is replaced by a new connection on its next use.
+ * Sessions are shared, so the pool is meant for commands that do not depend
+ * on a selection: list_movies, book_batch, stats. A select_movie /
+ * select_theater sequence needs a session of its own. Thread-safe.
+ */
+class AsyncClientPool
+{
+public:
+    /**
+     * @brief Resolve `host`:`port` (blocking) and open `size` sessions on `io_context`.
+     * @throws boost::system::system_error if the name cannot be resolved.
+     */
+    AsyncClientPool(boost::asio::io_context& io_context, const std::string& host, const std::string& port, std::size_t size);
+    ~AsyncClientPool();
+
+    AsyncClientPool(const AsyncClientPool&) = delete;
+    AsyncClientPool& operator=(const AsyncClientPool&) = delete;
+
+    /**
+     * @brief Send a command on the least busy session; see AsyncClient::AsyncCommand().
+     */
+    void AsyncCommand(std::string_view line, AsyncClient::ReplyHandler handler);
+
+    /**
+     * @brief Send a command on the least busy session; see AsyncClient::Command().
+     */
+    std::future<std::string> Command(std::string_view line);
+
+    /**
+     * @brief Close every session.
+     */
+    void Close();
+
+private:
+    AsyncClient::pointer pick();
+    AsyncClient::pointer connect();
+
+    boost::asio::io_context& io_context_;
+    boost::asio::ip::tcp::resolver::results_type endpoints_;
+    std::mutex mutex_;                              // guards sessions_ and closed_
+    std::vector<AsyncClient::pointer> sessions_;
+    bool closed_ = false;                           // Close() called: failed sessions stay closed
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @file BinaryProtocol.hpp
+ * @brief Length-prefixed binary framing shared by the server and `AsioClient`.
+ *
+ * A text session switches to binary mode by sending the line "binary"; the
+ * server answers "OK binary\n" and every byte after that line is framed.
+ *
+ * Every frame starts with a 12 byte header, all integers little-endian:
+ *
+ *     u32 length      payload bytes following the header
+ *     u16 opcode      request opcode; responses set kResponseFlag
+ *     u16 status      0 in requests, a `FrameStatus` in responses
+ *     u32 request_id  chosen by the client, echoed in the response
+ *
+ * Requests are stateless: each one names its movie and theater by id.
+ *
+ *     opcode          request payload                  response payload
+ *     ListMovies      -                                u32 n, n x (u32 id, u16 len, name)
+ *     ListTheaters    u32 movie                        u32 n, n x (u32 id, u16 len, name)
+ *     GetFreeSeats    u32 movie, u32 theater           seat bitmap of free seats
+ *     BookSeats       u32 movie, u32 theater, bitmap   -
+ *     BookBatch       u32 n, n x (u32 movie,           -
+ *                       u32 theater, bitmap)
+ *     HoldSeats       u32 movie, u32 theater, bitmap   u64 hold
+ *     ConfirmHold     u64 hold                         -
+ *     ReleaseHold     u64 hold                         -
+ *     BookBest        u32 movie, u32 theater,          seat bitmap of the booked seats
+ *                       u32 count, u16 flags
+ *
+ * A seat bitmap is u32 bit count followed by ceil(count / 8) bytes; bit i
+ * (byte i / 8, bit i % 8) stands for seat i + 1. Payloads of a failed request
+ * are empty. BookBatch books every item or none (IMovieBooker::BookBatch).
+ * Holds last for the server's hold time-to-live unless confirmed or released.
+ * BookBest lets the server pick the seats; flag kContiguousFlag rejects
+ * anything but one block of adjacent seats.
+ */
+
+enum class Opcode : std::uint16_t
+{
+    ListMovies = 1,
+    ListTheaters = 2,
+    GetFreeSeats = 3,
+    BookSeats = 4,
+    BookBatch = 5,
+    HoldSeats = 6,
+    ConfirmHold = 7,
+    ReleaseHold = 8,
+    BookBest = 9,
+};
+
+enum class FrameStatus : std::uint16_t
+{
+    Ok = 0,
+    BadRequest = 1,         ///< unknown opcode, malformed or oversized payload
+    UnknownShowing = 2,     ///< the theater does not show the movie (or either id is unknown)
+    InvalidSeats = 3,       ///< no seats, or a seat outside the theater's capacity
+    SeatsUnavailable = 4,   ///< at least one seat is already booked or held
+    UnknownHold = 5,        ///< the hold expired, was confirmed or released, or never existed
+    ConnectionError = 0xffff, ///< never sent; reported by AsioClient when the exchange fails
+};
+
+/**
+ * @brief Decoded frame header.
+ */
+struct FrameHeader
+{
+    std::uint32_t length = 0;
+    std::uint16_t opcode = 0;
+    FrameStatus status = FrameStatus::Ok;
+    std::uint32_t request_id = 0;
+};
+
+/**
+ * @class FrameReader
+ * @brief Bounds-checked little-endian reader over a frame payload.
+ *
+ * A read past the end returns 0 / an empty view and clears `Ok()`, so a
+ * handler can read all fields and check once.
+ */
+class FrameReader
+{
+public:
+    explicit FrameReader(std::string_view data) : data_(data) {}
+
+    std::uint16_t U16();
+    std::uint32_t U32();
+    std::uint64_t U64();
+    std::string_view Bytes(std::size_t count);
+
+    bool Ok() const { return ok_; }
+    bool AtEnd() const { return pos_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+/**
+ * @class BinaryProtocol
+ * @brief Stateless helpers encoding and decoding binary frames.
+ */
+class BinaryProtocol
+{
+public:
+    static constexpr std::size_t kHeaderSize = 12;
+    static constexpr std::size_t kMaxPayload = 64 * 1024;  ///< larger requests are rejected
+    static constexpr std::uint16_t kResponseFlag = 0x8000;
+    static constexpr std::uint16_t kContiguousFlag = 0x0001;   ///< BookBest flags: adjacent seats only
+
+    /**
+     * @brief Decode a header from the start of `data`.
+     * @return false if fewer than kHeaderSize bytes are available.
+     */
+    static bool DecodeHeader(std::string_view data, FrameHeader& header);
+
+    /**
+     * @brief Append a header with a zero length; returns its offset for EndFrame().
+     */
+    static std::size_t BeginFrame(std::string& out, std::uint16_t opcode, std::uint32_t requestId);
+
+    /**
+     * @brief Patch the length and status of the frame started at `frame`.
+     *
+     * For a status other than Ok the payload written so far is dropped.
+     */
+    static void EndFrame(std::string& out, std::size_t frame, FrameStatus status);
+
+    static void AppendU16(std::string& out, std::uint16_t value);
+    static void AppendU32(std::string& out, std::uint32_t value);
+    static void AppendU64(std::string& out, std::uint64_t value);
+
+    /**
+     * @brief Append a u16 length and the bytes of `name` (truncated to 65535 bytes).
+     */
+    static void AppendName(std::string& out, std::string_view name);
+
+    /**
+     * @brief Append a list of (id, name) pairs as u32 count followed by the entries.
+     */
+    static void AppendNameList(std::string& out, const std::vector<std::pair<std::uint32_t, std::string>>& entries);
+
+    /**
+     * @brief Append a seat bitmap of `bitCount` bits with the given 1-based seats set.
+     *
+     * Seats above `bitCount` are ignored.
+     */
+    static void AppendSeatBitmap(std::string& out, const std::vector<unsigned int>& seats, std::size_t bitCount);
+
+    /**
+     * @brief Read a name list written by AppendNameList().
+     * @return false on a malformed list.
+     */
+    static bool ReadNameList(FrameReader& in, std::vector<std::pair<std::uint32_t, std::string>>& entries);
+
+    /**
+     * @brief Read a seat bitmap into the ascending list of set seats.
+     * @param in Reader positioned at the bitmap.
+     * @param seats Cleared, then receives the 1-based seat ids.
+     * @param bitCount Receives the bitmap's bit count (the seat capacity in free-seat responses).
+     * @return false on a malformed bitmap.
+     */
+    static bool ReadSeatBitmap(FrameReader& in, std::vector<unsigned int>& seats, std::size_t* bitCount = nullptr);
+};
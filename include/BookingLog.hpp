@@ -0,0 +1,227 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @file BookingLog.hpp
+ * @brief Append-only write-ahead log of bookings.
+ *
+ * The file starts with the 8 byte magic "MBLOG002" and the u64 log offset of
+ * its first record, followed by records, all integers little-endian:
+ *
+ *     u32 length      bytes of the record body
+ *     u32 crc         CRC-32 of the body
+ *     body            u32 n, n x (u16 len, movie, u16 len, theater, u32 count, count x u32 seat)
+ *
+ * One record holds the seats of one successful booking call; a batch booking
+ * is a single record with several showings. Showings are named rather than
+ * numbered because ids depend on the order the catalog was loaded in.
+ * Replay stops at the first torn or corrupt record, which can only be the
+ * tail written during a crash.
+ *
+ * Log offsets count every record ever appended, starting at 8, and survive
+ * Rotate(), which rewrites the file without the records before an offset a
+ * snapshot covers; the file then states the offset it starts at. Files
+ * written with the older magic "MBLOG001" have no offset field and start
+ * at offset 8.
+ */
+
+/**
+ * @brief How hard BookingLog::Append works to make a record durable.
+ */
+enum class Durability
+{
+    None,       ///< write to the OS on every append, never fsync (survives a process crash, not an OS crash)
+    Group,      ///< a background thread writes and fsyncs every group interval; Append does not wait,
+                ///< so an OS crash loses up to one interval of records already reported as appended
+    Fsync,      ///< Append returns once the record is fsynced; concurrent appends share one fsync
+};
+
+/**
+ * @brief Seats of one showing within a logged booking.
+ */
+struct LoggedBooking
+{
+    std::string_view movie;
+    std::string_view theater;
+    const unsigned int* seats = nullptr;
+    std::size_t count = 0;
+};
+
+/**
+ * @brief Outcome of BookingLog::Replay().
+ */
+struct LogReplayResult
+{
+    bool ok = false;                    ///< file missing (nothing to replay) or readable with a valid header
+    std::uint64_t records = 0;          ///< intact records replayed (from the start offset on)
+    std::uint64_t valid_bytes = 0;      ///< length of the intact prefix of the file, header included
+    bool torn_tail = false;             ///< bytes after the intact prefix were ignored
+    bool rotated_past = false;          ///< not ok: Rotate() dropped records from before the start offset
+    bool corrupt = false;               ///< not ok: a record's crc matched but its contents do not parse
+    std::uint64_t start = 0;            ///< log offset of the file's first record
+    std::uint64_t end = 0;              ///< log offset after the last intact record
+};
+
+/**
+ * @class BookingLog
+ * @brief Write-ahead log with none / group-commit / fsync-per-booking durability.
+ *
+ * Appends encode their record into a pending buffer under a mutex. Writing
+ * is done by one thread at a time, which takes the whole pending buffer, so
+ * any number of records reach the file with one write and at most one
+ * fsync: in Fsync mode the first appender becomes the leader and syncs for
+ * everyone queued behind it (group commit), in Group mode a flusher thread
+ * does so every interval. Thread-safe.
+ */
+class BookingLog
+{
+public:
+    static constexpr std::chrono::milliseconds kDefaultGroupInterval{ 5 };
+
+    /**
+     * @brief Called by Replay() for every showing of every intact record.
+     */
+    typedef std::function<void(std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats)> ReplayCallback;
+
+    BookingLog() = default;
+    ~BookingLog();
+
+    BookingLog(const BookingLog&) = delete;
+    BookingLog& operator=(const BookingLog&) = delete;
+
+    /**
+     * @brief Open (or create) the log for appending.
+     *
+     * A torn tail left by a crash is cut off first so new records follow the
+     * last intact one.
+     * @param path Log file.
+     * @param mode Durability of appends.
+     * @param groupInterval Flush period in Group mode.
+     * @return false if the file cannot be opened, is not a booking log or
+     *         holds a malformed record (see Replay()); the file is unchanged.
+     */
+    bool Open(const std::string& path, Durability mode, std::chrono::milliseconds groupInterval = kDefaultGroupInterval);
+
+    /**
+     * @brief Open the log that Replay() just read, without reading it again.
+     * @param path Log file passed to Replay().
+     * @param mode Durability of appends.
+     * @param groupInterval Flush period in Group mode.
+     * @param replayed What Replay() returned for `path`; its tail is cut off if torn.
+     * @return false if `replayed` is not ok or the file cannot be opened.
+     */
+    bool Open(const std::string& path, Durability mode, std::chrono::milliseconds groupInterval, const LogReplayResult& replayed);
+
+    /**
+     * @brief Write and sync everything appended, stop the flusher and close the file.
+     */
+    void Close();
+
+    bool IsOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Append one record; waits for the fsync in Fsync mode only.
+     * @param bookings The showings booked by one call.
+     * @param count Number of showings.
+     * @return false if the log is closed or writing failed (the record may be lost).
+     */
+    bool Append(const LoggedBooking* bookings, std::size_t count);
+
+    /**
+     * @brief Write pending records and fsync now, whatever the mode.
+     * @return false after a write error.
+     */
+    bool Sync();
+
+    /**
+     * @brief Return the log offset after the last appended record, including records not yet written.
+     */
+    std::uint64_t AppendedBytes() const;
+
+    /**
+     * @brief Return the log offset up to which records are known to be on disk.
+     */
+    std::uint64_t SyncedBytes() const;
+
+    /**
+     * @brief Rewrite the log without the records before `from`.
+     *
+     * Meant for after a snapshot taken at `from` is durable: the records it
+     * covers are no longer needed to restart. Everything appended is written
+     * out first; appends wait while the records after `from` are copied to a
+     * new file, which is synced and renamed over the log.
+     * @param from A log offset no later than SyncedBytes(), e.g. a snapshot's.
+     * @return false if the log is closed or failed, `from` is not written yet
+     *         or the new file could not be written; the log is unchanged
+     *         unless it failed while reopening.
+     */
+    bool Rotate(std::uint64_t from);
+
+    /**
+     * @brief Return the number of fsyncs issued so far (group commit makes it lower than the appends).
+     */
+    std::uint64_t SyncCount() const;
+
+    /**
+     * @brief Read a log and pass every intact record to `apply`, in order.
+     * @param path Log file; a missing file replays nothing and succeeds.
+     * @param apply Callback per booked showing; may be empty to only validate.
+     * @param from Offset of the first record to replay, e.g. the AppendedBytes()
+     *             a snapshot was taken at; 0 replays from the start. Replay
+     *             seeks to it and neither reads nor checks earlier records.
+     *             An offset beyond the file reads the whole file to find its
+     *             intact end and replays nothing. An offset before the file's
+     *             start, when Rotate() dropped records, fails with rotated_past.
+     * A record whose crc matches was written whole, so one that does not parse
+     * is not a torn tail: replay fails with corrupt (at valid_bytes) rather
+     * than letting Open() cut it and every intact record after it.
+     */
+    static LogReplayResult Replay(const std::string& path, const ReplayCallback& apply, std::uint64_t from = 0);
+
+private:
+    // decode a record body, calling `apply` (if set) per showing; false if malformed
+    static bool ParseRecord(std::string_view body, const ReplayCallback& apply, std::vector<unsigned int>& seats);
+
+    // write the pending buffer (and fsync if `sync`); called with lock held and writing_ false
+    void WriteOut(std::unique_lock<std::mutex>& lock, bool sync);
+
+    // wait until the file covers `offset` (synced if `sync`); lock held
+    bool WaitFor(std::unique_lock<std::mutex>& lock, std::uint64_t offset, bool sync);
+
+    void FlusherLoop();
+
+    // copy the written records from `from` on into a new log file at `temp`; lock held, no write in flight
+    bool WriteRotated(const std::string& temp, std::uint64_t from);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::FILE* file_ = nullptr;
+    std::string path_;
+    std::uint64_t base_ = 0;            // log offset of the file's first record
+    std::uint64_t header_ = 0;          // bytes before it in the file
+    Durability mode_ = Durability::None;
+    std::chrono::milliseconds interval_ = kDefaultGroupInterval;
+
+    std::string pending_;               // encoded records not yet written
+    std::string writing_buffer_;        // records being written; swapped with pending_
+    std::uint64_t appended_ = 0;        // log offset after the last appended record
+    std::uint64_t written_ = 0;         // log offset written to the OS
+    std::uint64_t synced_ = 0;          // log offset known to be on disk
+    std::uint64_t syncs_ = 0;
+    bool writing_ = false;              // a thread is writing outside the lock
+    bool failed_ = false;               // a write or fsync failed; the log stops accepting records
+    bool stop_ = false;
+
+    std::thread flusher_;               // Group mode only
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @file CatalogSnapshot.hpp
+ * @brief On-disk layout of a catalog snapshot (MovieBooker::WriteSnapshot).
+ *
+ * A snapshot is a header followed by fixed-size tables, so a memory-mapped
+ * file is read in place without parsing:
+ *
+ *     SnapshotHeader
+ *     SnapshotTheater  x theater_count      theater id order
+ *     SnapshotMovie    x movie_count        movie id order
+ *     SnapshotShowing  x showing_count      showing id order
+ *     u64 seat words                        SeatBitmap words of every showing, bit set = booked
+ *     string bytes                          names, not terminated
+ *
+ * Integers are in host byte order; `byte_order` detects a file from a host
+ * of the other endianness. Every table and the seat words start 8-byte aligned.
+ * Ids are stored implicitly by position, so a restored catalog has the same
+ * ids as the one written. A showing removed by a catalog reload keeps its
+ * slot with `movie` set to kSnapshotRemovedShowing and no seat words, and a
+ * movie without showings is restored as removed too.
+ */
+
+/// Magic at the start of every snapshot.
+constexpr char kSnapshotMagic[8] = { 'M', 'B', 'S', 'N', 'A', 'P', '0', '1' };
+
+/// Written as a u64; reads back differently on a host with the other byte order.
+constexpr std::uint64_t kSnapshotByteOrder = 0x0102030405060708ull;
+
+/// SnapshotShowing::movie of a showing removed by a reload.
+constexpr std::uint32_t kSnapshotRemovedShowing = 0xffffffffu;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    std::uint64_t byte_order;
+    std::uint64_t log_offset;               ///< BookingLog::AppendedBytes() when the snapshot started
+    std::uint32_t theater_count;
+    std::uint32_t movie_count;
+    std::uint32_t showing_count;
+    std::uint32_t reserved;
+    std::uint64_t word_count;               ///< seat words of all showings
+    std::uint64_t string_bytes;
+};
+
+struct SnapshotTheater
+{
+    std::uint64_t name_offset;              ///< into the string bytes
+    std::uint32_t name_length;
+    std::uint32_t seats;
+};
+
+struct SnapshotMovie
+{
+    std::uint64_t name_offset;
+    std::uint32_t name_length;
+    std::uint32_t reserved;
+};
+
+struct SnapshotShowing
+{
+    std::uint32_t movie;
+    std::uint32_t theater;
+    std::uint64_t first_word;               ///< index into the seat words; the theater's seats give the length
+};
+
+static_assert(sizeof(SnapshotHeader) == 56, "snapshot layout");
+static_assert(sizeof(SnapshotTheater) == 16 && sizeof(SnapshotMovie) == 16 && sizeof(SnapshotShowing) == 16, "snapshot layout");
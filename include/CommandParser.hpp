@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file CommandParser.hpp
+ * @brief Allocation-free parsing of the text protocol's command lines.
+ *
+ * Works on `std::string_view`s into the connection's receive buffer: the
+ * command word is dispatched with a switch on its length plus one compare,
+ * arguments are returned as views, and seat lists are parsed with
+ * `std::from_chars` into a caller-owned vector whose capacity is reused.
+ */
+
+/**
+ * @brief Commands of the text protocol.
+ */
+enum class Command
+{
+    Unknown,
+    ListMovies,         ///< list_movies
+    SelectMovie,        ///< select_movie <name>
+    ListTheaters,       ///< list_theaters
+    SelectTheater,      ///< select_theater <name>
+    GetFreeSeats,       ///< get_free_seats
+    BookSeats,          ///< book_seats <s1,s2,..>
+    BookBatch,          ///< book_batch <movie>|<theater>|<s1,s2,..>;...
+    BookBest,           ///< book_best <n> [contiguous]
+    Binary,             ///< binary (switch the session to binary frames)
+    HoldSeats,          ///< hold_seats <s1,s2,..>
+    ConfirmHold,        ///< confirm_hold <id>
+    ReleaseHold,        ///< release_hold <id>
+    Stats,              ///< stats (server metrics, see ServerMetrics)
+};
+
+/**
+ * @brief One parsed command line.
+ */
+struct ParsedCommand
+{
+    Command command = Command::Unknown; ///< Unknown also for a blank line
+    std::string_view argument;          ///< rest of the line, leading whitespace and trailing ' '/'\r' removed
+};
+
+/**
+ * @brief Outcome of parsing a seat list.
+ */
+enum class SeatListStatus
+{
+    Ok,
+    Empty,              ///< no seat number at the start of the list
+    OutOfRange,         ///< a seat number is outside 1..capacity
+    TooMany,            ///< more seats than the theater's capacity
+};
+
+/**
+ * @class CommandParser
+ * @brief Stateless helpers turning a command line into a `ParsedCommand`.
+ */
+class CommandParser
+{
+public:
+    /**
+     * @brief Parse one command line.
+     * @param line The line without its terminating '\n'.
+     * @return The command (case-insensitive match) and its argument.
+     */
+    static ParsedCommand Parse(std::string_view line);
+
+    /**
+     * @brief Map a command word to a `Command` (case-insensitive).
+     */
+    static Command Lookup(std::string_view word);
+
+    /**
+     * @brief Parse a comma separated seat list such as "1, 2,3".
+     *
+     * Parsing stops at the first character that is not a separating comma, as
+     * the stream based parser did. `seats` is cleared first and left empty on
+     * any error status.
+     * @param args The list text.
+     * @param capacity Highest valid seat number (and maximum list length).
+     * @param seats Output seat ids.
+     */
+    static SeatListStatus ParseSeats(std::string_view args, std::size_t capacity, std::vector<unsigned int>& seats);
+
+    /**
+     * @brief Parse an unsigned decimal number filling the whole of `text`.
+     * @return false for an empty, non-numeric or out of range text.
+     */
+    static bool ParseNumber(std::string_view text, std::uint64_t& value);
+
+    /**
+     * @brief Parse a book_best argument "<n>" or "<n> contiguous".
+     * @param args The argument text.
+     * @param count Receives n.
+     * @param contiguous Receives whether the "contiguous" option was given.
+     * @return false for a missing or malformed count or an unknown option.
+     */
+    static bool ParseBestRequest(std::string_view args, std::uint64_t& count, bool& contiguous);
+
+    /**
+     * @brief Take the next ';' separated item off a book_batch argument.
+     *
+     * Empty items (e.g. after a trailing ';') are skipped.
+     * @param rest Remaining argument text; advanced past the returned item.
+     * @param item Receives the item text, surrounding blanks removed.
+     * @return false when no item is left.
+     */
+    static bool NextBatchItem(std::string_view& rest, std::string_view& item);
+
+    /**
+     * @brief Split a book_batch item "<movie>|<theater>|<seats>" into its trimmed fields.
+     * @return false unless the item has exactly three non-empty fields.
+     */
+    static bool SplitBatchItem(std::string_view item, std::string_view& movie, std::string_view& theater, std::string_view& seats);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file EpochManager.hpp
+ * @brief Minimal epoch-based reclamation for read-mostly snapshots.
+ *
+ * Readers pin the current global epoch in a per-thread slot for the duration
+ * of a read (no shared lock, no shared counter). A writer that replaces a
+ * snapshot calls `Advance()` and tags the old snapshot with the returned
+ * epoch; the snapshot can be freed once `MinActive()` is greater than that tag,
+ * because every reader that could still see it has finished.
+ */
+class EpochManager
+{
+public:
+    /// Value returned by `MinActive()` when no reader is active.
+    static constexpr std::uint64_t kNoReader = ~std::uint64_t(0);
+
+    /**
+     * @class ReadGuard
+     * @brief RAII guard pinning the current epoch for the calling thread.
+     *
+     * Load the protected pointer after constructing the guard and stop using
+     * it before the guard is destroyed. Guards may nest on one thread.
+     */
+    class ReadGuard
+    {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+     * @brief Start a new epoch; call after publishing a replacement snapshot.
+     * @return The tag for the snapshot that was just replaced.
+     */
+    static std::uint64_t Advance();
+
+    /**
+     * @brief Return the oldest epoch pinned by any reader, or `kNoReader`.
+     */
+    static std::uint64_t MinActive();
+};
@@ -2,6 +2,10 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <utility>
+#include <cstdint>
+#include <chrono>
+#include <cstddef>
 
 /**
  * @file ImovieBooker.hpp
@@ -20,6 +24,26 @@
  */
 class IMovieBooker {
 public:
+    /// Compact ids handed out by the resolve methods; stable for the lifetime of the booker.
+    typedef std::uint32_t MovieId;
+    typedef std::uint32_t TheaterId;
+    typedef std::uint32_t ShowingId;      ///< one movie running in one theater
+    typedef std::uint64_t HoldId;         ///< temporary seat reservation; 0 is never a valid hold
+
+    /// One showing of a batch booking and the seats wanted in it.
+    struct BookingItem
+    {
+        ShowingId showing;
+        std::vector<unsigned int> seats;  ///< 1 based seat indices
+    };
+
+    /// A part of the catalog for AddCatalog: theater capacities, then movies with their theaters.
+    struct CatalogChunk
+    {
+        std::vector<std::pair<std::string, std::size_t>> theaters;               ///< name, seats
+        std::vector<std::pair<std::string, std::vector<std::string>>> movies;    ///< title, theater names
+    };
+
     virtual ~IMovieBooker() = default;
 
     /**
@@ -30,6 +54,29 @@ public:
      */
     virtual bool AddMovie(const std::string& movie, const std::vector<std::string>& theatres) = 0;
 
+    /**
+     * @brief Register a theater with its seat capacity.
+     *
+     * Must happen before the theater is first used by AddMovie; theaters that are
+     * only named by AddMovie get the implementation's default capacity.
+     * @param theater The theater name (non-empty).
+     * @param seats Number of seats of every showing in the theater (> 0).
+     * @return true on success, false on invalid input or if the theater already exists.
+     */
+    virtual bool AddTheater(const std::string& theater, std::size_t seats) = 0;
+
+    /**
+     * @brief Add many theaters and movies in one step.
+     *
+     * Same result as AddTheater for every theater followed by AddMovie for
+     * every movie, but the catalog changes once: readers see all of the
+     * chunk or none of it. Meant for loading large catalogs, whole or in
+     * large chunks.
+     * @param chunk Theaters and movies to add.
+     * @return false if an entry was invalid or an already known theater; the other entries are still added.
+     */
+    virtual bool AddCatalog(const CatalogChunk& chunk) = 0;
+
     /**
      * @brief Get the list of movies currently known to the system.
      * @return Vector of movie titles.
@@ -66,4 +113,128 @@ public:
      * @return true when the theater is known.
      */
     virtual bool IsTheater(const std::string& theater) = 0;
+
+    /**
+     * @brief Resolve a movie title to its id.
+     * @param movie The movie title.
+     * @return The movie id, or std::nullopt if the movie is unknown.
+     */
+    virtual std::optional<MovieId> ResolveMovie(const std::string& movie) = 0;
+
+    /**
+     * @brief Resolve a theater name to its id.
+     * @param theater The theater name.
+     * @return The theater id, or std::nullopt if the theater is unknown.
+     */
+    virtual std::optional<TheaterId> ResolveTheater(const std::string& theater) = 0;
+
+    /**
+     * @brief Resolve the showing of a movie in a theater.
+     * @param movie Movie id from ResolveMovie().
+     * @param theater Theater id from ResolveTheater().
+     * @return The showing id, or std::nullopt if the theater does not show the movie.
+     */
+    virtual std::optional<ShowingId> ResolveShowing(MovieId movie, TheaterId theater) = 0;
+
+    /**
+     * @brief Get every movie with its id.
+     * @return Pairs of movie id and title.
+     */
+    virtual std::vector<std::pair<MovieId, std::string>> GetMovieList() = 0;
+
+    /**
+     * @brief Get the theaters showing a movie, with their ids.
+     * @param movie Movie id from ResolveMovie() or GetMovieList().
+     * @return Pairs of theater id and name; empty for an unknown movie.
+     */
+    virtual std::vector<std::pair<TheaterId, std::string>> GetTheaterList(MovieId movie) = 0;
+
+    /**
+     * @brief Get a list of free seat indices for a showing.
+     * @param showing Showing id from ResolveShowing().
+     * @return 1 based vector of free seat indices; empty for an unknown showing.
+     */
+    virtual std::vector<unsigned int> GetFreeSeats(ShowingId showing) = 0;
+
+    /**
+     * @brief Try to book the specified seats of a showing.
+     * @param showing Showing id from ResolveShowing().
+     * @param seatIds 1 based vector of seat indices to book.
+     * @return true if the seats were successfully booked, false otherwise.
+     */
+    virtual bool BookSeats(ShowingId showing, const std::vector<unsigned int>& seatIds) = 0;
+
+    /**
+     * @brief Book the seats of several showings, all or nothing.
+     *
+     * Either every item is booked or none is. Items may name the same showing
+     * more than once; their seats must then not overlap. Under contention with
+     * other batches over the same seats, a batch may fail although its seats
+     * end up free, because another batch claimed them for a moment and then
+     * gave them back; the caller may retry.
+     * @param items Showings and seats to book.
+     * @return true if every seat of every item was booked, false otherwise.
+     */
+    virtual bool BookBatch(const std::vector<BookingItem>& items) = 0;
+
+    /**
+     * @brief Pick and book `count` seats of a showing in one step.
+     *
+     * The server chooses the seats, preferring one block of adjacent seats, so
+     * a group booking needs no free-seat list and cannot fail on a stale one.
+     * @param showing Showing id from ResolveShowing().
+     * @param count Number of seats to book.
+     * @param contiguous Only accept a block of adjacent seats.
+     * @param seats Receives the booked 1 based seat ids (empty on failure).
+     * @return false if the showing is unknown or not enough (adjacent) seats are free.
+     */
+    virtual bool BookBest(ShowingId showing, std::size_t count, bool contiguous, std::vector<unsigned int>& seats) = 0;
+
+    /**
+     * @brief Reserve seats of a showing for a limited time.
+     *
+     * Held seats are not free: nobody else can book or hold them until the hold
+     * is confirmed (the seats become booked), released, or expires.
+     * @param showing Showing id from ResolveShowing().
+     * @param seatIds 1 based seat indices, all or nothing.
+     * @param ttl How long the hold lasts without confirmation.
+     * @return The hold id, or std::nullopt if the seats could not be held.
+     */
+    virtual std::optional<HoldId> HoldSeats(ShowingId showing, const std::vector<unsigned int>& seatIds, std::chrono::milliseconds ttl) = 0;
+
+    /**
+     * @brief Turn a hold into a booking.
+     * @return false if the hold is unknown, expired or already confirmed/released.
+     */
+    virtual bool ConfirmHold(HoldId hold) = 0;
+
+    /**
+     * @brief Give the seats of a hold back before it expires.
+     * @return false if the hold is unknown, expired or already confirmed/released.
+     */
+    virtual bool ReleaseHold(HoldId hold) = 0;
+
+    /**
+     * @brief Release every hold whose time-to-live has passed; call periodically.
+     * @param now Current time.
+     * @return Number of holds released.
+     */
+    virtual std::size_t ExpireHolds(std::chrono::steady_clock::time_point now) = 0;
+
+    /**
+     * @brief Return the number of seats of a showing (its theater's capacity).
+     * @param showing Showing id from ResolveShowing().
+     * @return Seat count; 0 for an unknown showing.
+     */
+    virtual std::size_t GetSeatCount(ShowingId showing) = 0;
+
+    /**
+     * @brief Return the version of the movie/theater catalog.
+     *
+     * The version changes whenever movies or theaters are added or the catalog
+     * is replaced, never on bookings or holds, so anything derived from the
+     * catalog (e.g. a serialized movie list) stays valid while it is unchanged.
+     * @return A number that increases with every catalog change.
+     */
+    virtual std::uint64_t GetCatalogVersion() const = 0;
 };
\ No newline at end of file
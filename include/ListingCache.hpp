@@ -0,0 +1,91 @@
+#pragma once
+
+#include <IMovieBooker.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file ListingCache.hpp
+ * @brief Serialized list_movies / list_theaters replies shared by every session.
+ */
+
+/**
+ * @class ListingCache
+ * @brief Text replies of list_movies and list_theaters, built once per catalog version.
+ *
+ * The catalog rarely changes while listing it is the most frequent command,
+ * so the server serializes each listing once and hands every session the same
+ * reference-counted buffer, which it queues for writing without a copy.
+ *
+ * The listings of one catalog version form an immutable set, published
+ * RCU-style like MovieBooker's catalog: a request loads the set's pointer
+ * under an EpochManager::ReadGuard and copies out one buffer reference,
+ * without a lock. A request that sees IMovieBooker::GetCatalogVersion()
+ * newer than the set's tag takes the lock, builds the listings of every
+ * running movie and publishes them, so AddMovie, AddCatalog and a catalog
+ * reload take effect with the next request. The version is read before the
+ * set is built: a set can be newer than its tag (and is rebuilt once more),
+ * never older. Replaced sets are freed once no reader can still see them.
+ * Thread-safe.
+ */
+class ListingCache
+{
+public:
+    typedef std::shared_ptr<const std::string> buffer_ptr;
+
+    explicit ListingCache(IMovieBooker& booker);
+    ~ListingCache();
+
+    ListingCache(const ListingCache&) = delete;
+    ListingCache& operator=(const ListingCache&) = delete;
+
+    /**
+     * @brief Return the list_movies reply: "title,title,...\n", or "No movies running\n".
+     */
+    buffer_ptr Movies();
+
+    /**
+     * @brief Return the list_theaters reply for a movie: "name,name,...\n", or "Movie is not running in any theater\n".
+     * @param id The movie's id from IMovieBooker::ResolveMovie().
+     */
+    buffer_ptr Theaters(IMovieBooker::MovieId id);
+
+    /**
+     * @brief Return the catalog version the cached listings were built for.
+     */
+    std::uint64_t GetVersion() const;
+
+    /**
+     * @brief Serialize `names` as one reply line: each name followed by ',', or `none` when there are no names.
+     * @param none Reply for an empty list, including its '\n'.
+     */
+    static std::string Format(const std::vector<std::string>& names, const char* none);
+
+private:
+    // every listing of one catalog version; immutable once published
+    struct Listings
+    {
+        std::uint64_t version = 0;
+        buffer_ptr movies;
+        buffer_ptr no_theaters;                                         // for movies not running
+        std::unordered_map<IMovieBooker::MovieId, buffer_ptr> theaters; // every running movie
+    };
+
+    // the published set, rebuilt first if older than `version`; call under an EpochManager::ReadGuard
+    const Listings* load(std::uint64_t version);
+
+    IMovieBooker& booker_;
+    std::atomic<const Listings*> listings_{ nullptr };                  // published set, read lock-free
+
+    // rebuilders only: the published set and replaced sets tagged with their retire epoch
+    std::mutex mutex_;
+    std::unique_ptr<const Listings> current_;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<const Listings>>> retired_;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @file MappedFile.hpp
+ * @brief Read-only memory mapping of a whole file.
+ */
+
+/**
+ * @class MappedFile
+ * @brief Maps a file read-only into memory (mmap, or CreateFileMapping on Windows).
+ *
+ * Pages are read by the OS on first touch, so opening is O(1) whatever the
+ * file size and unused parts are never read.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map `path`, replacing any previous mapping.
+     * @return false if the file cannot be opened or mapped (an empty file maps to Size() 0).
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief Unmap the file.
+     */
+    void Close();
+
+    const char* Data() const { return data_; }
+    std::size_t Size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;                  // HANDLE
+    void* mapping_ = nullptr;               // HANDLE
+#endif
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <IMovieBooker.hpp>
+#include <SeatBitmap.hpp>
+#include <BookingLog.hpp>
+#include <TimerWheel.hpp>
 
 #include <unordered_map>
 #include <map>
@@ -8,29 +11,136 @@
 #include <vector>
 #include <string>
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <utility>
 
 /**
  * @file MovieBooker.hpp
  * @brief In-memory implementation of `IMovieBooker`.
  *
  * This class provides a thread-safe, in-memory store of movies, theaters and
- * seat availability. Each theater supports a fixed number of seats (20).
+ * seat availability. Each theater has its own seat capacity (`AddTheater`);
+ * theaters created implicitly by `AddMovie` get the default capacity (20).
+ * Seat state of every showing is a lock-free `SeatBitmap`, so bookings and
+ * free-seat queries on the same showing never wait for each other.
+ *
+ * The movie/theater structure is an immutable, versioned `Catalog` snapshot
+ * published through an atomic pointer. Queries and bookings read it without
+ * taking any lock; `AddMovie` copies the current version (all of it, so a
+ * single change costs O(catalog)), applies the change and swaps the new
+ * version in. Replaced versions are freed once no reader can
+ * still be using them (see `EpochManager`). Catalog changes are expected to be
+ * rare compared to queries.
+ *
+ * Holds claim their seats in the showing's seat bitmap like a booking and
+ * also mark them in a second `held` bitmap next to it. The hold table is a slab
+ * of records recycled through a free list; a hold id packs the slot index
+ * with a generation counter, so stale ids are rejected. Deadlines go into a
+ * `TimerWheel` of kHoldTick resolution, which `ExpireHolds` advances: expiry
+ * costs O(holds expiring), regardless of how many are outstanding.
+ * Confirmed and released holds stay in the wheel and are skipped when their
+ * deadline comes.
+ *
+ * With a `BookingLog` attached every successful booking (book, batch, best
+ * seats, confirmed hold) is appended to it before the call returns; if the
+ * log cannot take the record the booking fails but its seats stay taken: the
+ * log accepts nothing after a failure, and a snapshot may already hold them.
+ *
+ * `WriteSnapshot` stores the catalog and booked seats in the binary layout of
+ * CatalogSnapshot.hpp, while bookings go on once `EnableConcurrentSnapshots`
+ * was called; `LoadSnapshot` maps such a file
+ * and builds the whole catalog from it in one pass and one publish, which
+ * is far cheaper than parsing the JSON and adding movies one at a time.
+ *
+ * `ReplaceCatalog` swaps in a reloaded catalog while bookings go on: it
+ * diffs the new catalog against the published one and publishes the result
+ * once. Showings that did not change keep their entry, and so their id and
+ * seat state. Removed showings leave a hole in the showing table, so ids
+ * are never reused.
+ */
+/**
+ * @brief What MovieBooker::ReplaceCatalog() changed.
  */
+struct CatalogDiff
+{
+    std::size_t added_showings = 0;
+    std::size_t removed_showings = 0;
+    std::size_t kept_showings = 0;      ///< unchanged, seat state preserved
+    std::size_t added_movies = 0;
+    std::size_t removed_movies = 0;     ///< movies left without any showing
+};
+
 class MovieBooker : public IMovieBooker 
 {
 public:
-    MovieBooker() = default;
-    ~MovieBooker() override = default;
+    static constexpr std::size_t kDefaultSeatsPerTheater = 20;
+    static constexpr std::chrono::milliseconds kHoldTick{ 10 };     ///< expiry resolution of holds
+    static constexpr unsigned int kSnapshotCopyAttempts = 100;      ///< tries to copy a changing showing before WriteSnapshot gives up
+    static constexpr unsigned int kBatchAttempts = 4;               ///< tries of BookBatch while its seats are only held by rolled back batches
+
+    /**
+     * @brief Construct an empty booker.
+     * @param seatsPerTheater Capacity of theaters not registered through AddTheater.
+     */
+    explicit MovieBooker(std::size_t seatsPerTheater = kDefaultSeatsPerTheater);
+    ~MovieBooker() override;
+
+    MovieBooker(const MovieBooker&) = delete;
+    MovieBooker& operator=(const MovieBooker&) = delete;
 
     /**
      * @brief Add a movie and associated theaters to the catalog.
+     *
+     * Costs O(catalog): the published version is copied whole, every index
+     * and per-movie table included, before the movie is added. Adding N
+     * movies one call at a time is therefore O(N^2); load catalogs with
+     * AddCatalog, which copies once per chunk.
      * @param movie Title of the movie (must not be empty).
      * @param theatres Vector of theater names showing the movie.
      * @return true on success, false for invalid input.
      */
     bool AddMovie(const std::string& movie, const std::vector<std::string>& theatres) override; 
 
+    /**
+     * @brief Register a theater and its seat capacity.
+     *
+     * Copies the whole catalog like AddMovie (O(catalog) per call); register
+     * many theaters through AddCatalog.
+     * @param theater Theater name (must not be empty).
+     * @param seats Seat capacity (must be > 0).
+     * @return true on success, false for invalid input or an already known theater.
+     */
+    bool AddTheater(const std::string& theater, std::size_t seats) override;
+
+    /**
+     * @brief Add many theaters and movies with one catalog copy and one publish.
+     *
+     * Tables are presized for the whole chunk and its showings are allocated
+     * as one block, so loading a large catalog costs no rehashing and one
+     * allocation per showing's seat bitmaps instead of a catalog copy per movie.
+     * @param chunk Theaters and movies to add.
+     * @return false if an entry was invalid or an already known theater; the other entries are still added.
+     */
+    bool AddCatalog(const CatalogChunk& chunk) override;
+
+    /**
+     * @brief Make the catalog match `chunk`, keeping the showings it still lists.
+     *
+     * Showings (movie and theater pairs) missing from `chunk` are removed and
+     * new ones added. Everything is published as one catalog version, so
+     * readers see the old or the new catalog and never a mix. Bookings never
+     * wait for the reload: a booking that found a showing just before it was
+     * removed still succeeds on the detached showing. Theaters stay known once
+     * added, and capacities in `chunk` only apply to new theaters, because
+     * existing showings keep their seats.
+     * @param chunk The complete new catalog.
+     * @param diff Receives what changed; may be null.
+     */
+    void ReplaceCatalog(const CatalogChunk& chunk, CatalogDiff* diff = nullptr);
+
     /**
      * @brief Return all known movie titles.
      * @return Vector of movie titles.
@@ -68,24 +178,324 @@ public:
      */
     bool BookSeats(const std::string& theater, const std::string& movie, const std::vector<unsigned int>& seatIds) override;
 
+    /**
+     * @brief Resolve a movie title to its id.
+     * @param movie Movie title.
+     * @return Movie id, or std::nullopt when the movie is unknown.
+     */
+    std::optional<MovieId> ResolveMovie(const std::string& movie) override;
+
+    /**
+     * @brief Resolve a theater name to its id.
+     * @param theater Theater name.
+     * @return Theater id, or std::nullopt when the theater is unknown.
+     */
+    std::optional<TheaterId> ResolveTheater(const std::string& theater) override;
+
+    /**
+     * @brief Resolve the showing of a movie in a theater.
+     * @param movie Movie id.
+     * @param theater Theater id.
+     * @return Showing id, or std::nullopt when the theater does not show the movie.
+     */
+    std::optional<ShowingId> ResolveShowing(MovieId movie, TheaterId theater) override;
+
+    /**
+     * @brief Return every movie with its id.
+     * @return Pairs of movie id and title.
+     */
+    std::vector<std::pair<MovieId, std::string>> GetMovieList() override;
+
+    /**
+     * @brief Return the theaters showing a movie, with their ids.
+     * @param movie Movie id.
+     * @return Pairs of theater id and name, empty for an unknown movie.
+     */
+    std::vector<std::pair<TheaterId, std::string>> GetTheaterList(MovieId movie) override;
+
+    /**
+     * @brief Return free seats of a showing; O(1) lookup, no string hashing.
+     * @param showing Showing id.
+     * @return Vector of 1-based free seat indices, empty for an unknown showing.
+     */
+    std::vector<unsigned int> GetFreeSeats(ShowingId showing) override;
+
+    /**
+     * @brief Attempt to book seats of a showing; O(1) lookup, no string hashing.
+     * @param showing Showing id.
+     * @param seatIds Vector of 1-based seat indices.
+     * @return true on successful booking, false otherwise.
+     */
+    bool BookSeats(ShowingId showing, const std::vector<unsigned int>& seatIds) override;
+
+    /**
+     * @brief Book the seats of several showings, all or nothing.
+     *
+     * Showings are claimed in ascending showing id order (items of the same
+     * showing merged into one claim) and the claims already made are released
+     * when a later one fails. Like multi-word claims in `SeatBitmap`, the fixed
+     * order means two overlapping batches cannot both succeed, and no batch
+     * waits on another; readers may briefly see seats of a batch that is then
+     * rolled back. A batch that fails while such a batch may hold its seats is
+     * retried, up to kBatchAttempts times in all.
+     * @param items Showings and seats to book.
+     * @return true if every item was booked, false if nothing was booked.
+     */
+    bool BookBatch(const std::vector<BookingItem>& items) override;
+
+    /**
+     * @brief Log every successful booking from now on; nullptr stops logging.
+     *
+     * Set it before the booker is shared between threads (after replaying
+     * the log, so replayed bookings are not logged twice).
+     */
+    void SetBookingLog(BookingLog* log);
+
+    /**
+     * @brief Let WriteSnapshot run while bookings go on.
+     *
+     * Every change of a showing's seats then bumps two counters of the
+     * showing, which WriteSnapshot checks to copy it between changes.
+     * Without it only batches bump them (see BookBatch) and WriteSnapshot
+     * must not overlap bookings. Call before the booker is shared between threads.
+     */
+    void EnableConcurrentSnapshots();
+
+    /**
+     * @brief Book the best `count` free seats of a showing (see SeatBitmap::ClaimBest).
+     * @param showing Showing id.
+     * @param count Number of seats.
+     * @param contiguous Require adjacent seats.
+     * @param seats Output booked seat ids.
+     * @return true on success.
+     */
+    bool BookBest(ShowingId showing, std::size_t count, bool contiguous, std::vector<unsigned int>& seats) override;
+
+    /**
+     * @brief Hold seats of a showing until confirmed, released or `ttl` has passed.
+     * @param showing Showing id.
+     * @param seatIds Vector of 1-based seat indices.
+     * @param ttl Time-to-live of the hold.
+     * @return Hold id, or std::nullopt if a seat is taken or invalid.
+     */
+    std::optional<HoldId> HoldSeats(ShowingId showing, const std::vector<unsigned int>& seatIds, std::chrono::milliseconds ttl) override;
+
+    /**
+     * @brief Book the seats of an active hold.
+     * @return false for an unknown, expired, confirmed or released hold.
+     */
+    bool ConfirmHold(HoldId hold) override;
+
+    /**
+     * @brief Free the seats of an active hold.
+     * @return false for an unknown, expired, confirmed or released hold.
+     */
+    bool ReleaseHold(HoldId hold) override;
+
+    /**
+     * @brief Advance the hold timer wheel to `now` and free the seats of expired holds.
+     * @return Number of holds that expired.
+     */
+    std::size_t ExpireHolds(std::chrono::steady_clock::time_point now) override;
+
+    /**
+     * @brief Return the number of active holds.
+     */
+    std::size_t GetHoldCount() const;
+
+    /**
+     * @brief Return the number of seats of a showing that are held (not booked).
+     */
+    std::size_t GetHeldSeatCount(ShowingId showing) const;
+
+    /**
+     * @brief Return the seat capacity of a showing.
+     * @param showing Showing id.
+     * @return Number of seats, 0 for an unknown showing.
+     */
+    std::size_t GetSeatCount(ShowingId showing) override;
+
+    /**
+     * @brief Return the version of the published catalog; it increases with every catalog change.
+     */
+    std::uint64_t GetCatalogVersion() const override;
+
+    /**
+     * @brief Write the catalog and booked seats to a snapshot file.
+     *
+     * Bookings continue while the seats are copied, so the snapshot is fuzzy:
+     * every booking logged before `logOffset` is in it, later ones may be.
+     * With EnableConcurrentSnapshots each showing is copied between changes,
+     * never halfway through a multi-word claim, a batch, a hold or its
+     * release; a showing that keeps changing through kSnapshotCopyAttempts
+     * tries, with growing pauses, fails the snapshot, to be retried later.
+     * Replaying the log from `logOffset` on top of the snapshot with
+     * RestoreSeats restores the state. Held
+     * seats are stored as free. The file is written next to `path` and
+     * renamed over it, so a crash never leaves a partial snapshot.
+     * @param path Snapshot file.
+     * @param logOffset BookingLog::AppendedBytes() read before the call, 0 without a log.
+     * @return false if the file could not be written or a showing could not be copied.
+     */
+    bool WriteSnapshot(const std::string& path, std::uint64_t logOffset) const;
+
+    /**
+     * @brief Replace the catalog and seat state with a snapshot.
+     *
+     * Meant for startup, before the booker is shared: showings of the
+     * replaced catalog stay valid but are no longer reachable.
+     * @param path Snapshot file written by WriteSnapshot.
+     * @param logOffset Receives the log offset stored in the snapshot.
+     * @return false if the file is missing or not a valid snapshot; the catalog is then unchanged.
+     */
+    bool LoadSnapshot(const std::string& path, std::uint64_t& logOffset);
+
+    /**
+     * @brief Book the seats of a replayed log record that are still free.
+     *
+     * Unlike BookSeats this works seat by seat, so a record that is already
+     * in a snapshot, wholly or in part, books only what is missing and can be
+     * replayed any number of times. Nothing is logged.
+     * @param theater Theater name from the record.
+     * @param movie Movie name from the record.
+     * @param seatIds Seats from the record; ids out of range are ignored.
+     * @return false if the showing is not in the catalog.
+     */
+    bool RestoreSeats(const std::string& theater, const std::string& movie, const std::vector<unsigned int>& seatIds);
+
 private:
-    
-	// map to cover unique theater names
-    std::unordered_map<std::string, std::size_t> theater_index_; // theater name -> index
+
+    // changes of a showing started and finished; WriteSnapshot copies it while they are equal
+    struct ChangeCount
+    {
+        std::atomic<std::uint64_t> started{ 0 };
+        std::atomic<std::uint64_t> finished{ 0 };
+        ChangeCount() = default;
+        ChangeCount(ChangeCount&&) noexcept {}      // entries only move before they are published
+    };
 
     // per-movie map of theater entries. Each entry represents a theater showing for that movie
     struct TheaterEntry 
     {
-        std::size_t theater_id;             // index into theaters_
-        std::mutex mutex;                   // protects seats for this movie showing in this theater
-        std::vector<bool> seats;            // true = booked
-        TheaterEntry(std::size_t tid, std::size_t seatCount)
-            : theater_id(tid), seats(seatCount, false) {}
+        MovieId movie_id;                   // index into movie_names
+        std::size_t theater_id;             // index into theater_index
+        SeatBitmap seats;                   // bit set = booked or held; lock-free
+        SeatBitmap held;                    // bit set = held, subset of seats
+        ChangeCount changes;                // brackets every batch, and with snapshots every change of seats and held
+        TheaterEntry(MovieId mid, std::size_t tid, std::size_t seatCount)
+            : movie_id(mid), theater_id(tid), seats(seatCount), held(seatCount) {}
+    };
+
+    // marks the changes of one showing's seats in progress for WriteSnapshot; does nothing unless `track`
+    class ChangeGuard
+    {
+    public:
+        ChangeGuard(TheaterEntry* entry, bool track) : entry_(track ? entry : nullptr)
+        {
+            if (entry_)
+                entry_->changes.started.fetch_add(1, std::memory_order_acquire);   // no seat change moves above it
+        }
+        ~ChangeGuard()
+        {
+            if (entry_)
+                entry_->changes.finished.fetch_add(1, std::memory_order_release);  // publishes the seat changes
+        }
+        ChangeGuard(const ChangeGuard&) = delete;
+        ChangeGuard& operator=(const ChangeGuard&) = delete;
+    private:
+        TheaterEntry* entry_;
+    };
+
+    // seats claimed in one showing
+    typedef std::pair<TheaterEntry*, const std::vector<unsigned int>*> Claim;
+
+    // one slot of the hold table
+    struct Hold
+    {
+        std::uint32_t generation = 1;       // bumped on every reuse; part of the HoldId
+        bool active = false;
+        TheaterEntry* entry = nullptr;
+        std::vector<unsigned int> seats;
+    };
+
+    // immutable once published
+    struct Catalog
+    {
+        std::uint64_t version = 0;
+
+        // map to cover unique theater names
+        std::unordered_map<std::string, TheaterId> theater_index; // theater name -> id
+        std::vector<std::size_t> theater_seats;                   // theater id -> seat capacity
+        std::vector<std::string> theater_names;                   // theater id -> name
+
+        std::unordered_map<std::string, MovieId> movie_index;     // movie name -> id
+        std::vector<std::string> movie_names;                     // movie id -> name
+
+        // movie name -> map of theater name -> showing id
+        std::unordered_map<std::string, std::unordered_map<std::string, ShowingId>> movie_theaters;
+
+        // movie id -> map of theater id -> showing id
+        std::vector<std::unordered_map<TheaterId, ShowingId>> movie_showings;
+
+        // showing id -> TheaterEntry (owned by a block of entries_); null once removed.
+        // Movies whose showings were all removed stay in movie_index and
+        // movie_names so they get their id back if they return.
+        std::vector<TheaterEntry*> showings;
     };
 
-    // movie name -> map of theater name -> TheaterEntry
-    std::unordered_map<std::string, std::unordered_map<std::string, std::unique_ptr<TheaterEntry>>> movie_theaters_;
+    // find the showing in the published catalog; call under an EpochManager::ReadGuard
+    TheaterEntry* FindShowing(const std::string& theater, const std::string& movie) const;
+    TheaterEntry* FindShowing(ShowingId showing) const;
+
+    // id of `theater` in `catalog`, registering it with `seats` capacity if unknown
+    static TheaterId EnsureTheater(Catalog& catalog, const std::string& theater, std::size_t seats);
+
+    // add a movie's showings to `next`, constructing new showings in `block`
+    // (reserved by the caller, so entries never move); map_mutex_ held
+    void AddShowings(Catalog& next, const std::string& movie, const std::vector<std::string>& theatres, std::vector<TheaterEntry>& block);
+
+    // append claims that succeeded to log_ as one record; false if the log failed
+    bool LogClaims(const Claim* claims, std::size_t count);
+
+    // free the seats of claims (rollback of a batch); the caller brackets the changes
+    static void ReleaseClaims(const Claim* claims, std::size_t count);
+
+    // whether a failed claim may have met seats of a batch that rolls back: its
+    // seats are free again or a change of the showing is in flight
+    static bool MayBeRolledBack(const Claim& claim);
 
-    // mutex protecting maps and vectors structure
+    // detach an active hold from the table and free its slot; hold_mutex_ held
+    bool TakeHold(HoldId hold, TheaterEntry*& entry, std::vector<unsigned int>& seats);
+
+    // wheel tick of a point in time, rounded up so holds never expire early
+    std::uint64_t ToTick(std::chrono::steady_clock::time_point time) const;
+
+    // swap `next` in as the published catalog and free versions no reader can see; map_mutex_ held
+    void Publish(std::unique_ptr<Catalog> next);
+
+    // published catalog, read lock-free
+    std::atomic<const Catalog*> catalog_;
+
+    // writers only: the published version, versions replaced but maybe still read (tagged with
+    // their retire epoch) and every showing ever created (entries outlive catalog versions).
+    // Showings created together share one block; a block is never resized once filled.
+    std::unique_ptr<const Catalog> current_;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<const Catalog>>> retired_;
+    std::vector<std::vector<TheaterEntry>> entries_;
+
+    // serializes catalog writers; never taken by queries or bookings
     std::mutex map_mutex_;
+
+    std::size_t seats_per_theater_;
+    BookingLog* log_ = nullptr;             // optional write-ahead log of bookings
+    bool track_changes_ = false;            // EnableConcurrentSnapshots() was called
+
+    // hold table, guarded by hold_mutex_
+    mutable std::mutex hold_mutex_;
+    std::vector<Hold> holds_;
+    std::vector<std::uint32_t> free_holds_;
+    std::size_t active_holds_ = 0;
+    TimerWheel hold_wheel_;
+    std::vector<std::uint64_t> expired_;    // scratch for ExpireHolds
+    const std::chrono::steady_clock::time_point hold_epoch_;    // tick 0 of hold_wheel_
 };
\ No newline at end of file
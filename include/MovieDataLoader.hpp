@@ -0,0 +1,114 @@
+#pragma once
+
+#include <MovieBooker.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file MovieDataLoader.hpp
+ * @brief Loads the movie catalog from one or more JSON files.
+ *
+ * Expected structure:
+ *
+ *     {
+ *       "theaters": [                                  (optional, per-theater seat capacity;
+ *         { "name": "T1", "seats": 2000 }               unlisted theaters get 20 seats)
+ *       ],
+ *       "movies": [
+ *         { "title": "Movie1", "theaters": ["T1","T2"] },
+ *         { "title": "Movie2", "theaters": ["T3"] }
+ *       ]
+ *     }
+ *
+ * Malformed entries (a movie without title, a theater without a positive
+ * seat count, ...) are skipped; unknown members are ignored.
+ *
+ * A catalog may be split over several files (a directory or a glob), which
+ * are parsed in parallel and merged in sorted path order, so showing and
+ * theater ids do not depend on which file finished first.
+ */
+
+/**
+ * @brief Where and why loading a catalog failed.
+ */
+struct CatalogLoadError
+{
+    std::string path;                       ///< file the error is in
+    std::string message;
+    std::size_t offset = 0;                 ///< byte offset in the file
+    std::size_t line = 0;                   ///< 1-based; 0 if the file could not be read
+    std::size_t column = 0;                 ///< 1-based, in bytes
+};
+
+/**
+ * @class MovieDataLoader
+ * @brief Stateless helpers filling a MovieBooker from a JSON catalog.
+ */
+class MovieDataLoader
+{
+public:
+    /**
+     * @brief Parse the whole file into a RapidJSON DOM, then add its movies in one AddCatalog.
+     *
+     * Peak memory is several times the file size. Theater capacities apply
+     * wherever "theaters" appears in the file.
+     * @return false if the file cannot be read or is not a catalog.
+     */
+    static bool LoadFromFile(const std::string& path, MovieBooker& booker);
+
+    /**
+     * @brief Stream the file through RapidJSON's SAX reader, adding movies in chunks as they are read.
+     *
+     * No DOM is built: besides one read buffer, memory holds the movies read
+     * since the last chunk was added (AddCatalog), which is never more than
+     * the booker already holds. A capacity only applies to theaters that no
+     * movie of an earlier chunk has used, so "theaters" should come before
+     * "movies" (the DOM loader applies them first regardless). On a syntax
+     * error the movies read so far stay in the booker.
+     * @param error Receives the message and the line / column of a failure; may be null.
+     * @return false if the file cannot be read, is malformed JSON or has no "movies" array.
+     */
+    static bool StreamFromFile(const std::string& path, MovieBooker& booker, CatalogLoadError* error = nullptr);
+
+    /**
+     * @brief Stream one file into `chunk` without adding anything to a booker.
+     * @param error Receives the path, message and line / column of a failure; may be null.
+     * @return false if the file cannot be read, is malformed JSON or has no "movies" array.
+     */
+    static bool ParseFile(const std::string& path, IMovieBooker::CatalogChunk& chunk, CatalogLoadError* error = nullptr);
+
+    /**
+     * @brief Turn a catalog argument into the files to load, sorted by path.
+     *
+     * A directory yields its *.json files (not recursive); a last component
+     * with '*' or '?' is matched against the files of its directory; anything
+     * else is taken as a single file, existing or not.
+     */
+    static std::vector<std::string> ExpandPaths(const std::string& spec);
+
+    /**
+     * @brief Parse files on up to `threads` threads and merge them into one chunk.
+     *
+     * The merged chunk holds the theaters of every file, then the movies of
+     * every file, each in the order of `paths`: capacities apply wherever
+     * they are declared, and the result is the same whatever the completion
+     * order. Files that fail contribute nothing.
+     * @param errors Receives one entry per failed file, in path order.
+     * @return false if any file failed.
+     */
+    static bool ParseFiles(const std::vector<std::string>& paths, unsigned int threads,
+                           IMovieBooker::CatalogChunk& merged, std::vector<CatalogLoadError>& errors);
+
+    /**
+     * @brief Load a catalog split over several files with one AddCatalog.
+     *
+     * A single file is streamed (StreamFromFile) instead, so it never needs
+     * the whole catalog in memory. The files that parsed are added even if
+     * others failed.
+     * @return false if `paths` is empty or any file failed.
+     */
+    static bool LoadFiles(const std::vector<std::string>& paths, unsigned int threads, MovieBooker& booker,
+                          std::vector<CatalogLoadError>& errors);
+};
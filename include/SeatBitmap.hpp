@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @file SeatBitmap.hpp
+ * @brief Lock-free seat state for one showing.
+ *
+ * Seats are stored as an array of atomic 64-bit words, one bit per seat
+ * (bit set = booked). Seat ids are 1-based as everywhere else in the service.
+ */
+
+/**
+ * @class SeatBitmap
+ * @brief Atomic seat bitmap with all-or-nothing multi-seat claims.
+ *
+ * Claiming a set of seats that lives in one word is a single compare-and-swap.
+ * Sets spanning several words fall back to claiming word by word in ascending
+ * order, rolling back the words already claimed when a later word conflicts.
+ * Because every claimer walks words in the same order, two overlapping claims
+ * cannot both succeed; a reader may briefly observe seats of a claim that is
+ * then rolled back. Readers never block writers: free seats are found with
+ * popcount/count-trailing-zeros scans over a word-by-word snapshot.
+ */
+class SeatBitmap
+{
+public:
+    static constexpr std::size_t kBitsPerWord = 64;
+
+    /**
+     * @brief Create a bitmap with all seats free.
+     * @param seats Number of seats in the showing.
+     */
+    explicit SeatBitmap(std::size_t seats);
+
+    SeatBitmap(const SeatBitmap&) = delete;
+    SeatBitmap& operator=(const SeatBitmap&) = delete;
+
+    /**
+     * @brief Take over the words of a bitmap no other thread uses yet (e.g. when filling a container).
+     */
+    SeatBitmap(SeatBitmap&&) noexcept = default;
+
+    /**
+     * @brief Return the number of seats.
+     */
+    std::size_t Size() const { return seats_; }
+
+    /**
+     * @brief Atomically book all given seats, or none of them.
+     * @param seatIds 1-based seat ids.
+     * @param count Number of ids.
+     * @return false when an id is out of range or repeated, or a seat is already booked.
+     */
+    bool TryClaim(const unsigned int* seatIds, std::size_t count);
+
+    /**
+     * @brief Free seats previously claimed by the caller.
+     * @param seatIds 1-based seat ids; out of range ids are ignored.
+     * @param count Number of ids.
+     */
+    void Release(const unsigned int* seatIds, std::size_t count);
+
+    /**
+     * @brief Return true if the seat is booked (false for out of range ids).
+     */
+    bool IsBooked(unsigned int seatId) const;
+
+    /**
+     * @brief Append the 1-based ids of all free seats to `out`, in ascending order.
+     *
+     * Works a word at a time on a snapshot of the bitmap: popcount sizes the
+     * output once, fully free words are filled without bit scanning and the
+     * rest are walked with count-trailing-zeros.
+     */
+    void CollectFree(std::vector<unsigned int>& out) const;
+
+    /**
+     * @brief Return the number of free seats.
+     */
+    std::size_t CountFree() const;
+
+    /**
+     * @brief Return the number of 64-bit words backing the bitmap.
+     */
+    std::size_t WordCount() const { return word_count_; }
+
+    /**
+     * @brief Copy the raw words (bit set = booked) to out[0..WordCount()).
+     *
+     * Each word is read atomically; the copy as a whole is not a consistent
+     * snapshot while claims are running.
+     */
+    void StoreWords(std::uint64_t* out) const;
+
+    /**
+     * @brief Overwrite the seat state with raw words from StoreWords().
+     *
+     * Bits beyond Size() are ignored. Only for bitmaps not yet shared with
+     * other threads (e.g. while loading a snapshot).
+     */
+    void LoadWords(const std::uint64_t* words);
+
+    /**
+     * @brief Find and book `count` free seats in one step.
+     *
+     * Prefers the lowest block of `count` adjacent seats (which may cross word
+     * boundaries); without one, and unless `contiguous` is set, takes the
+     * lowest free seats. The search runs on a snapshot with count-trailing-zeros
+     * jumps over free and booked runs; the chosen seats are then claimed with
+     * TryClaim(). Losing a race to another claimer retries on a fresh snapshot;
+     * after kMaxBestAttempts lost races the call takes turns with the other
+     * ClaimBest callers of the bitmap (a lock shared with few other bitmaps)
+     * and retries until it succeeds, so contention alone never fails it.
+     *
+     * It still fails when a snapshot shows fewer than `count` free seats
+     * (or no block, with `contiguous`) only because a concurrent multi-word
+     * TryClaim() holds seats it is about to roll back, which a retry a moment
+     * later could have booked.
+     * @param count Number of seats wanted.
+     * @param contiguous Fail rather than book scattered seats.
+     * @param seats Cleared, then receives the booked 1-based ids in ascending order.
+     * @return false (and `seats` empty) if not enough free seats are available.
+     */
+    bool ClaimBest(std::size_t count, bool contiguous, std::vector<unsigned int>& seats);
+
+private:
+    static constexpr unsigned int kMaxBestAttempts = 64;   // lost races before ClaimBest takes its lock
+
+    enum class BestResult { Claimed, Lost, Unavailable };
+
+    // one ClaimBest search and claim on a fresh snapshot in free[0..word_count_)
+    BestResult ClaimBestOnce(std::size_t count, bool contiguous, std::uint64_t* free, std::vector<unsigned int>& seats);
+
+    // fill free[0..word_count_) with the free-seat masks; returns the number of free seats
+    std::size_t LoadFree(std::uint64_t* free) const;
+
+    // claim `mask` in word `index`; false if any bit of mask is already set
+    bool ClaimWord(std::size_t index, std::uint64_t mask);
+
+    // mask of valid seat bits in word `index` (the last word may be partial)
+    std::uint64_t ValidMask(std::size_t index) const;
+
+    std::size_t seats_;
+    std::size_t word_count_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <CommandParser.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file ServerMetrics.hpp
+ * @brief Request counters and latency histograms of the server.
+ */
+
+/**
+ * @brief Merged view of every thread's counters, taken by ServerMetrics::Snapshot().
+ */
+struct MetricsSnapshot
+{
+    static constexpr std::size_t kCommands = static_cast<std::size_t>(Command::Stats) + 1;
+    static constexpr std::size_t kBuckets = 32;     ///< bucket b: latencies below 2^b ns; the last one takes the rest
+
+    struct CommandStats
+    {
+        std::uint64_t count = 0;                    ///< commands served
+        std::uint64_t samples = 0;                  ///< of which latency was measured
+        std::uint64_t latency_ns = 0;               ///< sum over the samples
+        std::array<std::uint64_t, kBuckets> buckets{};
+    };
+
+    std::array<CommandStats, kCommands> commands{};
+    std::uint64_t booked = 0;                       ///< booking commands that booked their seats
+    std::uint64_t conflicts = 0;                    ///< booking commands refused because seats were taken
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t accepted = 0;                     ///< sessions admitted
+    std::uint64_t rejected = 0;                     ///< sessions refused at max-connections
+    std::size_t live_connections = 0;               ///< filled in by the server
+    std::size_t peak_connections = 0;
+
+    /**
+     * @brief Return the upper bound in ns of the bucket holding quantile `q` of a command's samples, 0 without samples.
+     */
+    std::uint64_t Quantile(Command command, double q) const;
+};
+
+/**
+ * @class ServerMetrics
+ * @brief Low-overhead counters for the request path, merged on read.
+ *
+ * Every thread that records gets its own cache-line aligned shard on first
+ * use. A shard is only written by its thread, with relaxed loads and stores
+ * (no read-modify-write), so recording is a few plain increments with no
+ * sharing between threads. Snapshot() sums the shards; shards of threads
+ * that have exited keep counting towards the totals.
+ *
+ * Counts are exact. Reading the clock costs more than the rest of a
+ * book_seats, so latency is measured for one in `latencySample` commands of
+ * each kind per thread, the first one included. The histograms hold those
+ * samples, in log2 buckets of nanoseconds.
+ */
+class ServerMetrics
+{
+public:
+    static constexpr std::uint32_t kDefaultLatencySample = 16;
+
+    /**
+     * @param latencySample Measure the latency of every n-th command; rounded up to a power of two, 0 is taken as 1.
+     */
+    explicit ServerMetrics(std::uint32_t latencySample = kDefaultLatencySample);
+    ~ServerMetrics();
+
+    ServerMetrics(const ServerMetrics&) = delete;
+    ServerMetrics& operator=(const ServerMetrics&) = delete;
+
+    /**
+     * @brief Count a command.
+     * @return true if its latency should be measured and passed to RecordLatency().
+     */
+    bool CountCommand(Command command)
+    {
+        Shard &shard = LocalShard();
+        const std::uint64_t n = shard.count[Index(command)].load(std::memory_order_relaxed);
+        shard.count[Index(command)].store(n + 1, std::memory_order_relaxed);
+        return (n & sample_mask_) == 0;
+    }
+
+    /**
+     * @brief Add a measured latency to a command's histogram.
+     */
+    void RecordLatency(Command command, std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Count the outcome of a booking command: seats booked, or refused because they were taken.
+     */
+    void CountBooking(bool booked) { Bump(booked ? LocalShard().booked : LocalShard().conflicts, 1); }
+
+    void CountBytesIn(std::size_t bytes) { Bump(LocalShard().bytes_in, bytes); }
+    void CountBytesOut(std::size_t bytes) { Bump(LocalShard().bytes_out, bytes); }
+
+    /**
+     * @brief Count a session accepted (`admitted`) or refused at the connection limit.
+     */
+    void CountSession(bool admitted) { Bump(admitted ? LocalShard().accepted : LocalShard().rejected, 1); }
+
+    /**
+     * @brief Sum the counters of every thread; connection gauges are left at 0.
+     */
+    MetricsSnapshot Snapshot() const;
+
+    /**
+     * @brief Number of threads that have counted into this instance.
+     */
+    std::size_t ThreadCount() const;
+
+    /**
+     * @brief Return the text protocol's name of a command ("unknown" for Command::Unknown).
+     */
+    static std::string_view CommandName(Command command);
+
+    /**
+     * @brief Reply of the "stats" command: one line per command served, then totals and an empty line.
+     */
+    static std::string FormatText(const MetricsSnapshot& snapshot);
+
+    /**
+     * @brief Prometheus text exposition format (version 0.0.4) of a snapshot.
+     */
+    static std::string FormatPrometheus(const MetricsSnapshot& snapshot);
+
+private:
+    typedef std::atomic<std::uint64_t> Counter;
+
+    struct alignas(64) Shard
+    {
+        std::array<Counter, MetricsSnapshot::kCommands> count{};
+        std::array<Counter, MetricsSnapshot::kCommands> samples{};
+        std::array<Counter, MetricsSnapshot::kCommands> latency_ns{};
+        std::array<std::array<Counter, MetricsSnapshot::kBuckets>, MetricsSnapshot::kCommands> buckets{};
+        Counter booked{ 0 }, conflicts{ 0 }, bytes_in{ 0 }, bytes_out{ 0 }, accepted{ 0 }, rejected{ 0 };
+    };
+
+    static std::size_t Index(Command command) { return static_cast<std::size_t>(command); }
+
+    // single writer: no read-modify-write needed
+    static void Bump(Counter& counter, std::uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // the calling thread's shard of this instance, registered on first use
+    Shard& LocalShard()
+    {
+        if (!local_.empty() && local_.front().id == id_)
+            return *local_.front().shard;
+        return FindShard();
+    }
+    Shard& FindShard();
+
+    struct LocalEntry
+    {
+        std::uint64_t id;                   // instance the shard belongs to; ids are never reused
+        Shard* shard;
+    };
+    // one entry per instance this thread has counted into, the last one used first
+    static thread_local std::vector<LocalEntry> local_;
+
+    const std::uint64_t id_;
+    const std::uint64_t sample_mask_;
+    mutable std::mutex mutex_;              // guards shards_; taken once per thread and by Snapshot()
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file TimerWheel.hpp
+ * @brief Hierarchical timer wheel for large numbers of coarse timeouts.
+ */
+
+/**
+ * @class TimerWheel
+ * @brief Schedules ids for expiry at a tick and reports them once the tick is reached.
+ *
+ * Four levels of 64 slots each cover 64^4 (about 16.7 million) ticks; later
+ * deadlines are clamped to that horizon. Level 0 holds deadlines within the
+ * next 64 ticks, one slot per tick. Each higher level slot covers 64 slots of
+ * the level below and is cascaded down when the wheel reaches it. Scheduling
+ * is O(1), and advancing by one tick costs O(1) plus the entries it expires or
+ * cascades, however many timers are pending. There is no cancellation:
+ * owners ignore ids they no longer care about when those expire (lazy
+ * cancellation).
+ *
+ * Not thread-safe; the owner serializes access.
+ */
+class TimerWheel
+{
+public:
+    static constexpr unsigned int kLevels = 4;
+    static constexpr unsigned int kSlotBits = 6;
+    static constexpr std::size_t kSlots = std::size_t(1) << kSlotBits;
+    static constexpr std::uint64_t kHorizon = std::uint64_t(1) << (kSlotBits * kLevels);   ///< ticks covered
+
+    /**
+     * @brief Create an empty wheel whose current tick is `start`.
+     */
+    explicit TimerWheel(std::uint64_t start = 0);
+
+    /**
+     * @brief Schedule `id` to expire at `deadline`.
+     *
+     * Deadlines not after the current tick expire on the next tick; deadlines
+     * beyond the horizon are clamped to it.
+     */
+    void Schedule(std::uint64_t id, std::uint64_t deadline);
+
+    /**
+     * @brief Advance the wheel to tick `now`, appending the ids that expired.
+     * @param now Target tick; ignored if not after the current tick.
+     * @param expired Receives the expired ids, in deadline order.
+     */
+    void Advance(std::uint64_t now, std::vector<std::uint64_t>& expired);
+
+    /**
+     * @brief Return the current tick.
+     */
+    std::uint64_t Now() const { return now_; }
+
+    /**
+     * @brief Return the number of scheduled ids (including ones the owner no longer tracks).
+     */
+    std::size_t Size() const { return size_; }
+
+private:
+    struct Entry
+    {
+        std::uint64_t id;
+        std::uint64_t deadline;
+    };
+
+    // place an entry relative to now_ (deadline >= now_)
+    void Insert(const Entry& entry);
+
+    std::array<std::array<std::vector<Entry>, kSlots>, kLevels> slots_;
+    std::vector<Entry> cascade_;            // scratch for the slot being cascaded
+    std::uint64_t now_;
+    std::size_t size_ = 0;
+};
@@ -1,4 +1,6 @@
 #include <AsioClient.hpp>
+#include <algorithm>
+#include <array>
 
 AsioClient::AsioClient() : socket_(io_context_)
 {
@@ -21,30 +23,133 @@ bool AsioClient::Connect(const std::string& host, const std::string& port)
 
 std::string AsioClient::ReadLine()
 {
-	boost::asio::streambuf buf;
+	std::string line;
+	read_line(line);
+	return line;
+}
+
+void AsioClient::WriteLine(const std::string& msg)
+{
+	// gather the message and its line ending instead of copying them together
+	const std::array<boost::asio::const_buffer, 2> buffers = { boost::asio::buffer(msg), boost::asio::buffer("\n", 1) };
 	try {
-		boost::asio::read_until(socket_, buf, '\n');
+		boost::asio::write(socket_, buffers);
 	}
-	catch (boost::system::system_error& e) {
-		return "";
+	catch (boost::system::system_error& e)
+	{
+
 	}
+}
 
-	std::istream is(&buf);
+bool AsioClient::EnterBinaryMode()
+{
+	WriteLine("binary");
 	std::string line;
-	std::getline(is, line);
-	if (!line.empty() && line.back() == '\r') // handle carriage return on Windows
-		line.pop_back();
-	return line;
+	while (read_line(line))
+	{
+		if (line == "OK binary")
+			return true;
+	}
+	return false;
 }
 
-void AsioClient::WriteLine(const std::string& msg)
+bool AsioClient::read_line(std::string& line)
+{
+	line.clear();
+	std::size_t size;
+	try {
+		size = boost::asio::read_until(socket_, read_buffer_, '\n');
+	}
+	catch (boost::system::system_error& e) {
+		return false;
+	}
+
+	// the line is at the front of read_buffer_; what follows it stays there for the next read
+	const char* data = static_cast<const char*>(read_buffer_.data().data());
+	std::size_t length = size - 1;
+	if (length && data[length - 1] == '\r') // handle carriage return on Windows
+		--length;
+	line.assign(data, length);
+	read_buffer_.consume(size);
+	return true;
+}
+
+FrameStatus AsioClient::Request(Opcode opcode, const std::string& payload, std::string& response)
 {
-	std::string out_msg = msg + "\n";
+	const std::uint32_t requestId = next_request_id_++;
+	std::string frame;
+	frame.reserve(BinaryProtocol::kHeaderSize + payload.size());
+	const std::size_t start = BinaryProtocol::BeginFrame(frame, static_cast<std::uint16_t>(opcode), requestId);
+	frame += payload;
+	BinaryProtocol::EndFrame(frame, start, FrameStatus::Ok);
+
 	try {
-		boost::asio::write(socket_, boost::asio::buffer(out_msg));
+		boost::asio::write(socket_, boost::asio::buffer(frame));
+
+		// header first, then exactly its payload; extra bytes stay in read_buffer_
+		if (read_buffer_.size() < BinaryProtocol::kHeaderSize)
+			boost::asio::read(socket_, read_buffer_, boost::asio::transfer_at_least(BinaryProtocol::kHeaderSize - read_buffer_.size()));
+		FrameHeader header;
+		BinaryProtocol::DecodeHeader(std::string_view(static_cast<const char*>(read_buffer_.data().data()), BinaryProtocol::kHeaderSize), header);
+		const std::size_t total = BinaryProtocol::kHeaderSize + header.length;
+		if (read_buffer_.size() < total)
+			boost::asio::read(socket_, read_buffer_, boost::asio::transfer_at_least(total - read_buffer_.size()));
+
+		const char* data = static_cast<const char*>(read_buffer_.data().data());
+		response.assign(data + BinaryProtocol::kHeaderSize, header.length);
+		read_buffer_.consume(total);
+
+		if (header.request_id != requestId || header.opcode != (static_cast<std::uint16_t>(opcode) | BinaryProtocol::kResponseFlag))
+			return FrameStatus::ConnectionError;		// out of sync with the server
+		return header.status;
 	}
 	catch (boost::system::system_error& e)
 	{
-
+		return FrameStatus::ConnectionError;
 	}
 }
+
+FrameStatus AsioClient::ListMovies(std::vector<std::pair<std::uint32_t, std::string>>& movies)
+{
+	std::string response;
+	FrameStatus status = Request(Opcode::ListMovies, std::string(), response);
+	FrameReader in(response);
+	if (status == FrameStatus::Ok && !BinaryProtocol::ReadNameList(in, movies))
+		status = FrameStatus::ConnectionError;
+	return status;
+}
+
+FrameStatus AsioClient::ListTheaters(std::uint32_t movie, std::vector<std::pair<std::uint32_t, std::string>>& theaters)
+{
+	std::string payload, response;
+	BinaryProtocol::AppendU32(payload, movie);
+	FrameStatus status = Request(Opcode::ListTheaters, payload, response);
+	FrameReader in(response);
+	if (status == FrameStatus::Ok && !BinaryProtocol::ReadNameList(in, theaters))
+		status = FrameStatus::ConnectionError;
+	return status;
+}
+
+FrameStatus AsioClient::GetFreeSeats(std::uint32_t movie, std::uint32_t theater, std::vector<unsigned int>& seats)
+{
+	std::string payload, response;
+	BinaryProtocol::AppendU32(payload, movie);
+	BinaryProtocol::AppendU32(payload, theater);
+	FrameStatus status = Request(Opcode::GetFreeSeats, payload, response);
+	FrameReader in(response);
+	if (status == FrameStatus::Ok && !BinaryProtocol::ReadSeatBitmap(in, seats))
+		status = FrameStatus::ConnectionError;
+	return status;
+}
+
+FrameStatus AsioClient::BookSeats(std::uint32_t movie, std::uint32_t theater, const std::vector<unsigned int>& seats)
+{
+	std::string payload, response;
+	BinaryProtocol::AppendU32(payload, movie);
+	BinaryProtocol::AppendU32(payload, theater);
+	unsigned int highest = 0;
+	for (unsigned int seat : seats)
+		highest = std::max(highest, seat);
+	BinaryProtocol::AppendSeatBitmap(payload, seats, highest);
+	return Request(Opcode::BookSeats, payload, response);
+}
@@ -1,12 +1,76 @@
 #include <AsioServer.hpp>
+#include <CommandParser.hpp>
+#include <BinaryProtocol.hpp>
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <charconv>
 
 
 using boost::asio::ip::tcp;
 
-constexpr char list_message[] = "Hello! Input command(\"list_movies\", \"select_movie <name>\", \"list_theaters\", \"select_theater <name>\", \"get_free_seats\", \"book_seat <s1,s2,..>\")\n\n";
+constexpr char list_message[] = "Hello! Input command(\"list_movies\", \"select_movie <name>\", \"list_theaters\", \"select_theater <name>\", \"get_free_seats\", \"book_seat <s1,s2,..>\", \"book_best <n> [contiguous]\", \"book_batch <movie>|<theater>|<s1,s2,..>;...\", \"hold_seats <s1,s2,..>\", \"confirm_hold <id>\", \"release_hold <id>\", \"stats\")\n\n";
 constexpr char invalid_cmd_message[] = "Error! Enter a valid command\n";
+constexpr char busy_message[] = "Error! Server busy, try again later\n";
+
+namespace
+{
+    constexpr std::size_t kMaxAdminRequest = 8 * 1024;
+
+    // the text command a binary request is counted as
+    Command frame_command(std::uint16_t opcode)
+    {
+        switch (static_cast<Opcode>(opcode))
+        {
+        case Opcode::ListMovies:   return Command::ListMovies;
+        case Opcode::ListTheaters: return Command::ListTheaters;
+        case Opcode::GetFreeSeats: return Command::GetFreeSeats;
+        case Opcode::BookSeats:    return Command::BookSeats;
+        case Opcode::BookBatch:    return Command::BookBatch;
+        case Opcode::HoldSeats:    return Command::HoldSeats;
+        case Opcode::ConfirmHold:  return Command::ConfirmHold;
+        case Opcode::ReleaseHold:  return Command::ReleaseHold;
+        case Opcode::BookBest:     return Command::BookBest;
+        }
+        return Command::Unknown;
+    }
+
+    // one HTTP exchange on the admin port: read the request head, answer, close
+    class admin_session : public std::enable_shared_from_this<admin_session>
+    {
+    public:
+        admin_session(tcp::socket socket, std::function<std::string()> metrics)
+            : socket_(std::move(socket)), metrics_(std::move(metrics))
+        {
+        }
+
+        void start()
+        {
+            boost::asio::async_read_until(socket_, boost::asio::dynamic_buffer(request_, kMaxAdminRequest), "\r\n\r\n",
+                [self = shared_from_this()](const boost::system::error_code& error, std::size_t) { self->respond(error); });
+        }
+
+    private:
+        void respond(const boost::system::error_code& error)
+        {
+            if (error)
+                return;                             // closed, or a request head over kMaxAdminRequest
+            const bool metrics = request_.compare(0, 13, "GET /metrics ") == 0 || request_.compare(0, 13, "GET /metrics?") == 0;
+            const std::string body = metrics ? metrics_() : "Not found\n";
+            response_.append(metrics ? "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n" : "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n")
+                .append("Content-Length: ").append(std::to_string(body.size())).append("\r\nConnection: close\r\n\r\n").append(body);
+            boost::asio::async_write(socket_, boost::asio::buffer(response_),
+                [self = shared_from_this()](const boost::system::error_code&, std::size_t) {
+                    boost::system::error_code ignored;
+                    self->socket_.shutdown(tcp::socket::shutdown_both, ignored);
+                });
+        }
+
+        tcp::socket socket_;
+        std::function<std::string()> metrics_;
+        std::string request_, response_;
+    };
+}
 
 tcp_connection::pointer tcp_connection::create(boost::asio::io_context& io_context_, IMovieBooker& booker)
 {
@@ -23,212 +87,779 @@ tcp::socket& tcp_connection::socket()
     return socket_;
 }
 
- void tcp_connection::start()
- {
-    write_out(std::string(list_message));
- }
+// constant replies shared by every session and queued without copying
+static const tcp_connection::buffer_ptr greeting_buffer = std::make_shared<const std::string>(list_message);
+static const tcp_connection::buffer_ptr busy_buffer = std::make_shared<const std::string>(busy_message);
+
+void tcp_connection::start()
+{
+    // the accept handler is not running on this connection's strand; hop onto it first
+    boost::asio::dispatch(socket_.get_executor(), [self = shared_from_this()]()
+    {
+        self->enqueue(greeting_buffer);
+        self->start_read();
+    });
+}
+
+void tcp_connection::reject()
+{
+    boost::asio::dispatch(socket_.get_executor(), [self = shared_from_this()]()
+    {
+        self->rejecting_ = true;
+        self->enqueue(busy_buffer);
+    });
+}
+
+void tcp_connection::close()
+{
+    if (closed_)
+        return;
+    closed_ = true;
+
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    if (registry_)
+        registry_->release(slot_);
+}
+
+void tcp_connection::set_hold_ttl(std::chrono::milliseconds ttl)
+{
+    hold_ttl_ = ttl;
+}
+
+void tcp_connection::set_metrics(ServerMetrics* metrics)
+{
+    metrics_ = metrics;
+}
+
+void tcp_connection::set_listings(ListingCache* listings)
+{
+    listings_ = listings;
+}
+
+void tcp_connection::reset()
+{
+    command_buffer.clear();                 // clear() keeps the reserved capacity
+    out_buffer.clear();
+    out_queue_.clear();
+    in_flight_.clear();
+    gather_.clear();
+    queued_bytes_ = 0;
+    reading_ = false;
+    writing_ = false;
+    binary_ = false;
+    last_movie.clear();
+    last_theater.clear();
+    movie_id.reset();
+    theater_id.reset();
+    showing_id.reset();
+    seat_count = 0;
+    closed_ = false;
+    rejecting_ = false;
+    buffered_ = 0;
+}
 
 
 tcp_connection::tcp_connection(boost::asio::io_context &io_context_, IMovieBooker &booker)
-        : socket_(io_context_), booker_(booker)
+        : socket_(boost::asio::make_strand(io_context_)), booker_(booker)
 {
     command_buffer.reserve(1024);
 	out_buffer.reserve(1024);
 }
 
-void tcp_connection::handle_write_end(const boost::system::error_code& error, size_t size)
+void tcp_connection::start_read()
 {
-    if (!error)
+    reading_ = true;
+    if (binary_)
     {
-       boost::asio::async_read_until(socket_,
-            boost::asio::dynamic_buffer(command_buffer), '\n',
+        // frames carry their own length; take whatever arrives
+        boost::asio::async_read(socket_,
+            boost::asio::dynamic_buffer(command_buffer), boost::asio::transfer_at_least(1),
             std::bind(&tcp_connection::handle_read_end, shared_from_this(),
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+        return;
+    }
+    boost::asio::async_read_until(socket_,
+        boost::asio::dynamic_buffer(command_buffer), '\n',
+        std::bind(&tcp_connection::handle_read_end, shared_from_this(),
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred));
+}
+
+void tcp_connection::handle_read_end(const boost::system::error_code& error, std::size_t)
+{
+    reading_ = false;
+    if (closed_)
+        return;
+    if (error)
+    {
+        // the client stopped sending; still deliver the replies already queued
+        rejecting_ = true;
+        if (!writing_)
+            close();
+        return;
+    }
+
+    if (metrics_)
+        metrics_->CountBytesIn(command_buffer.size() - buffered_);
+    process_input();
+}
+
+void tcp_connection::process_input()
+{
+    // drain the complete lines (or frames) buffered so far; the replies
+    // accumulate in out_buffer and are queued together as one buffer. Stop at
+    // the high-water mark: the rest stays in command_buffer until the client
+    // has read enough replies (handle_write_end resumes here)
+    std::size_t consumed = 0, eol;
+    while (!binary_ && !paused() && (eol = command_buffer.find('\n', consumed)) != std::string::npos)
+    {
+        handle_command(std::string_view(command_buffer.data() + consumed, eol - consumed));
+        consumed = eol + 1;
+    }
+    if (binary_)
+        consumed = drain_frames(consumed);  // bytes after the "binary" line are already frames
+    command_buffer.erase(0, consumed);      // keep unprocessed and partial lines or frames for later
+    buffered_ = command_buffer.size();
+    flush_out_buffer();
+
+    // backpressure: a client that does not read its replies stops being read
+    if (!paused() && !rejecting_)
+        start_read();
+}
+
+std::size_t tcp_connection::drain_frames(std::size_t offset)
+{
+    FrameHeader header;
+    while (!paused() && BinaryProtocol::DecodeHeader(std::string_view(command_buffer).substr(offset), header))
+    {
+        if (header.length > BinaryProtocol::kMaxPayload)
+        {
+            // the stream cannot be resynchronized: answer once and end the session
+            BinaryProtocol::EndFrame(out_buffer,
+                BinaryProtocol::BeginFrame(out_buffer, header.opcode | BinaryProtocol::kResponseFlag, header.request_id),
+                FrameStatus::BadRequest);
+            rejecting_ = true;
+            return command_buffer.size();
+        }
+        if (command_buffer.size() - offset - BinaryProtocol::kHeaderSize < header.length)
+            break;                          // payload not complete yet
+
+        handle_frame(header, std::string_view(command_buffer.data() + offset + BinaryProtocol::kHeaderSize, header.length));
+        offset += BinaryProtocol::kHeaderSize + header.length;
+    }
+    return offset;
+}
+
+void tcp_connection::handle_frame(const FrameHeader& request, std::string_view payload)
+{
+    // counted like the text command; latency is sampled (see ServerMetrics)
+    const Command command = frame_command(request.opcode);
+    const bool timed = metrics_ && metrics_->CountCommand(command);
+    const auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    FrameReader in(payload);
+    const std::size_t frame = BinaryProtocol::BeginFrame(out_buffer, request.opcode | BinaryProtocol::kResponseFlag, request.request_id);
+    FrameStatus status = FrameStatus::Ok;
+
+    switch (static_cast<Opcode>(request.opcode))
+    {
+    case Opcode::ListMovies:
+        if (!in.AtEnd())
+            status = FrameStatus::BadRequest;
+        else
+            BinaryProtocol::AppendNameList(out_buffer, booker_.GetMovieList());
+        break;
+    case Opcode::ListTheaters:
+    {
+        const IMovieBooker::MovieId movie = in.U32();
+        if (!in.Ok() || !in.AtEnd())
+            status = FrameStatus::BadRequest;
+        else
+            BinaryProtocol::AppendNameList(out_buffer, booker_.GetTheaterList(movie));
+        break;
+    }
+    case Opcode::GetFreeSeats:
+    case Opcode::BookSeats:
+    case Opcode::HoldSeats:
+    {
+        const Opcode opcode = static_cast<Opcode>(request.opcode);
+        const IMovieBooker::MovieId movie = in.U32();
+        const IMovieBooker::TheaterId theater = in.U32();
+        bool wellFormed = true;
+        if (opcode != Opcode::GetFreeSeats)
+            wellFormed = BinaryProtocol::ReadSeatBitmap(in, seat_buffer);
+        if (!wellFormed || !in.Ok() || !in.AtEnd())
+        {
+            status = FrameStatus::BadRequest;
+            break;
+        }
+
+        const auto showing = booker_.ResolveShowing(movie, theater);
+        if (!showing)
+        {
+            status = FrameStatus::UnknownShowing;
+            break;
+        }
+        const std::size_t seats = booker_.GetSeatCount(*showing);
+
+        if (opcode == Opcode::GetFreeSeats)
+            BinaryProtocol::AppendSeatBitmap(out_buffer, booker_.GetFreeSeats(*showing), seats);
+        else if (seat_buffer.empty() || seat_buffer.back() > seats)     // ids come out ascending
+            status = FrameStatus::InvalidSeats;
+        else if (opcode == Opcode::BookSeats)
+        {
+            if (!booker_.BookSeats(*showing, seat_buffer))
+                status = FrameStatus::SeatsUnavailable;
+        }
+        else if (const auto hold = booker_.HoldSeats(*showing, seat_buffer, hold_ttl_))
+            BinaryProtocol::AppendU64(out_buffer, *hold);
+        else
+            status = FrameStatus::SeatsUnavailable;
+        break;
+    }
+    case Opcode::BookBatch:
+    {
+        const std::uint32_t count = in.U32();
+        batch_buffer.clear();
+        for (std::uint32_t i = 0; i < count && in.Ok() && status == FrameStatus::Ok; ++i)
+        {
+            const IMovieBooker::MovieId movie = in.U32();
+            const IMovieBooker::TheaterId theater = in.U32();
+            if (!BinaryProtocol::ReadSeatBitmap(in, seat_buffer) || !in.Ok())
+            {
+                status = FrameStatus::BadRequest;
+                break;
+            }
+            const auto showing = booker_.ResolveShowing(movie, theater);
+            if (!showing)
+                status = FrameStatus::UnknownShowing;
+            else if (seat_buffer.empty() || seat_buffer.back() > booker_.GetSeatCount(*showing))
+                status = FrameStatus::InvalidSeats;
+            else
+                batch_buffer.push_back({ *showing, seat_buffer });
+        }
+        if (status != FrameStatus::Ok)
+            break;
+        if (!in.Ok() || !in.AtEnd() || batch_buffer.empty())
+            status = FrameStatus::BadRequest;
+        else if (!booker_.BookBatch(batch_buffer))
+            status = FrameStatus::SeatsUnavailable;
+        break;
+    }
+    case Opcode::BookBest:
+    {
+        const IMovieBooker::MovieId movie = in.U32();
+        const IMovieBooker::TheaterId theater = in.U32();
+        const std::uint32_t count = in.U32();
+        const std::uint16_t flags = in.U16();
+        if (!in.Ok() || !in.AtEnd())
+        {
+            status = FrameStatus::BadRequest;
+            break;
+        }
+        const auto showing = booker_.ResolveShowing(movie, theater);
+        if (!showing)
+        {
+            status = FrameStatus::UnknownShowing;
+            break;
+        }
+        const std::size_t seats = booker_.GetSeatCount(*showing);
+        if (count == 0 || count > seats)
+            status = FrameStatus::InvalidSeats;
+        else if (!booker_.BookBest(*showing, count, (flags & BinaryProtocol::kContiguousFlag) != 0, seat_buffer))
+            status = FrameStatus::SeatsUnavailable;
+        else
+            BinaryProtocol::AppendSeatBitmap(out_buffer, seat_buffer, seats);
+        break;
+    }
+    case Opcode::ConfirmHold:
+    case Opcode::ReleaseHold:
+    {
+        const IMovieBooker::HoldId hold = in.U64();
+        if (!in.Ok() || !in.AtEnd())
+            status = FrameStatus::BadRequest;
+        else if (!(static_cast<Opcode>(request.opcode) == Opcode::ConfirmHold ? booker_.ConfirmHold(hold) : booker_.ReleaseHold(hold)))
+            status = FrameStatus::UnknownHold;
+        break;
+    }
+    default:
+        status = FrameStatus::BadRequest;
+        break;
+    }
+
+    BinaryProtocol::EndFrame(out_buffer, frame, status);
+
+    if (metrics_)
+    {
+        const bool booking = command == Command::BookSeats || command == Command::BookBatch || command == Command::BookBest;
+        if (booking && (status == FrameStatus::Ok || status == FrameStatus::SeatsUnavailable))
+            metrics_->CountBooking(status == FrameStatus::Ok);
+        if (timed)
+            metrics_->RecordLatency(command, std::chrono::steady_clock::now() - start);
+    }
+}
+
+void tcp_connection::enqueue(buffer_ptr buffer)
+{
+    if (closed_ || buffer->empty())
+        return;
+    queued_bytes_ += buffer->size();
+    out_queue_.push_back(std::move(buffer));
+    if (!writing_)
+        start_write();
+}
+
+void tcp_connection::flush_out_buffer()
+{
+    if (out_buffer.empty())
+        return;
+
+    std::shared_ptr<std::string> buffer;
+    if (!spare_.empty())
+    {
+        buffer = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    else
+        buffer = std::make_shared<std::string>();
+
+    buffer->clear();
+    buffer->swap(out_buffer);               // hand over the replies; out_buffer gets the spare's capacity
+    enqueue(std::move(buffer));
+}
+
+void tcp_connection::start_write()
+{
+    in_flight_.clear();
+    gather_.clear();
+    while (!out_queue_.empty() && in_flight_.size() < kMaxGather)
+    {
+        gather_.emplace_back(boost::asio::buffer(*out_queue_.front()));
+        in_flight_.push_back(std::move(out_queue_.front()));
+        out_queue_.pop_front();
+    }
+
+    writing_ = true;
+    boost::asio::async_write(socket_, gather_,
+        std::bind(&tcp_connection::handle_write_end, shared_from_this(),
             boost::asio::placeholders::error,
-			boost::asio::placeholders::bytes_transferred));
-	}
+            boost::asio::placeholders::bytes_transferred));
+}
+
+void tcp_connection::handle_write_end(const boost::system::error_code& error, size_t size)
+{
+    writing_ = false;
+    if (metrics_)
+        metrics_->CountBytesOut(size);
+
+    // keep reply buffers nobody else references (not the shared greeting) for reuse;
+    // two spares cover the buffer being filled and the one being written
+    for (auto &buffer : in_flight_)
+        if (buffer.use_count() == 1 && spare_.size() < 2)
+            spare_.push_back(std::const_pointer_cast<std::string>(std::move(buffer)));
+    in_flight_.clear();
+
+    if (error)
+    {
+        close();
+        return;
+    }
+    queued_bytes_ -= size;
+
+    if (!out_queue_.empty())
+        start_write();
+    else if (rejecting_)
+        close();
+
+    if (!reading_ && !rejecting_ && !closed_ && queued_bytes_ <= kLowWaterMark)
+        process_input();                    // resume commands and reads paused by backpressure
+}
+
+void tcp_connection::handle_command(std::string_view line)
+{
+    const ParsedCommand parsed = CommandParser::Parse(line);
+
+    // every command is counted, one in a few timed (see ServerMetrics)
+    const bool timed = metrics_ && metrics_->CountCommand(parsed.command);
+    const auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    switch (parsed.command)
+    {
+    case Command::ListMovies:
+    {
+        if (listings_)
+        {
+            // the shared reply goes out as is, behind the replies before it
+            flush_out_buffer();
+            enqueue(listings_->Movies());
+            break;
+        }
+        const std::size_t start = out_buffer.size();
+        for (const auto &movie : booker_.GetMovies())
+            out_buffer.append(movie).push_back(',');
+        if (out_buffer.size() == start)
+            out_buffer.append("No movies running");
+        out_buffer.push_back('\n');
+        break;
+    }
+    case Command::SelectMovie:
+        last_movie.assign(parsed.argument);
+        movie_id = booker_.ResolveMovie(last_movie);
+        if (!movie_id)
+        {
+            respond("Error! Select a valid movie\n");
+            last_movie.clear();
+        }
+        else
+        {
+            last_theater.clear();                   // reset last selected theater
+            theater_id.reset();
+            showing_id.reset();
+            out_buffer.append("Movie ").append(last_movie).append(" selected\n");
+        }
+        break;
+    case Command::ListTheaters:
+        if (last_movie.size() && listings_ && movie_id)
+        {
+            flush_out_buffer();
+            enqueue(listings_->Theaters(*movie_id));
+        }
+        else if (last_movie.size())
+        {
+            const std::size_t start = out_buffer.size();
+            for (const auto &theater : booker_.GetTheatersForMovie(last_movie))
+                out_buffer.append(theater).push_back(',');
+            if (out_buffer.size() == start)
+                out_buffer.append("Movie is not running in any theater");
+            out_buffer.push_back('\n');
+        }
+        else
+            respond("Error! No valid movie selected\n");
+        break;
+    case Command::SelectTheater:
+        last_theater.assign(parsed.argument);
+        theater_id = booker_.ResolveTheater(last_theater);
+        showing_id.reset();
+        if (!theater_id)
+        {
+            respond("Error! Select a valid theater\n");   // newline needed now that replies are coalesced
+            last_theater.clear();
+        }
+        else
+        {
+            // resolve the showing once; it stays unset if the theater does not show the movie
+            if (movie_id)
+                showing_id = booker_.ResolveShowing(*movie_id, *theater_id);
+            seat_count = showing_id ? booker_.GetSeatCount(*showing_id) : 0;
+            out_buffer.append("Theater ").append(last_theater).append(" selected\n");
+        }
+        break;
+    case Command::GetFreeSeats:
+        if (!last_movie.size())
+            respond("Error! No valid movie selected\n");
+        else if (!last_theater.size())
+            respond("Error! No valid theater selected\n");
+        else
+        {
+            if (showing_id)
+            {
+                char digits[16];
+                for (auto seat : booker_.GetFreeSeats(*showing_id))
+                {
+                    auto res = std::to_chars(digits, digits + sizeof(digits), seat);
+                    out_buffer.append(digits, res.ptr).push_back(',');
+                }
+            }
+            out_buffer.push_back('\n');
+        }
+        break;
+    case Command::BookSeats:
+        if (!parse_selected_seats(parsed.argument))
+            break;
+        if (booker_.BookSeats(*showing_id, seat_buffer))
+        {
+            count_booking(true);
+            respond("Seats booked successfully\n");
+        }
+        else
+        {
+            count_booking(false);
+            respond("Error! Could not book seats\n");
+        }
+        break;
+    case Command::HoldSeats:
+    {
+        if (!parse_selected_seats(parsed.argument))
+            break;
+        const std::optional<IMovieBooker::HoldId> hold = booker_.HoldSeats(*showing_id, seat_buffer, hold_ttl_);
+        if (hold)
+            out_buffer.append("Hold ").append(std::to_string(*hold)).append(" created\n");
+        else
+            respond("Error! Could not hold seats\n");
+        break;
+    }
+    case Command::ConfirmHold:
+    case Command::ReleaseHold:
+    {
+        const bool confirm = parsed.command == Command::ConfirmHold;
+        std::uint64_t hold = 0;
+        if (!CommandParser::ParseNumber(parsed.argument, hold))
+            respond("Error! Specify a valid hold id\n");
+        else if (confirm ? booker_.ConfirmHold(hold) : booker_.ReleaseHold(hold))
+            respond(confirm ? "Hold confirmed\n" : "Hold released\n");
+        else
+            respond("Error! Unknown or expired hold\n");
+        break;
+    }
+    case Command::BookBest:
+        book_best(parsed.argument);
+        break;
+    case Command::BookBatch:
+        book_batch(parsed.argument);
+        break;
+    case Command::Binary:
+        respond("OK binary\n");
+        binary_ = true;                     // the rest of the stream is framed
+        break;
+    case Command::Stats:
+        if (!metrics_)
+            respond("Error! No metrics recorded\n");
+        else
+        {
+            MetricsSnapshot snapshot = metrics_->Snapshot();
+            if (registry_)
+            {
+                snapshot.live_connections = registry_->live();
+                snapshot.peak_connections = registry_->peak();
+            }
+            out_buffer.append(ServerMetrics::FormatText(snapshot));
+        }
+        break;
+    default:
+        respond(invalid_cmd_message);
+        break;
+    }
+
+    if (timed)
+        metrics_->RecordLatency(parsed.command, std::chrono::steady_clock::now() - start);
+}
+
+void tcp_connection::count_booking(bool booked)
+{
+    if (metrics_)
+        metrics_->CountBooking(booked);
+}
+
+bool tcp_connection::check_selection()
+{
+    if (!last_movie.size())
+    {
+        respond("Error! No valid movie selected\n");
+        return false;
+    }
+    if (!last_theater.size() || !showing_id)
+    {
+        // a theater that does not show the movie resolves no showing
+        respond("Error! No valid theater selected\n");
+        return false;
+    }
+    return true;
+}
+
+void tcp_connection::book_best(std::string_view args)
+{
+    if (!check_selection())
+        return;
+
+    std::uint64_t count = 0;
+    bool contiguous = false;
+    if (!CommandParser::ParseBestRequest(args, count, contiguous) || count == 0)
+        respond("Error! Specify a number of seats\n");
+    else if (count > seat_count)
+        out_buffer.append("Error! Too many seats requested; request 1 to ").append(std::to_string(seat_count)).append(" seats\n");
+    else if (booker_.BookBest(*showing_id, static_cast<std::size_t>(count), contiguous, seat_buffer))
+    {
+        count_booking(true);
+        char digits[16];
+        out_buffer.append("Seats booked: ");
+        for (std::size_t i = 0; i < seat_buffer.size(); ++i)
+        {
+            if (i)
+                out_buffer.push_back(',');
+            auto res = std::to_chars(digits, digits + sizeof(digits), seat_buffer[i]);
+            out_buffer.append(digits, res.ptr);
+        }
+        out_buffer.push_back('\n');
+    }
+    else
+    {
+        count_booking(false);
+        respond("Error! Could not book seats\n");
+    }
+}
+
+bool tcp_connection::parse_selected_seats(std::string_view args)
+{
+    if (!check_selection())
+        return false;
+
+    // validate against the capacity of the selected showing
+    switch (CommandParser::ParseSeats(args, seat_count, seat_buffer))
+    {
+    case SeatListStatus::OutOfRange:
+        out_buffer.append("Error! Seats not in range 1-").append(std::to_string(seat_count)).push_back('\n');
+        return false;
+    case SeatListStatus::Empty:
+        respond("Error! No valid seats specified\n");
+        return false;
+    case SeatListStatus::TooMany:
+        out_buffer.append("Error! Too many seats requested; request 1 to ").append(std::to_string(seat_count)).append(" unique seat ids\n");
+        return false;
+    case SeatListStatus::Ok:
+        break;
+    }
+    return true;
+}
+
+void tcp_connection::book_batch(std::string_view args)
+{
+    // every item names its own showing, so no prior select_movie / select_theater is needed
+    batch_buffer.clear();
+    std::string_view rest = args, item, movie, theater, seats;
+    std::size_t index = 0;
+    while (CommandParser::NextBatchItem(rest, item))
+    {
+        ++index;
+        std::optional<IMovieBooker::ShowingId> showing;
+        if (CommandParser::SplitBatchItem(item, movie, theater, seats))
+        {
+            const auto movieId = booker_.ResolveMovie(std::string(movie));
+            const auto theaterId = booker_.ResolveTheater(std::string(theater));
+            if (movieId && theaterId)
+                showing = booker_.ResolveShowing(*movieId, *theaterId);
+        }
+        if (!showing || CommandParser::ParseSeats(seats, booker_.GetSeatCount(*showing), seat_buffer) != SeatListStatus::Ok)
+        {
+            out_buffer.append("Error! Invalid batch item ").append(std::to_string(index)).push_back('\n');
+            return;
+        }
+        batch_buffer.push_back({ *showing, seat_buffer });
+    }
+
+    if (batch_buffer.empty())
+        respond("Error! No valid batch specified\n");
+    else if (booker_.BookBatch(batch_buffer))
+    {
+        count_booking(true);
+        respond("Batch booked successfully\n");
+    }
     else
-	    socket_.close();
-}
-
-void tcp_connection::handle_read_end(const boost::system::error_code& error, std::size_t sz)
-{
-	if (!error)
-	{
-		size_t sz = command_buffer.find("\n");
-		std::stringstream stream(command_buffer, std::ios::in);
-		std::string command;
-
-		if (stream >> command)
-		{
-			trim_trailing(command, '\r');                      // windows helper
-			trim_trailing(command, ' ');                    
-			// transform to lower case
-			std::transform(command.begin(), command.end(), command.begin(),
-				[](unsigned char c) {
-				return static_cast<char>(std::tolower(c));
-			});
-			if (command == "list_movies")
-			{
-				auto movies = booker_.GetMovies();
-				std::string list;
-				for (auto t : movies)
-					list += t + ",";
-				if (list.empty())
-					list = "No movies running";
-				list += "\n";
-				write_out(list);
-			}
-			else if (command == "select_movie")
-			{
-				stream >> std::ws;			// skip any whitespace in stream
-				std::getline(stream, last_movie);
-				trim_trailing(last_movie, '\r');
-				trim_trailing(last_movie, ' ');
-				if ( booker_.GetTheatersForMovie(last_movie).empty() )
-				{
-					write_out("Error! Select a valid movie\n");
-					last_movie = "";
-				}
-				else
-				{
-					last_theater = "";                  // reset last selected theater
-					write_out("Movie " + last_movie + " selected\n");
-				}
-			}
-			else if (command == "list_theaters")
-			{
-				if (last_movie.size())
-				{
-					auto theaters = booker_.GetTheatersForMovie(last_movie);
-					std::string list;
-					for (auto t : theaters)
-						list += t + ",";
-					if (list.empty())
-						list = "Movie is not running in any theater";
-					list += "\n";
-					write_out(list);
-				}
-				else
-					write_out("Error! No valid movie selected\n");
-			}
-			else if (command == "select_theater")
-			{
-				stream >> std::ws;			// skip any whitespace in stream
-				std::getline(stream, last_theater);
-				trim_trailing(last_theater, '\r');
-				trim_trailing(last_theater, ' ');
-			
-				if (!booker_.IsTheater(last_theater))
-				{
-					write_out("Error! Select a valid theater");
-					last_theater = "";
-				}
-				else
-					write_out("Theater " + last_theater + " selected\n");
-			}
-			else if (command == "get_free_seats")
-			{
-				if (!last_movie.size())
-				{
-					write_out("Error! No valid movie selected\n");
-				}
-				else if (!last_theater.size())
-				{
-					write_out("Error! No valid theater selected\n");
-				}
-				else
-				{
-					std::vector<unsigned int> free_seats = booker_.GetFreeSeats(last_theater, last_movie);
-					std::string list;
-					for ( auto seat : free_seats )
-						list += std::to_string(seat) + ",";
-					list += "\n";
-					write_out(list);
-				}
-			}
-			else if (command == "book_seats")
-			{
-				if (!last_theater.size())
-				{
-					write_out("Error! No valid theater selected\n");
-				}
-				if (!last_movie.size())
-				{
-					write_out("Error! No valid movie selected\n");
-				}
-				else
-				{
-					int seat = 0;
-					std::vector<unsigned int> seats;
-					stream >> std::ws; // skip any whitespace before seats
-					while (stream >> seat)
-					{
-						if (seat < 1 || seat > 20)
-						{
-							write_out("Error! Seats not in range 1-20\n");
-							seats.clear();
-							break;
-						}
-						seats.push_back(seat);
-						char c = stream.peek();
-						if (c == ',')
-							stream.ignore(1);
-						else
-							break;
-					}
-
-					if (seats.empty())
-					{
-						write_out("Error! No valid seats specified\n");
-					}
-					else if (seats.size() > 20)
-					{
-						write_out("Error! Too many seats requested; request 1 to 20 unique seat ids\n");
-					}
-					else
-					{
-						if (booker_.BookSeats(last_theater, last_movie, seats))
-						 write_out("Seats booked successfully\n");
-						else
-						 write_out("Error! Could not book seats\n");
-					}
-				}
-			}
-			else
-			 write_out(invalid_cmd_message);
-		}
-		else
-		{
-			write_out(invalid_cmd_message);
-		}
-		command_buffer.erase(0, sz + 1); // remove processed command
-	}
-	else
-		socket_.close();
+    {
+        count_booking(false);
+        respond("Error! Could not book batch\n");
+    }
 }
 
 // helper for responding to client
-void tcp_connection::write_out(const std::string& msg)
+void tcp_connection::respond(std::string_view msg)
+{
+    out_buffer.append(msg.data(), msg.size());
+}
+
+
+
+connection_registry::connection_registry(std::size_t max_connections) : max_connections_(max_connections)
+{
+}
+
+tcp_connection::pointer connection_registry::acquire(boost::asio::io_context& io_context, IMovieBooker& booker)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::size_t slot;
+    if (!free_.empty())
+    {
+        slot = free_.back();
+        free_.pop_back();
+        // recycle the object only when no handler of the previous session still holds it
+        if (slots_[slot].use_count() == 1)
+            slots_[slot]->reset();
+        else
+            slots_[slot] = tcp_connection::create(io_context, booker);
+    }
+    else
+    {
+        slot = slots_.size();
+        slots_.push_back(tcp_connection::create(io_context, booker));
+        active_.push_back(false);
+    }
+
+    auto &connection = slots_[slot];
+    connection->registry_ = this;
+    connection->slot_ = slot;
+    return connection;
+}
+
+bool connection_registry::admit(const tcp_connection::pointer& connection)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_connections_ && live_ >= max_connections_)
+        return false;
+
+    active_[connection->slot_] = true;
+    peak_ = std::max(peak_, ++live_);
+    return true;
+}
+
+void connection_registry::release(std::size_t slot)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot >= slots_.size())                  // registry was cleared meanwhile
+        return;
+    if (active_[slot])
+    {
+        active_[slot] = false;
+        --live_;
+    }
+    free_.push_back(slot);
+}
+
+void connection_registry::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &connection : slots_)
+        connection->registry_ = nullptr;
+    slots_.clear();
+    active_.clear();
+    free_.clear();
+    live_ = 0;
+}
+
+std::size_t connection_registry::live() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_;
+}
+
+std::size_t connection_registry::peak() const
 {
-	out_buffer = msg;
-	boost::asio::async_write(socket_, boost::asio::buffer(out_buffer),
-		std::bind(&tcp_connection::handle_write_end, shared_from_this(),
-			boost::asio::placeholders::error,
-			boost::asio::placeholders::bytes_transferred));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
 }
 
-// helper on Windows in case carriage return is present before newline
-std::string& tcp_connection::trim_trailing( std::string& str , char c)
+std::size_t connection_registry::slots() const
 {
-	if ( !str.empty() )
-		while (str.back() == c)
-			str.pop_back();
-	return str;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
 }
 
 
 
-AsioServer::AsioServer(IMovieBooker& booker, unsigned short port) : booker_(booker), acceptor(io_context_), run_once(false), port_(port)
+AsioServer::AsioServer(IMovieBooker& booker, unsigned short port, unsigned int threads, std::size_t max_connections)
+    : booker_(booker), connections(max_connections), acceptor(io_context_), run_once(false), port_(port), threads_(threads ? threads : 1),
+      hold_ttl_(tcp_connection::kDefaultHoldTtl), expiry_timer_(io_context_), listings_(booker), admin_acceptor_(io_context_)
 {
     // bind to the requested port (0 -> ephemeral)
     acceptor.open(tcp::v4());
@@ -248,10 +879,12 @@ AsioServer::~AsioServer()
 
 void AsioServer::start_accept()
 {
-    //tcp_connection::pointer new_connection = tcp_connection::create(io_context_, booker_);
-	connections.emplace_back(tcp_connection::create(io_context_, booker_));
+    tcp_connection::pointer new_connection = connections.acquire(io_context_, booker_);
+    new_connection->set_hold_ttl(hold_ttl_);
+    new_connection->set_metrics(&metrics_);
+    new_connection->set_listings(&listings_);
 
-    acceptor.async_accept(connections.back()->socket(), std::bind(&AsioServer::handle_accept, this, connections.back(),
+    acceptor.async_accept(new_connection->socket(), std::bind(&AsioServer::handle_accept, this, new_connection,
             boost::asio::placeholders::error));
 }
 
@@ -259,19 +892,63 @@ void AsioServer::handle_accept(tcp_connection::pointer new_connection, const boo
 {
     if (!error)
     {
-        new_connection->start();
+        const bool admitted = connections.admit(new_connection);
+        metrics_.CountSession(admitted);
+        if (admitted)
+            new_connection->start();
+        else
+            new_connection->reject();           // over max-connections
     }
+    else
+        new_connection->close();                // give the slot back
 
     start_accept();
 }
 
+void AsioServer::start_admin_accept()
+{
+    admin_acceptor_.async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+        if (error == boost::asio::error::operation_aborted)
+            return;
+        if (!error)
+            std::make_shared<admin_session>(std::move(socket), [this]() { return ServerMetrics::FormatPrometheus(GetMetrics()); })->start();
+        start_admin_accept();
+    });
+}
+
+void AsioServer::start_expiry_timer()
+{
+    expiry_timer_.expires_after(kHoldExpiryInterval);   // also cancels a wait left over from a previous Run()
+    expiry_timer_.async_wait(std::bind(&AsioServer::handle_expiry_timer, this, boost::asio::placeholders::error));
+}
+
+void AsioServer::handle_expiry_timer(const boost::system::error_code& error)
+{
+    if (error)
+        return;
+    booker_.ExpireHolds(std::chrono::steady_clock::now());
+    start_expiry_timer();
+}
+
 void AsioServer::Run()
 {
     start_accept();
+    start_expiry_timer();
+    if (admin_acceptor_.is_open())
+        start_admin_accept();
     if (run_once)
         io_context_.restart();
-	io_context_.run();
-	run_once = true;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads_ - 1);
+    for (unsigned int i = 1; i < threads_; ++i)
+        workers.emplace_back([this]() { io_context_.run(); });
+
+    io_context_.run();
+
+    for (auto &w : workers)
+        w.join();
+    run_once = true;
 }
 
 void AsioServer::Stop()
@@ -282,4 +959,47 @@ void AsioServer::Stop()
 unsigned short AsioServer::GetPort() const
 {
     return port_;
-}
\ No newline at end of file
+}
+
+unsigned int AsioServer::GetThreadCount() const
+{
+    return threads_;
+}
+
+std::size_t AsioServer::GetLiveConnections() const
+{
+    return connections.live();
+}
+
+std::size_t AsioServer::GetPeakConnections() const
+{
+    return connections.peak();
+}
+
+void AsioServer::SetHoldTtl(std::chrono::milliseconds ttl)
+{
+    hold_ttl_ = ttl;
+}
+
+void AsioServer::EnableAdmin(unsigned short port)
+{
+    // loopback only: metrics are not for the clients
+    const tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+    admin_acceptor_.open(endpoint.protocol());
+    admin_acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+    admin_acceptor_.bind(endpoint);
+    admin_acceptor_.listen();
+}
+
+unsigned short AsioServer::GetAdminPort() const
+{
+    return admin_acceptor_.is_open() ? admin_acceptor_.local_endpoint().port() : 0;
+}
+
+MetricsSnapshot AsioServer::GetMetrics() const
+{
+    MetricsSnapshot snapshot = metrics_.Snapshot();
+    snapshot.live_connections = connections.live();
+    snapshot.peak_connections = connections.peak();
+    return snapshot;
+}
@@ -0,0 +1,230 @@
+#include <AsyncClient.hpp>
+#include <CommandParser.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr std::size_t kMaxReply = 16 * 1024 * 1024;     // list replies of large catalogs included
+}
+
+AsyncClient::pointer AsyncClient::Create(boost::asio::io_context& io_context)
+{
+    return pointer(new AsyncClient(io_context));
+}
+
+AsyncClient::AsyncClient(boost::asio::io_context& io_context)
+    : strand_(boost::asio::make_strand(io_context)), socket_(strand_)      // socket handlers run on the strand
+{
+}
+
+void AsyncClient::AsyncConnect(const boost::asio::ip::tcp::resolver::results_type& endpoints, ConnectHandler handler)
+{
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    boost::asio::dispatch(strand_, [this, self = shared_from_this(), endpoints, handler = std::move(handler)]() mutable {
+        // the greeting is the first reply, ahead of any command queued already
+        PendingReply greeting;
+        greeting.multiline = true;                          // a line and an empty line
+        greeting.greeting = true;
+        greeting.handler = [handler = std::move(handler)](const boost::system::error_code& error, std::string_view) { handler(error); };
+        pending_.push_front(std::move(greeting));
+
+        boost::asio::async_connect(socket_, endpoints,
+            [this, self](const boost::system::error_code& error, const boost::asio::ip::tcp::endpoint&) {
+                if (error)
+                {
+                    fail(error);
+                    return;
+                }
+                if (!open_.load(std::memory_order_relaxed))
+                    return;                                 // closed while connecting
+                connected_ = true;
+                start_write();
+                start_read();
+            });
+    });
+}
+
+void AsyncClient::AsyncCommand(std::string_view line, ReplyHandler handler)
+{
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    if (strand_.running_in_this_thread())
+        enqueue(line, std::move(handler));                  // from one of our handlers: no copy, no hop
+    else
+        boost::asio::post(strand_, [self = shared_from_this(), line = std::string(line), handler = std::move(handler)]() mutable {
+            self->enqueue(line, std::move(handler));
+        });
+}
+
+std::future<std::string> AsyncClient::Command(std::string_view line)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> reply = promise->get_future();
+    AsyncCommand(line, [promise](const boost::system::error_code& error, std::string_view text) {
+        if (error)
+            promise->set_exception(std::make_exception_ptr(boost::system::system_error(error)));
+        else
+            promise->set_value(std::string(text));
+    });
+    return reply;
+}
+
+void AsyncClient::Close()
+{
+    boost::asio::dispatch(strand_, [self = shared_from_this()]() { self->fail(boost::asio::error::operation_aborted); });
+}
+
+void AsyncClient::enqueue(std::string_view line, ReplyHandler handler)
+{
+    if (!open_.load(std::memory_order_relaxed))
+    {
+        // never call the handler from inside AsyncCommand
+        boost::asio::post(strand_, [this, self = shared_from_this(), handler = std::move(handler)]() {
+            in_flight_.fetch_sub(1, std::memory_order_relaxed);
+            handler(error_, std::string_view());
+        });
+        return;
+    }
+    queued_.append(line.data(), line.size()).push_back('\n');
+    // parsed like the server does, so "STATS " also expects the multi-line reply
+    pending_.push_back({ std::move(handler), CommandParser::Parse(line).command == Command::Stats, false });
+    start_write();
+    start_read();
+}
+
+void AsyncClient::start_write()
+{
+    if (!connected_ || writing_ || queued_.empty() || !open_.load(std::memory_order_relaxed))
+        return;
+
+    // everything queued so far goes out in one write; new commands queue behind it
+    writing_ = true;
+    write_buffer_.swap(queued_);
+    boost::asio::async_write(socket_, boost::asio::buffer(write_buffer_),
+        [this, self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+            writing_ = false;
+            write_buffer_.clear();                          // keeps its capacity for the next swap
+            if (error)
+                fail(error);
+            else
+                start_write();
+        });
+}
+
+void AsyncClient::start_read()
+{
+    if (!connected_ || reading_ || pending_.empty() || !open_.load(std::memory_order_relaxed))
+        return;
+
+    reading_ = true;
+    const char* delimiter = pending_.front().multiline ? "\n\n" : "\n";
+    boost::asio::async_read_until(socket_, boost::asio::dynamic_buffer(read_buffer_, kMaxReply), delimiter,
+        [this, self = shared_from_this(), delimiter](boost::system::error_code error, std::size_t size) {
+            reading_ = false;
+            if (!open_.load(std::memory_order_relaxed))
+                return;                                     // pending handlers were already failed
+
+            std::size_t length = error ? 0 : size - std::strlen(delimiter);
+            if (error)
+            {
+                // a busy server's only line arrives right before the close
+                const std::size_t eol = read_buffer_.find('\n');
+                if (!pending_.front().greeting || error != boost::asio::error::eof || eol == std::string::npos)
+                {
+                    fail(error);
+                    return;
+                }
+                error = boost::system::error_code();
+                length = eol;
+                size = eol + 1;
+            }
+
+            // hand out a copy: the handler may start the next read, which grows read_buffer_
+            if (length && read_buffer_[length - 1] == '\r')
+                --length;
+            reply_.assign(read_buffer_, 0, length);
+            read_buffer_.erase(0, size);
+            PendingReply reply = std::move(pending_.front());
+            pending_.pop_front();
+            if (reply.greeting && reply_.compare(0, 6, "Error!") == 0)
+                error = boost::asio::error::connection_refused;
+
+            in_flight_.fetch_sub(1, std::memory_order_relaxed);
+            reply.handler(error, reply_);
+            if (error)
+                fail(error);                                // refused: the queued commands fail the same way
+            else
+                start_read();
+        });
+}
+
+void AsyncClient::fail(const boost::system::error_code& error)
+{
+    if (!open_.exchange(false))
+        return;
+    error_ = error;
+    boost::system::error_code ignored;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+    queued_.clear();
+
+    // handlers may queue commands, which now fail through enqueue
+    std::deque<PendingReply> pending;
+    pending.swap(pending_);
+    for (auto &reply : pending)
+    {
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        reply.handler(error, std::string_view());
+    }
+}
+
+AsyncClientPool::AsyncClientPool(boost::asio::io_context& io_context, const std::string& host, const std::string& port, std::size_t size)
+    : io_context_(io_context), endpoints_(boost::asio::ip::tcp::resolver(io_context).resolve(host, port))
+{
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, size); ++i)
+        sessions_.push_back(connect());
+}
+
+AsyncClientPool::~AsyncClientPool()
+{
+    Close();
+}
+
+void AsyncClientPool::AsyncCommand(std::string_view line, AsyncClient::ReplyHandler handler)
+{
+    pick()->AsyncCommand(line, std::move(handler));
+}
+
+std::future<std::string> AsyncClientPool::Command(std::string_view line)
+{
+    return pick()->Command(line);
+}
+
+void AsyncClientPool::Close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    for (auto &session : sessions_)
+        session->Close();
+}
+
+AsyncClient::pointer AsyncClientPool::connect()
+{
+    AsyncClient::pointer session = AsyncClient::Create(io_context_);
+    session->AsyncConnect(endpoints_, [](const boost::system::error_code&) {});  // a failure reaches the session's commands
+    return session;
+}
+
+AsyncClient::pointer AsyncClientPool::pick()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    AsyncClient::pointer *best = nullptr;
+    for (auto &session : sessions_)
+    {
+        if (!session->IsOpen() && !closed_)
+            session = connect();
+        if (!best || session->Pending() < (*best)->Pending())
+            best = &session;
+    }
+    return *best;
+}
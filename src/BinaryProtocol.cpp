@@ -0,0 +1,190 @@
+#include <BinaryProtocol.hpp>
+
+namespace
+{
+    inline std::uint16_t load_u16(const char* p)
+    {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return static_cast<std::uint16_t>(b[0] | (b[1] << 8));
+    }
+
+    inline std::uint32_t load_u32(const char* p)
+    {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return std::uint32_t(b[0]) | (std::uint32_t(b[1]) << 8) | (std::uint32_t(b[2]) << 16) | (std::uint32_t(b[3]) << 24);
+    }
+
+    inline void store_u16(char* p, std::uint16_t v)
+    {
+        p[0] = static_cast<char>(v & 0xff);
+        p[1] = static_cast<char>(v >> 8);
+    }
+
+    inline void store_u32(char* p, std::uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            p[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint16_t FrameReader::U16()
+{
+    if (!ok_ || data_.size() - pos_ < 2)
+    {
+        ok_ = false;
+        return 0;
+    }
+    std::uint16_t v = load_u16(data_.data() + pos_);
+    pos_ += 2;
+    return v;
+}
+
+std::uint32_t FrameReader::U32()
+{
+    if (!ok_ || data_.size() - pos_ < 4)
+    {
+        ok_ = false;
+        return 0;
+    }
+    std::uint32_t v = load_u32(data_.data() + pos_);
+    pos_ += 4;
+    return v;
+}
+
+std::uint64_t FrameReader::U64()
+{
+    const std::uint64_t low = U32();
+    return low | (std::uint64_t(U32()) << 32);
+}
+
+std::string_view FrameReader::Bytes(std::size_t count)
+{
+    if (!ok_ || data_.size() - pos_ < count)
+    {
+        ok_ = false;
+        return {};
+    }
+    std::string_view v = data_.substr(pos_, count);
+    pos_ += count;
+    return v;
+}
+
+bool BinaryProtocol::DecodeHeader(std::string_view data, FrameHeader& header)
+{
+    if (data.size() < kHeaderSize)
+        return false;
+    header.length = load_u32(data.data());
+    header.opcode = load_u16(data.data() + 4);
+    header.status = static_cast<FrameStatus>(load_u16(data.data() + 6));
+    header.request_id = load_u32(data.data() + 8);
+    return true;
+}
+
+std::size_t BinaryProtocol::BeginFrame(std::string& out, std::uint16_t opcode, std::uint32_t requestId)
+{
+    const std::size_t frame = out.size();
+    out.resize(frame + kHeaderSize);
+    char* p = &out[frame];
+    store_u32(p, 0);                                    // length patched by EndFrame
+    store_u16(p + 4, opcode);
+    store_u16(p + 6, 0);
+    store_u32(p + 8, requestId);
+    return frame;
+}
+
+void BinaryProtocol::EndFrame(std::string& out, std::size_t frame, FrameStatus status)
+{
+    if (status != FrameStatus::Ok)
+        out.resize(frame + kHeaderSize);                // failed requests carry no payload
+    store_u32(&out[frame], static_cast<std::uint32_t>(out.size() - frame - kHeaderSize));
+    store_u16(&out[frame + 6], static_cast<std::uint16_t>(status));
+}
+
+void BinaryProtocol::AppendU16(std::string& out, std::uint16_t value)
+{
+    char b[2];
+    store_u16(b, value);
+    out.append(b, sizeof(b));
+}
+
+void BinaryProtocol::AppendU32(std::string& out, std::uint32_t value)
+{
+    char b[4];
+    store_u32(b, value);
+    out.append(b, sizeof(b));
+}
+
+void BinaryProtocol::AppendU64(std::string& out, std::uint64_t value)
+{
+    AppendU32(out, static_cast<std::uint32_t>(value));
+    AppendU32(out, static_cast<std::uint32_t>(value >> 32));
+}
+
+void BinaryProtocol::AppendName(std::string& out, std::string_view name)
+{
+    name = name.substr(0, 0xffff);
+    AppendU16(out, static_cast<std::uint16_t>(name.size()));
+    out.append(name.data(), name.size());
+}
+
+void BinaryProtocol::AppendNameList(std::string& out, const std::vector<std::pair<std::uint32_t, std::string>>& entries)
+{
+    AppendU32(out, static_cast<std::uint32_t>(entries.size()));
+    for (const auto &entry : entries)
+    {
+        AppendU32(out, entry.first);
+        AppendName(out, entry.second);
+    }
+}
+
+void BinaryProtocol::AppendSeatBitmap(std::string& out, const std::vector<unsigned int>& seats, std::size_t bitCount)
+{
+    AppendU32(out, static_cast<std::uint32_t>(bitCount));
+    const std::size_t start = out.size();
+    out.resize(start + (bitCount + 7) / 8, '\0');
+    for (unsigned int seat : seats)
+        if (seat >= 1 && seat <= bitCount)
+            out[start + (seat - 1) / 8] |= static_cast<char>(1u << ((seat - 1) % 8));
+}
+
+bool BinaryProtocol::ReadNameList(FrameReader& in, std::vector<std::pair<std::uint32_t, std::string>>& entries)
+{
+    entries.clear();
+    std::uint32_t count = in.U32();
+    for (std::uint32_t i = 0; i < count && in.Ok(); ++i)
+    {
+        std::uint32_t id = in.U32();
+        std::string_view name = in.Bytes(in.U16());
+        if (in.Ok())
+            entries.emplace_back(id, std::string(name));
+    }
+    return in.Ok();
+}
+
+bool BinaryProtocol::ReadSeatBitmap(FrameReader& in, std::vector<unsigned int>& seats, std::size_t* bitCount)
+{
+    seats.clear();
+    const std::uint32_t bits = in.U32();
+    std::string_view bytes = in.Bytes((static_cast<std::size_t>(bits) + 7) / 8);
+    if (!in.Ok())
+        return false;
+
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+    {
+        unsigned int b = static_cast<unsigned char>(bytes[i]);
+        while (b)
+        {
+            unsigned int bit = 0;
+            while (!((b >> bit) & 1u))
+                ++bit;
+            const std::size_t seat = i * 8 + bit + 1;
+            if (seat > bits)
+                return false;                           // padding bits must be clear
+            seats.push_back(static_cast<unsigned int>(seat));
+            b &= b - 1;
+        }
+    }
+    if (bitCount)
+        *bitCount = bits;
+    return true;
+}
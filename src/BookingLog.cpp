@@ -0,0 +1,421 @@
+#include <BookingLog.hpp>
+#include <BinaryProtocol.hpp>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#ifdef _MSC_VER
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr char kMagic[] = "MBLOG002";               // followed by the u64 log offset of the first record
+    constexpr char kMagicV1[] = "MBLOG001";             // no offset: the first record is at offset 8
+    constexpr std::size_t kMagicSize = sizeof(kMagic) - 1;
+    constexpr std::size_t kFileHeader = kMagicSize + 8;
+    constexpr std::uint64_t kFirstOffset = kMagicSize;  // log offset of the first record ever appended
+    constexpr std::size_t kRecordHeader = 8;            // u32 length, u32 crc
+    constexpr std::uint32_t kMaxRecord = 64 * 1024 * 1024;
+
+    const std::array<std::uint32_t, 256> crc_table = []()
+    {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    std::uint32_t crc32(std::string_view data)
+    {
+        std::uint32_t c = 0xffffffffu;
+        for (unsigned char b : data)
+            c = crc_table[(c ^ b) & 0xff] ^ (c >> 8);
+        return c ^ 0xffffffffu;
+    }
+
+    bool sync_file(std::FILE* file)
+    {
+#ifdef _MSC_VER
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // write a v2 file header and sync it
+    bool write_header(std::FILE* file, std::uint64_t base)
+    {
+        std::string header(kMagic, kMagicSize);
+        BinaryProtocol::AppendU64(header, base);
+        return std::fwrite(header.data(), 1, header.size(), file) == header.size() && std::fflush(file) == 0 && sync_file(file);
+    }
+}
+
+bool BookingLog::ParseRecord(std::string_view body, const ReplayCallback& apply, std::vector<unsigned int>& seats)
+{
+    FrameReader record(body);
+    const std::uint32_t count = record.U32();
+    for (std::uint32_t i = 0; i < count && record.Ok(); ++i)
+    {
+        const std::string_view movie = record.Bytes(record.U16());
+        const std::string_view theater = record.Bytes(record.U16());
+        const std::uint32_t seatCount = record.U32();
+        seats.clear();
+        for (std::uint32_t s = 0; s < seatCount && record.Ok(); ++s)
+            seats.push_back(record.U32());
+        if (record.Ok() && apply)
+            apply(movie, theater, seats);
+    }
+    return record.Ok() && record.AtEnd();
+}
+
+BookingLog::~BookingLog()
+{
+    Close();
+}
+
+bool BookingLog::Open(const std::string& path, Durability mode, std::chrono::milliseconds groupInterval)
+{
+    Close();
+    // an offset past every record reads the whole file to find its intact end, whatever it starts at
+    return Open(path, mode, groupInterval, Replay(path, ReplayCallback(), std::numeric_limits<std::uint64_t>::max()));
+}
+
+bool BookingLog::Open(const std::string& path, Durability mode, std::chrono::milliseconds groupInterval, const LogReplayResult& replayed)
+{
+    Close();
+    if (!replayed.ok)
+        return false;
+
+    // cut off a torn tail so new records directly follow the last intact one
+    std::error_code ec;
+    if (replayed.torn_tail)
+    {
+        std::filesystem::resize_file(path, replayed.valid_bytes, ec);
+        if (ec)
+            return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_)
+        return false;
+
+    std::uint64_t base = replayed.start, header = replayed.valid_bytes - (replayed.end - replayed.start), end = replayed.end;
+    if (replayed.valid_bytes == 0)
+    {
+        if (!write_header(file_, kFirstOffset))
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        base = end = kFirstOffset;
+        header = kFileHeader;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    base_ = base;
+    header_ = header;
+    mode_ = mode;
+    interval_ = groupInterval;
+    pending_.clear();
+    appended_ = written_ = synced_ = end;
+    syncs_ = 0;
+    writing_ = failed_ = stop_ = false;
+    if (mode_ == Durability::Group)
+        flusher_ = std::thread(&BookingLog::FlusherLoop, this);
+    return true;
+}
+
+void BookingLog::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (flusher_.joinable())
+        flusher_.join();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!file_)
+        return;
+    WaitFor(lock, appended_, mode_ != Durability::None);
+    cv_.wait(lock, [this]() { return !writing_; });    // a failed log may still have a writer out
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool BookingLog::Append(const LoggedBooking* bookings, std::size_t count)
+{
+    // encode outside the lock; the scratch keeps its capacity per thread
+    thread_local std::string record;
+    record.assign(kRecordHeader, '\0');
+    BinaryProtocol::AppendU32(record, static_cast<std::uint32_t>(count));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        BinaryProtocol::AppendName(record, bookings[i].movie);
+        BinaryProtocol::AppendName(record, bookings[i].theater);
+        BinaryProtocol::AppendU32(record, static_cast<std::uint32_t>(bookings[i].count));
+        for (std::size_t s = 0; s < bookings[i].count; ++s)
+            BinaryProtocol::AppendU32(record, bookings[i].seats[s]);
+    }
+    const std::string_view body = std::string_view(record).substr(kRecordHeader);
+    std::string header;
+    BinaryProtocol::AppendU32(header, static_cast<std::uint32_t>(body.size()));
+    BinaryProtocol::AppendU32(header, crc32(body));
+    record.replace(0, kRecordHeader, header);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!file_ || failed_)
+        return false;
+    pending_.append(record);
+    appended_ += record.size();
+
+    switch (mode_)
+    {
+    case Durability::None:
+        return WaitFor(lock, appended_, false);
+    case Durability::Fsync:
+        return WaitFor(lock, appended_, true);
+    case Durability::Group:
+        break;
+    }
+    return true;
+}
+
+bool BookingLog::Sync()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return file_ && WaitFor(lock, appended_, true);
+}
+
+std::uint64_t BookingLog::AppendedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appended_;
+}
+
+std::uint64_t BookingLog::SyncedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return synced_;
+}
+
+bool BookingLog::Rotate(std::uint64_t from)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!file_ || !WaitFor(lock, appended_, false))
+        return false;
+    cv_.wait(lock, [this]() { return !writing_; });    // new appends stay pending until the new file is open
+    if (failed_ || from > written_)
+        return false;
+    if (from <= base_)
+        return true;                                    // dropped already
+
+    const std::string temp = path_ + ".tmp";
+    std::error_code ec;
+    if (!WriteRotated(temp, from))
+    {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::fclose(file_);
+    std::filesystem::rename(temp, path_, ec);           // replaces the log atomically
+    if (ec)
+        std::filesystem::remove(temp, ec);
+    else
+    {
+        base_ = from;
+        header_ = kFileHeader;
+        synced_ = written_;                             // the new file was synced whole
+    }
+    file_ = std::fopen(path_.c_str(), "ab");
+    failed_ = !file_;
+    return !ec && file_;
+}
+
+bool BookingLog::WriteRotated(const std::string& temp, std::uint64_t from)
+{
+    std::ifstream in(path_, std::ios::binary);
+    std::FILE* out = std::fopen(temp.c_str(), "wb");
+    if (!in || !out)
+    {
+        if (out)
+            std::fclose(out);
+        return false;
+    }
+    bool ok = std::fflush(file_) == 0 && write_header(out, from)
+        && static_cast<bool>(in.seekg(static_cast<std::streamoff>(header_ + (from - base_))));
+    std::uint64_t remaining = written_ - from;
+    std::vector<char> buffer(64 * 1024);
+    while (ok && remaining > 0)
+    {
+        const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, buffer.size()));
+        ok = static_cast<bool>(in.read(buffer.data(), static_cast<std::streamsize>(chunk)))
+            && std::fwrite(buffer.data(), 1, chunk, out) == chunk;
+        remaining -= chunk;
+    }
+    ok = ok && std::fflush(out) == 0 && sync_file(out);
+    return std::fclose(out) == 0 && ok;
+}
+
+std::uint64_t BookingLog::SyncCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return syncs_;
+}
+
+bool BookingLog::WaitFor(std::unique_lock<std::mutex>& lock, std::uint64_t offset, bool sync)
+{
+    // whoever finds no write in flight writes for everybody queued so far;
+    // the others wait and usually find their record covered
+    while (!failed_ && (sync ? synced_ : written_) < offset)
+    {
+        if (writing_)
+            cv_.wait(lock);
+        else
+            WriteOut(lock, sync);
+    }
+    return !failed_;
+}
+
+void BookingLog::WriteOut(std::unique_lock<std::mutex>& lock, bool sync)
+{
+    writing_ = true;
+    writing_buffer_.swap(pending_);                     // pending_ gets the old buffer's capacity
+    const std::uint64_t target = appended_;
+    lock.unlock();
+
+    bool ok = writing_buffer_.empty()
+        || (std::fwrite(writing_buffer_.data(), 1, writing_buffer_.size(), file_) == writing_buffer_.size() && std::fflush(file_) == 0);
+    if (ok && sync)
+        ok = sync_file(file_);
+
+    lock.lock();
+    writing_buffer_.clear();
+    written_ = target;
+    if (sync)
+    {
+        synced_ = target;
+        ++syncs_;
+    }
+    failed_ = failed_ || !ok;
+    writing_ = false;
+    cv_.notify_all();
+}
+
+void BookingLog::FlusherLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        cv_.wait_for(lock, interval_, [this]() { return stop_; });
+        if (!writing_ && !failed_ && synced_ < appended_)
+            WriteOut(lock, true);
+    }
+}
+
+LogReplayResult BookingLog::Replay(const std::string& path, const ReplayCallback& apply, std::uint64_t from)
+{
+    LogReplayResult result;
+    result.start = result.end = kFirstOffset;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        result.ok = !std::filesystem::exists(path);     // nothing logged yet
+        return result;
+    }
+    in.seekg(0, std::ios::end);
+    const std::uint64_t size = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0);
+
+    char headerBytes[kFileHeader];
+    in.read(headerBytes, kFileHeader);
+    const std::string_view header(headerBytes, static_cast<std::size_t>(in.gcount()));
+    in.clear();
+    std::uint64_t pos;
+    if (header.size() >= kMagicSize && header.compare(0, kMagicSize, kMagicV1) == 0)
+        pos = kMagicSize;
+    else if (header.size() == kFileHeader && header.compare(0, kMagicSize, kMagic) == 0)
+    {
+        FrameReader base(header.substr(kMagicSize));
+        result.start = result.end = base.U64();
+        pos = kFileHeader;
+    }
+    else
+    {
+        // a crash while creating the log can leave a partial header; anything else is foreign
+        const std::string_view magic = header.substr(0, std::min(header.size(), kMagicSize));
+        result.ok = header.size() < kFileHeader
+            && (std::string_view(kMagic).substr(0, magic.size()) == magic || std::string_view(kMagicV1).substr(0, magic.size()) == magic);
+        result.torn_tail = result.ok && !header.empty();
+        return result;
+    }
+    if (std::max(from, kFirstOffset) < result.start)
+    {
+        result.rotated_past = true;                     // the records from `from` to the start are gone
+        return result;
+    }
+
+    // seek to `from` if the file reaches it; records before it are neither read nor checked
+    if (from > result.start && from - result.start <= size - pos)
+    {
+        pos += from - result.start;
+        result.end = from;
+    }
+    result.ok = true;
+    in.seekg(static_cast<std::streamoff>(pos));
+    std::string record;
+    std::vector<unsigned int> seats;
+    while (size - pos >= kRecordHeader)
+    {
+        record.resize(kRecordHeader);
+        if (!in.read(&record[0], kRecordHeader))
+            break;
+        FrameReader recordHeader(record);
+        const std::uint32_t length = recordHeader.U32();
+        const std::uint32_t crc = recordHeader.U32();
+        if (length > kMaxRecord || size - pos - kRecordHeader < length)
+            break;
+        record.resize(length);
+        if (length > 0 && !in.read(&record[0], length))
+            break;
+        if (crc32(record) != crc)
+            break;
+
+        // validate the whole record before applying any of it
+        if (!ParseRecord(record, ReplayCallback(), seats))
+        {
+            // the crc matched, so this is not a torn write: refuse the log rather than cut it here
+            result.ok = false;
+            result.corrupt = true;
+            break;
+        }
+        if (result.end >= from)
+        {
+            // records before `from` are still checked so the tail is found
+            if (apply)
+                ParseRecord(record, apply, seats);
+            ++result.records;
+        }
+        pos += kRecordHeader + length;
+        result.end += kRecordHeader + length;
+    }
+    result.valid_bytes = pos;
+    result.torn_tail = result.ok && pos < size;
+    return result;
+}
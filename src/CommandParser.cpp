@@ -0,0 +1,198 @@
+#include <CommandParser.hpp>
+
+#include <charconv>
+
+namespace
+{
+    inline bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    inline char to_lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // case-insensitive compare of `word` against a lower case literal of the same length
+    inline bool equals_lower(std::string_view word, const char* literal)
+    {
+        for (std::size_t i = 0; i < word.size(); ++i)
+            if (to_lower(word[i]) != literal[i])
+                return false;
+        return true;
+    }
+
+    std::string_view skip_leading_space(std::string_view s)
+    {
+        std::size_t i = 0;
+        while (i < s.size() && is_space(s[i]))
+            ++i;
+        return s.substr(i);
+    }
+
+    std::string_view trim(std::string_view s)
+    {
+        s = skip_leading_space(s);
+        while (!s.empty() && is_space(s.back()))
+            s.remove_suffix(1);
+        return s;
+    }
+}
+
+Command CommandParser::Lookup(std::string_view word)
+{
+    // perfect dispatch: the length picks the candidate, one compare confirms it
+    switch (word.size())
+    {
+    case 5:
+        return equals_lower(word, "stats") ? Command::Stats : Command::Unknown;
+    case 6:
+        return equals_lower(word, "binary") ? Command::Binary : Command::Unknown;
+    case 9:
+        return equals_lower(word, "book_best") ? Command::BookBest : Command::Unknown;
+    case 10:
+        if (to_lower(word[0]) == 'h')
+            return equals_lower(word, "hold_seats") ? Command::HoldSeats : Command::Unknown;
+        if (to_lower(word[5]) == 'b')
+            return equals_lower(word, "book_batch") ? Command::BookBatch : Command::Unknown;
+        return equals_lower(word, "book_seats") ? Command::BookSeats : Command::Unknown;
+    case 11:
+        return equals_lower(word, "list_movies") ? Command::ListMovies : Command::Unknown;
+    case 12:
+        switch (to_lower(word[0]))
+        {
+        case 'c':
+            return equals_lower(word, "confirm_hold") ? Command::ConfirmHold : Command::Unknown;
+        case 'r':
+            return equals_lower(word, "release_hold") ? Command::ReleaseHold : Command::Unknown;
+        default:
+            return equals_lower(word, "select_movie") ? Command::SelectMovie : Command::Unknown;
+        }
+    case 13:
+        return equals_lower(word, "list_theaters") ? Command::ListTheaters : Command::Unknown;
+    case 14:
+        if (to_lower(word[0]) == 's')
+            return equals_lower(word, "select_theater") ? Command::SelectTheater : Command::Unknown;
+        return equals_lower(word, "get_free_seats") ? Command::GetFreeSeats : Command::Unknown;
+    default:
+        return Command::Unknown;
+    }
+}
+
+ParsedCommand CommandParser::Parse(std::string_view line)
+{
+    ParsedCommand result;
+
+    line = skip_leading_space(line);
+    std::size_t end = 0;
+    while (end < line.size() && !is_space(line[end]))
+        ++end;
+    if (end == 0)
+        return result;                                  // blank line
+
+    result.command = Lookup(line.substr(0, end));
+
+    std::string_view arg = skip_leading_space(line.substr(end));
+    while (!arg.empty() && (arg.back() == ' ' || arg.back() == '\r'))
+        arg.remove_suffix(1);
+    result.argument = arg;
+    return result;
+}
+
+SeatListStatus CommandParser::ParseSeats(std::string_view args, std::size_t capacity, std::vector<unsigned int>& seats)
+{
+    seats.clear();
+    const char* p = args.data();
+    const char* const end = p + args.size();
+
+    while (true)
+    {
+        while (p < end && is_space(*p))                 // whitespace allowed before each number
+            ++p;
+        if (p < end && *p == '+')
+            ++p;
+
+        long seat = 0;
+        auto [next, ec] = std::from_chars(p, end, seat);
+        if (ec != std::errc())
+        {
+            if (ec == std::errc::result_out_of_range)
+            {
+                seats.clear();
+                return SeatListStatus::OutOfRange;
+            }
+            break;                                      // not a number: the list ends here
+        }
+        p = next;
+
+        if (seat < 1 || static_cast<unsigned long>(seat) > capacity)
+        {
+            seats.clear();
+            return SeatListStatus::OutOfRange;
+        }
+        seats.push_back(static_cast<unsigned int>(seat));
+
+        if (p < end && *p == ',')
+            ++p;
+        else
+            break;
+    }
+
+    if (seats.empty())
+        return SeatListStatus::Empty;
+    if (seats.size() > capacity)
+    {
+        seats.clear();
+        return SeatListStatus::TooMany;
+    }
+    return SeatListStatus::Ok;
+}
+
+bool CommandParser::ParseNumber(std::string_view text, std::uint64_t& value)
+{
+    const char* const end = text.data() + text.size();
+    auto [next, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && next == end;
+}
+
+bool CommandParser::ParseBestRequest(std::string_view args, std::uint64_t& count, bool& contiguous)
+{
+    std::size_t end = 0;
+    while (end < args.size() && !is_space(args[end]))
+        ++end;
+    const std::string_view option = trim(args.substr(end));
+    if (!ParseNumber(args.substr(0, end), count))
+        return false;
+
+    contiguous = !option.empty();
+    return option.empty() || (option.size() == 10 && equals_lower(option, "contiguous"));
+}
+
+bool CommandParser::NextBatchItem(std::string_view& rest, std::string_view& item)
+{
+    while (!rest.empty())
+    {
+        const std::size_t end = rest.find(';');
+        item = trim(rest.substr(0, end));
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+        if (!item.empty())
+            return true;
+    }
+    return false;
+}
+
+bool CommandParser::SplitBatchItem(std::string_view item, std::string_view& movie, std::string_view& theater, std::string_view& seats)
+{
+    const std::size_t first = item.find('|');
+    if (first == std::string_view::npos)
+        return false;
+    const std::size_t second = item.find('|', first + 1);
+    if (second == std::string_view::npos || item.find('|', second + 1) != std::string_view::npos)
+        return false;
+
+    movie = trim(item.substr(0, first));
+    theater = trim(item.substr(first + 1, second - first - 1));
+    seats = trim(item.substr(second + 1));
+    return !movie.empty() && !theater.empty() && !seats.empty();
+}
@@ -0,0 +1,78 @@
+#include <EpochManager.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // one slot per thread that ever read; cache-line sized so readers never share a line
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<std::uint64_t> epoch{ EpochManager::kNoReader };   // pinned epoch, kNoReader when idle
+        std::atomic<bool> owned{ false };                               // a live thread uses the slot
+    };
+
+    std::atomic<std::uint64_t> g_epoch{ 1 };
+
+    std::mutex g_slots_mutex;                                           // guards g_slots (never the read path)
+    std::vector<std::unique_ptr<ReaderSlot>> g_slots;
+
+    ReaderSlot* claim_slot()
+    {
+        std::lock_guard<std::mutex> lock(g_slots_mutex);
+        for (auto &slot : g_slots)
+        {
+            bool expected = false;
+            if (slot->owned.compare_exchange_strong(expected, true))
+                return slot.get();                                      // reuse a slot of an exited thread
+        }
+        g_slots.push_back(std::make_unique<ReaderSlot>());
+        g_slots.back()->owned.store(true);
+        return g_slots.back().get();
+    }
+
+    // per-thread registration; hands the slot back when the thread exits
+    struct ThreadState
+    {
+        ReaderSlot* slot = claim_slot();
+        unsigned int depth = 0;
+        ~ThreadState()
+        {
+            slot->epoch.store(EpochManager::kNoReader);
+            slot->owned.store(false);
+        }
+    };
+
+    thread_local ThreadState t_state;
+}
+
+EpochManager::ReadGuard::ReadGuard()
+{
+    if (t_state.depth++ == 0)
+        t_state.slot->epoch.store(g_epoch.load());                      // seq_cst: ordered before the caller's pointer load
+}
+
+EpochManager::ReadGuard::~ReadGuard()
+{
+    if (--t_state.depth == 0)
+        t_state.slot->epoch.store(kNoReader, std::memory_order_release);
+}
+
+std::uint64_t EpochManager::Advance()
+{
+    return g_epoch.fetch_add(1);
+}
+
+std::uint64_t EpochManager::MinActive()
+{
+    std::uint64_t min = kNoReader;
+    std::lock_guard<std::mutex> lock(g_slots_mutex);
+    for (const auto &slot : g_slots)
+    {
+        std::uint64_t e = slot->epoch.load();
+        if (e < min)
+            min = e;
+    }
+    return min;
+}
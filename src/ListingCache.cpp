@@ -0,0 +1,94 @@
+#include <ListingCache.hpp>
+#include <EpochManager.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    constexpr char kNoMovies[] = "No movies running\n";
+    constexpr char kNoTheaters[] = "Movie is not running in any theater\n";
+
+    // allocated non-const: a session may recycle a buffer it holds the last reference to
+    ListingCache::buffer_ptr make_buffer(std::string text)
+    {
+        return std::make_shared<std::string>(std::move(text));
+    }
+}
+
+ListingCache::ListingCache(IMovieBooker& booker) : booker_(booker)
+{
+}
+
+ListingCache::~ListingCache() = default;
+
+ListingCache::buffer_ptr ListingCache::Movies()
+{
+    const std::uint64_t version = booker_.GetCatalogVersion();
+    EpochManager::ReadGuard guard;
+    return load(version)->movies;
+}
+
+ListingCache::buffer_ptr ListingCache::Theaters(IMovieBooker::MovieId id)
+{
+    const std::uint64_t version = booker_.GetCatalogVersion();
+    EpochManager::ReadGuard guard;
+    const Listings* listings = load(version);
+    auto it = listings->theaters.find(id);
+    if (it == listings->theaters.end())
+        return listings->no_theaters;                   // stopped running since the caller resolved it
+    return it->second;
+}
+
+std::uint64_t ListingCache::GetVersion() const
+{
+    EpochManager::ReadGuard guard;
+    const Listings* listings = listings_.load();
+    return listings ? listings->version : 0;
+}
+
+std::string ListingCache::Format(const std::vector<std::string>& names, const char* none)
+{
+    if (names.empty())
+        return none;
+    std::size_t size = 1;
+    for (const auto &name : names)
+        size += name.size() + 1;
+    std::string text;
+    text.reserve(size);
+    for (const auto &name : names)
+        text.append(name).push_back(',');
+    text.push_back('\n');
+    return text;
+}
+
+const ListingCache::Listings* ListingCache::load(std::uint64_t version)
+{
+    const Listings* listings = listings_.load();
+    if (listings && listings->version >= version)
+        return listings;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    listings = listings_.load();
+    if (listings && listings->version >= version)
+        return listings;                                // another request rebuilt meanwhile
+
+    auto next = std::make_unique<Listings>();
+    next->version = version;
+    next->movies = make_buffer(Format(booker_.GetMovies(), kNoMovies));
+    next->no_theaters = make_buffer(kNoTheaters);
+    const auto movies = booker_.GetMovieList();
+    next->theaters.reserve(movies.size());
+    for (const auto &movie : movies)
+        next->theaters.emplace(movie.first, make_buffer(Format(booker_.GetTheatersForMovie(movie.second), kNoTheaters)));
+
+    listings = next.get();
+    listings_.store(listings);                          // seq_cst: pairs with the reader's epoch pin
+    retired_.emplace_back(EpochManager::Advance(), std::move(current_));
+    current_ = std::move(next);
+
+    // free replaced sets that no reader pinned early enough to see
+    const std::uint64_t minActive = EpochManager::MinActive();
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+        [minActive](const auto &r) { return r.first < minActive; }), retired_.end());
+    return listings;
+}
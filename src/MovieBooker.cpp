@@ -1,136 +1,998 @@
 #include <MovieBooker.hpp>
+#include <EpochManager.hpp>
+#include <CatalogSnapshot.hpp>
+#include <MappedFile.hpp>
 
 #include <algorithm>
-#include <set>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
 
-static constexpr std::size_t kSeatsPerTheater = 20;
+#ifdef _MSC_VER
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
-bool MovieBooker::AddMovie(const std::string& movie, const std::vector<std::string>& theatres) 
+MovieBooker::MovieBooker(std::size_t seatsPerTheater)
+    : current_(std::make_unique<Catalog>()), seats_per_theater_(seatsPerTheater),
+      hold_epoch_(std::chrono::steady_clock::now())
+{
+    catalog_.store(current_.get());
+}
+
+MovieBooker::~MovieBooker() = default;
+
+bool MovieBooker::AddMovie(const std::string& movie, const std::vector<std::string>& theatres)
 {
     if (movie.empty() || theatres.empty()) return false;
 
     std::lock_guard<std::mutex> lock(map_mutex_);
 
-    // ensure movie entry map exists (creates if missing)
-    auto &theater_map = movie_theaters_[movie];
+    // build the next version from a copy of the published one
+    auto next = std::make_unique<Catalog>(*current_);
+    ++next->version;
+
+    std::vector<TheaterEntry> block;
+    block.reserve(theatres.size());
+    AddShowings(*next, movie, theatres, block);
+    if (!block.empty())
+        entries_.push_back(std::move(block));
+
+    Publish(std::move(next));
+    return true;
+}
+
+bool MovieBooker::AddCatalog(const CatalogChunk& chunk)
+{
+    if (chunk.theaters.empty() && chunk.movies.empty())
+        return true;
 
-    for (const auto &theater : theatres) 
+    std::size_t showingCount = 0;
+    for (const auto &movie : chunk.movies)
+        showingCount += movie.second.size();
+
+    std::lock_guard<std::mutex> lock(map_mutex_);
+
+    // one copy and one publish for the whole chunk, every table sized up front
+    auto next = std::make_unique<Catalog>(*current_);
+    ++next->version;
+    const std::size_t theaters = next->theater_names.size() + chunk.theaters.size();
+    next->theater_index.reserve(theaters);
+    next->theater_seats.reserve(theaters);
+    next->theater_names.reserve(theaters);
+    const std::size_t movies = next->movie_names.size() + chunk.movies.size();
+    next->movie_index.reserve(movies);
+    next->movie_names.reserve(movies);
+    next->movie_showings.reserve(movies);
+    next->movie_theaters.reserve(movies);
+    next->showings.reserve(next->showings.size() + showingCount);
+
+    bool ok = true;
+    for (const auto &theater : chunk.theaters)
     {
-        // ensure theater has an id
-        auto tit = theater_index_.find(theater);
-        if (tit == theater_index_.end()) 
+        if (theater.first.empty() || theater.second == 0 || next->theater_index.count(theater.first))
+            ok = false;
+        else
+            EnsureTheater(*next, theater.first, theater.second);
+    }
+
+    std::vector<TheaterEntry> block;
+    block.reserve(showingCount);
+    for (const auto &movie : chunk.movies)
+    {
+        if (movie.first.empty() || movie.second.empty())
+            ok = false;
+        else
+            AddShowings(*next, movie.first, movie.second, block);
+    }
+    if (!block.empty())
+        entries_.push_back(std::move(block));
+
+    Publish(std::move(next));
+    return ok;
+}
+
+void MovieBooker::ReplaceCatalog(const CatalogChunk& chunk, CatalogDiff* diff)
+{
+    CatalogDiff local;
+    CatalogDiff &out = diff ? *diff : local;
+    out = CatalogDiff();
+
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    auto next = std::make_unique<Catalog>(*current_);
+    ++next->version;
+
+    // capacities only size showings created from now on
+    for (const auto &theater : chunk.theaters)
+        if (!theater.first.empty() && theater.second > 0)
+            EnsureTheater(*next, theater.first, theater.second);
+
+    // mark the showings the new catalog keeps and collect the ones it adds
+    std::vector<char> keep(next->showings.size(), 0);
+    std::vector<std::pair<const std::string*, std::vector<std::string>>> additions;
+    std::size_t showingCount = 0;
+    for (const auto &movie : chunk.movies)
+    {
+        if (movie.first.empty())
+            continue;
+        const auto mit = next->movie_theaters.find(movie.first);
+        std::vector<std::string> added;
+        for (const auto &theater : movie.second)
         {
-            std::size_t tid = theater_index_.size();
-            theater_index_.emplace(theater, tid);
-            tit = theater_index_.find(theater);
+            if (mit != next->movie_theaters.end())
+            {
+                const auto it = mit->second.find(theater);
+                if (it != mit->second.end())
+                {
+                    keep[it->second] = 1;
+                    continue;
+                }
+            }
+            if (!theater.empty())
+                added.push_back(theater);
         }
-        std::size_t tid = tit->second;
+        if (!added.empty())
+        {
+            showingCount += added.size();
+            additions.emplace_back(&movie.first, std::move(added));
+        }
+    }
 
-        // ensure theater entry for this movie exists
-        auto it = theater_map.find(theater);
-        if (it == theater_map.end()) 
-            theater_map.emplace(theater, std::make_unique<TheaterEntry>(tid, kSeatsPerTheater));
+    // drop the others from the maps; their entries stay alive for bookings in flight
+    for (ShowingId sid = 0; sid < keep.size(); ++sid)
+    {
+        TheaterEntry* entry = next->showings[sid];
+        if (!entry)
+            continue;
+        if (keep[sid])
+        {
+            ++out.kept_showings;
+            continue;
+        }
+        auto mit = next->movie_theaters.find(next->movie_names[entry->movie_id]);
+        mit->second.erase(next->theater_names[entry->theater_id]);
+        if (mit->second.empty())
+            next->movie_theaters.erase(mit);
+        next->movie_showings[entry->movie_id].erase(static_cast<TheaterId>(entry->theater_id));
+        next->showings[sid] = nullptr;
+        ++out.removed_showings;
     }
 
-    return true;
+    std::vector<TheaterEntry> block;
+    block.reserve(showingCount);
+    next->showings.reserve(next->showings.size() + showingCount);
+    for (const auto &movie : additions)
+        AddShowings(*next, *movie.first, movie.second, block);
+    out.added_showings = block.size();
+    if (!block.empty())
+        entries_.push_back(std::move(block));
+
+    for (const auto &movie : current_->movie_theaters)
+        out.removed_movies += next->movie_theaters.count(movie.first) == 0;
+    out.added_movies = next->movie_theaters.size() + out.removed_movies - current_->movie_theaters.size();
+
+    Publish(std::move(next));
+}
+
+void MovieBooker::AddShowings(Catalog& next, const std::string& movie, const std::vector<std::string>& theatres, std::vector<TheaterEntry>& block)
+{
+    // ensure movie has an id and an entry map (creates if missing)
+    auto mid = next.movie_index.find(movie);
+    if (mid == next.movie_index.end())
+    {
+        mid = next.movie_index.emplace(movie, static_cast<MovieId>(next.movie_showings.size())).first;
+        next.movie_showings.emplace_back();
+        next.movie_names.push_back(movie);
+    }
+    auto &theater_map = next.movie_theaters[movie];
+    auto &showing_map = next.movie_showings[mid->second];
+    theater_map.reserve(theater_map.size() + theatres.size());
+    showing_map.reserve(showing_map.size() + theatres.size());
+
+    for (const auto &theater : theatres)
+    {
+        // ensure theater has an id
+        TheaterId tid = EnsureTheater(next, theater, seats_per_theater_);
+
+        // one lookup: the insert fails if the theater already shows this movie
+        const ShowingId sid = static_cast<ShowingId>(next.showings.size());
+        if (theater_map.emplace(theater, sid).second)
+        {
+            block.emplace_back(mid->second, tid, next.theater_seats[tid]);
+            next.showings.push_back(&block.back());
+            showing_map.emplace(tid, sid);
+        }
+    }
 }
 
-std::vector<std::string> MovieBooker::GetMovies() 
+bool MovieBooker::AddTheater(const std::string& theater, std::size_t seats)
 {
+    if (theater.empty() || seats == 0)
+        return false;
+
     std::lock_guard<std::mutex> lock(map_mutex_);
+    if (current_->theater_index.count(theater))
+        return false;                                   // existing showings are already sized
+
+    auto next = std::make_unique<Catalog>(*current_);
+    ++next->version;
+    EnsureTheater(*next, theater, seats);
+
+    Publish(std::move(next));
+    return true;
+}
+
+IMovieBooker::TheaterId MovieBooker::EnsureTheater(Catalog& catalog, const std::string& theater, std::size_t seats)
+{
+    auto it = catalog.theater_index.find(theater);
+    if (it == catalog.theater_index.end())
+    {
+        it = catalog.theater_index.emplace(theater, static_cast<TheaterId>(catalog.theater_seats.size())).first;
+        catalog.theater_seats.push_back(seats);
+        catalog.theater_names.push_back(theater);
+    }
+    return it->second;
+}
+
+void MovieBooker::Publish(std::unique_ptr<Catalog> next)
+{
+    catalog_.store(next.get());                         // seq_cst: pairs with the reader's epoch pin
+    retired_.emplace_back(EpochManager::Advance(), std::move(current_));
+    current_ = std::move(next);
+
+    // free replaced versions that no reader pinned early enough to see
+    const std::uint64_t minActive = EpochManager::MinActive();
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+        [minActive](const auto &r) { return r.first < minActive; }), retired_.end());
+}
+
+MovieBooker::TheaterEntry* MovieBooker::FindShowing(const std::string& theater, const std::string& movie) const
+{
+    const Catalog &catalog = *catalog_.load();
+    auto mit = catalog.movie_theaters.find(movie);
+    if (mit == catalog.movie_theaters.end())
+        return nullptr;                                 // movie not found
+
+    auto it = mit->second.find(theater);
+    if (it == mit->second.end())
+        return nullptr;                                 // theater not showing this movie
+
+    return catalog.showings[it->second];
+}
+
+MovieBooker::TheaterEntry* MovieBooker::FindShowing(ShowingId showing) const
+{
+    const Catalog &catalog = *catalog_.load();
+    return showing < catalog.showings.size() ? catalog.showings[showing] : nullptr;
+}
+
+std::vector<std::string> MovieBooker::GetMovies()
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+
     std::vector<std::string> result;
-    result.reserve(movie_theaters_.size());
-    for (const auto &p : movie_theaters_)
+    result.reserve(catalog.movie_theaters.size());
+    for (const auto &p : catalog.movie_theaters)
         result.push_back(p.first);
-   
+
     return result;
 }
 
-std::vector<std::string> MovieBooker::GetTheatersForMovie(const std::string& movie) 
+std::vector<std::string> MovieBooker::GetTheatersForMovie(const std::string& movie)
 {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto mit = movie_theaters_.find(movie);
-    if (mit == movie_theaters_.end())
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+
+    auto mit = catalog.movie_theaters.find(movie);
+    if (mit == catalog.movie_theaters.end())
         return {};                                      // no such movie
 
     std::vector<std::string> result;
     result.reserve(mit->second.size());
-    for (const auto &p : mit->second) 
+    for (const auto &p : mit->second)
         result.push_back(p.first);
-    
+
     return result;
 }
 
 
-std::vector<unsigned int> MovieBooker::GetFreeSeats(const std::string& theater, const std::string& movie) 
+std::vector<unsigned int> MovieBooker::GetFreeSeats(const std::string& theater, const std::string& movie)
 {
-    if (theater.empty() || movie.empty()) 
+    if (theater.empty() || movie.empty())
         return {};
 
-    std::unique_lock<std::mutex> mapLock(map_mutex_);
-    auto mit = movie_theaters_.find(movie);
-    if (mit == movie_theaters_.end()) 
-        return {};                                  // movie not found
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(theater, movie);
+    }
+    if (!entry)
+        return {};                                      // entries outlive every catalog version
+
+    std::vector<unsigned int> freeSeats;
+    entry->seats.CollectFree(freeSeats);
+
+    return freeSeats;
+}
+
+bool MovieBooker::IsTheater(const std::string& theater)
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    return catalog.theater_index.find(theater) != catalog.theater_index.end();
+}
+
+bool MovieBooker::BookSeats(const std::string& theater, const std::string& movie, const std::vector<unsigned int>& seatIds)
+{
+    if (theater.empty() || seatIds.empty() || movie.empty())
+        return false;
+
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(theater, movie);
+    }
+    if (!entry)
+        return false;
+
+    // all-or-nothing; rejects out of range or repeated ids and already booked seats
+    {
+        const ChangeGuard change(entry, track_changes_);
+        if (!entry->seats.TryClaim(seatIds.data(), seatIds.size()))
+            return false;
+    }
+    const Claim claim(entry, &seatIds);
+    return LogClaims(&claim, 1);
+}
 
-    auto &theater_map = mit->second;
-    auto it = theater_map.find(theater);
-    if (it == theater_map.end())
-        return {};                                  // theater not showing this movie
+std::optional<IMovieBooker::MovieId> MovieBooker::ResolveMovie(const std::string& movie)
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    auto it = catalog.movie_index.find(movie);
+    if (it == catalog.movie_index.end() || catalog.movie_showings[it->second].empty())
+        return std::nullopt;                            // unknown or all showings removed
+    return it->second;
+}
 
-    auto &entry = *it->second;
-    std::unique_lock<std::mutex> entryLock(entry.mutex);
-    mapLock.unlock();
+std::optional<IMovieBooker::TheaterId> MovieBooker::ResolveTheater(const std::string& theater)
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    auto it = catalog.theater_index.find(theater);
+    if (it == catalog.theater_index.end())
+        return std::nullopt;
+    return it->second;
+}
+
+std::optional<IMovieBooker::ShowingId> MovieBooker::ResolveShowing(MovieId movie, TheaterId theater)
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    if (movie >= catalog.movie_showings.size())
+        return std::nullopt;
+    auto &showings = catalog.movie_showings[movie];
+    auto it = showings.find(theater);
+    if (it == showings.end())
+        return std::nullopt;                            // theater not showing this movie
+    return it->second;
+}
+
+std::vector<std::pair<IMovieBooker::MovieId, std::string>> MovieBooker::GetMovieList()
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+
+    std::vector<std::pair<MovieId, std::string>> result;
+    result.reserve(catalog.movie_index.size());
+    for (const auto &p : catalog.movie_index)
+        if (!catalog.movie_showings[p.second].empty())
+            result.emplace_back(p.second, p.first);
+
+    return result;
+}
+
+std::vector<std::pair<IMovieBooker::TheaterId, std::string>> MovieBooker::GetTheaterList(MovieId movie)
+{
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    if (movie >= catalog.movie_showings.size())
+        return {};                                      // no such movie
+
+    const auto &showings = catalog.movie_showings[movie];
+    std::vector<std::pair<TheaterId, std::string>> result;
+    result.reserve(showings.size());
+    for (const auto &p : showings)
+        result.emplace_back(p.first, catalog.theater_names[p.first]);
+
+    return result;
+}
+
+std::vector<unsigned int> MovieBooker::GetFreeSeats(ShowingId showing)
+{
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    if (!entry)
+        return {};
 
     std::vector<unsigned int> freeSeats;
-    freeSeats.reserve(entry.seats.size());
-    for (std::size_t i = 0; i < entry.seats.size(); ++i) 
-        if (!entry.seats[i])
-            freeSeats.push_back(static_cast<unsigned int>(i + 1));
-    
+    entry->seats.CollectFree(freeSeats);
+
     return freeSeats;
 }
 
-bool MovieBooker::IsTheater(const std::string& theater) 
+bool MovieBooker::BookSeats(ShowingId showing, const std::vector<unsigned int>& seatIds)
 {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    return theater_index_.find(theater) != theater_index_.end();
+    if (seatIds.empty())
+        return false;
+
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    if (!entry)
+        return false;
+    {
+        const ChangeGuard change(entry, track_changes_);
+        if (!entry->seats.TryClaim(seatIds.data(), seatIds.size()))
+            return false;
+    }
+
+    const Claim claim(entry, &seatIds);
+    return LogClaims(&claim, 1);
+}
+
+bool MovieBooker::BookBatch(const std::vector<BookingItem>& items)
+{
+    if (items.empty())
+        return false;
+
+    // resolve everything before claiming anything
+    std::vector<std::pair<TheaterEntry*, const BookingItem*>> sorted;
+    sorted.reserve(items.size());
+    {
+        EpochManager::ReadGuard guard;
+        for (const auto &item : items)
+        {
+            TheaterEntry* entry = FindShowing(item.showing);
+            if (!entry || item.seats.empty())
+                return false;
+            sorted.emplace_back(entry, &item);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(),
+        [](const auto &a, const auto &b) { return a.second->showing < b.second->showing; });
+
+    // one claim per showing; items of the same showing are merged
+    std::vector<Claim> claims;
+    std::vector<std::vector<unsigned int>> merged;
+    claims.reserve(sorted.size());
+    merged.reserve(sorted.size());                      // no reallocation: claims point into it
+    for (std::size_t i = 0; i < sorted.size(); )
+    {
+        std::size_t j = i + 1;
+        while (j < sorted.size() && sorted[j].first == sorted[i].first)
+            ++j;
+        if (j == i + 1)
+            claims.emplace_back(sorted[i].first, &sorted[i].second->seats);
+        else
+        {
+            merged.emplace_back();
+            for (std::size_t k = i; k < j; ++k)
+                merged.back().insert(merged.back().end(), sorted[k].second->seats.begin(), sorted[k].second->seats.end());
+            claims.emplace_back(sorted[i].first, &merged.back());
+        }
+        i = j;
+    }
+
+    bool claimed = false;
+    for (unsigned int attempt = 0; attempt < kBatchAttempts; ++attempt)
+    {
+        if (attempt > 0)
+            std::this_thread::yield();
+        // batches always bracket their claims: a snapshot must not copy a showing
+        // claimed here and then rolled back, and a failed batch must tell such a
+        // claim from a booking
+        for (const auto &claim : claims)
+            claim.first->changes.started.fetch_add(1, std::memory_order_acquire);
+        claimed = true;
+        std::size_t failed = claims.size();
+        for (std::size_t c = 0; c < claims.size() && claimed; ++c)
+        {
+            const auto &seats = *claims[c].second;
+            if (!claims[c].first->seats.TryClaim(seats.data(), seats.size()))
+            {
+                // undo the showings claimed so far; nobody else can free seats we hold
+                ReleaseClaims(claims.data(), c);
+                claimed = false;
+                failed = c;
+            }
+        }
+        for (const auto &claim : claims)
+            claim.first->changes.finished.fetch_add(1, std::memory_order_release);
+        if (claimed || !MayBeRolledBack(claims[failed]))
+            break;
+    }
+    return claimed && LogClaims(claims.data(), claims.size());
 }
 
-bool MovieBooker::BookSeats(const std::string& theater, const std::string& movie, const std::vector<unsigned int>& seatIds) 
+bool MovieBooker::MayBeRolledBack(const Claim& claim)
 {
-    if (theater.empty() || seatIds.empty() || movie.empty()) 
+    // every change that ended before `finished` was read is complete; if no
+    // change was in flight across the seat reads either, the taken seats are booked
+    const ChangeCount &changes = claim.first->changes;
+    const std::uint64_t finished = changes.finished.load(std::memory_order_acquire);
+    bool taken = false;
+    for (unsigned int seat : *claim.second)
+    {
+        if (seat == 0 || seat > claim.first->seats.Size())
+            return false;
+        taken = taken || claim.first->seats.IsBooked(seat);
+    }
+    return !taken || changes.started.load(std::memory_order_acquire) != finished;
+}
+
+bool MovieBooker::BookBest(ShowingId showing, std::size_t count, bool contiguous, std::vector<unsigned int>& seats)
+{
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    if (!entry)
+    {
+        seats.clear();
         return false;
+    }
+    {
+        const ChangeGuard change(entry, track_changes_);
+        if (!entry->seats.ClaimBest(count, contiguous, seats))
+            return false;
+    }
+
+    const Claim claim(entry, &seats);
+    if (LogClaims(&claim, 1))
+        return true;
+    seats.clear();
+    return false;
+}
+
+std::optional<IMovieBooker::HoldId> MovieBooker::HoldSeats(ShowingId showing, const std::vector<unsigned int>& seatIds, std::chrono::milliseconds ttl)
+{
+    if (seatIds.empty())
+        return std::nullopt;
+
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    if (!entry)
+        return std::nullopt;
+    {
+        const ChangeGuard change(entry, track_changes_);
+        if (!entry->seats.TryClaim(seatIds.data(), seatIds.size()))
+            return std::nullopt;
+        entry->held.TryClaim(seatIds.data(), seatIds.size());  // cannot fail: only we own these seats now
+    }
+
+    const std::uint64_t deadline = ToTick(std::chrono::steady_clock::now() + ttl);
+
+    std::lock_guard<std::mutex> lock(hold_mutex_);
+    std::uint32_t index;
+    if (!free_holds_.empty())
+    {
+        index = free_holds_.back();
+        free_holds_.pop_back();
+    }
+    else
+    {
+        index = static_cast<std::uint32_t>(holds_.size());
+        holds_.emplace_back();
+    }
+    Hold& hold = holds_[index];
+    hold.active = true;
+    hold.entry = entry;
+    hold.seats = seatIds;
+    ++active_holds_;
+
+    const HoldId id = (HoldId(hold.generation) << 32) | index;
+    hold_wheel_.Schedule(id, deadline);
+    return id;
+}
+
+bool MovieBooker::ConfirmHold(HoldId hold)
+{
+    TheaterEntry* entry;
+    std::vector<unsigned int> seats;
+    {
+        std::lock_guard<std::mutex> lock(hold_mutex_);
+        if (!TakeHold(hold, entry, seats))
+            return false;
+    }
+    {
+        const ChangeGuard change(entry, track_changes_);
+        entry->held.Release(seats.data(), seats.size());   // the seats stay booked
+    }
+    const Claim claim(entry, &seats);
+    return LogClaims(&claim, 1);
+}
 
-    std::set<unsigned int> uniqueIds;
-    for (auto id : seatIds) 
+bool MovieBooker::ReleaseHold(HoldId hold)
+{
+    TheaterEntry* entry;
+    std::vector<unsigned int> seats;
     {
-        if (id == 0 || id > kSeatsPerTheater)                   // seat number out of range
+        std::lock_guard<std::mutex> lock(hold_mutex_);
+        if (!TakeHold(hold, entry, seats))
             return false;
-        uniqueIds.insert(id);
     }
-    if (uniqueIds.size() != seatIds.size())                     // seats are not unique
+    const ChangeGuard change(entry, track_changes_);
+    entry->held.Release(seats.data(), seats.size());
+    entry->seats.Release(seats.data(), seats.size());
+    return true;
+}
+
+std::size_t MovieBooker::ExpireHolds(std::chrono::steady_clock::time_point now)
+{
+    if (now < hold_epoch_)
+        return 0;
+    const std::uint64_t tick = static_cast<std::uint64_t>((now - hold_epoch_) / kHoldTick);
+
+    // detach under the lock, give the seats back outside it
+    std::vector<std::pair<TheaterEntry*, std::vector<unsigned int>>> released;
+    {
+        std::lock_guard<std::mutex> lock(hold_mutex_);
+        expired_.clear();
+        hold_wheel_.Advance(tick, expired_);
+        for (HoldId id : expired_)
+        {
+            TheaterEntry* entry;
+            std::vector<unsigned int> seats;
+            if (TakeHold(id, entry, seats))             // confirmed and released holds are skipped
+                released.emplace_back(entry, std::move(seats));
+        }
+    }
+    for (const auto &hold : released)
+    {
+        const ChangeGuard change(hold.first, track_changes_);
+        hold.first->held.Release(hold.second.data(), hold.second.size());
+        hold.first->seats.Release(hold.second.data(), hold.second.size());
+    }
+    return released.size();
+}
+
+std::size_t MovieBooker::GetHoldCount() const
+{
+    std::lock_guard<std::mutex> lock(hold_mutex_);
+    return active_holds_;
+}
+
+std::size_t MovieBooker::GetHeldSeatCount(ShowingId showing) const
+{
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    return entry ? entry->held.Size() - entry->held.CountFree() : 0;
+}
+
+void MovieBooker::SetBookingLog(BookingLog* log)
+{
+    log_ = log;
+}
+
+void MovieBooker::EnableConcurrentSnapshots()
+{
+    track_changes_ = true;
+}
+
+bool MovieBooker::LogClaims(const Claim* claims, std::size_t count)
+{
+    if (!log_)
+        return true;
+
+    // the record names the showings; the names live in the published catalog
+    thread_local std::vector<LoggedBooking> records;
+    records.clear();
+    EpochManager::ReadGuard guard;
+    const Catalog &catalog = *catalog_.load();
+    for (std::size_t i = 0; i < count; ++i)
+        records.push_back({ catalog.movie_names[claims[i].first->movie_id], catalog.theater_names[claims[i].first->theater_id],
+            claims[i].second->data(), claims[i].second->size() });
+    return log_->Append(records.data(), records.size());
+}
+
+void MovieBooker::ReleaseClaims(const Claim* claims, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        claims[i].first->seats.Release(claims[i].second->data(), claims[i].second->size());
+}
+
+bool MovieBooker::TakeHold(HoldId hold, TheaterEntry*& entry, std::vector<unsigned int>& seats)
+{
+    const std::uint32_t index = static_cast<std::uint32_t>(hold);
+    if (index >= holds_.size())
         return false;
+    Hold& slot = holds_[index];
+    if (!slot.active || slot.generation != static_cast<std::uint32_t>(hold >> 32))
+        return false;
+
+    entry = slot.entry;
+    seats = std::move(slot.seats);
+    slot.active = false;
+    slot.entry = nullptr;
+    slot.seats.clear();
+    if (++slot.generation == 0)                         // 0 would make HoldId 0 valid
+        slot.generation = 1;
+    free_holds_.push_back(index);
+    --active_holds_;
+    return true;
+}
 
-    std::unique_lock<std::mutex> mapLock(map_mutex_);
-    auto mit = movie_theaters_.find(movie);
-    if (mit == movie_theaters_.end()) return false;
+std::uint64_t MovieBooker::ToTick(std::chrono::steady_clock::time_point time) const
+{
+    if (time <= hold_epoch_)
+        return 0;
+    const auto elapsed = time - hold_epoch_;
+    const std::uint64_t ticks = static_cast<std::uint64_t>(elapsed / kHoldTick);
+    return elapsed % kHoldTick == elapsed.zero() ? ticks : ticks + 1;
+}
 
-    auto &theater_map = mit->second;
-    auto it = theater_map.find(theater);
-    if (it == theater_map.end())                                // theater not found for this movie
+std::size_t MovieBooker::GetSeatCount(ShowingId showing)
+{
+    TheaterEntry* entry;
+    {
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(showing);
+    }
+    return entry ? entry->seats.Size() : 0;
+}
+
+std::uint64_t MovieBooker::GetCatalogVersion() const
+{
+    EpochManager::ReadGuard guard;
+    return catalog_.load()->version;
+}
+
+bool MovieBooker::WriteSnapshot(const std::string& path, std::uint64_t logOffset) const
+{
+    const std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file)
         return false;
 
-    auto &entry = *it->second;
-    std::unique_lock<std::mutex> entryLock(entry.mutex);
-    mapLock.unlock();
+    bool ok;
+    {
+        EpochManager::ReadGuard guard;
+        const Catalog &catalog = *catalog_.load();
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+        header.byte_order = kSnapshotByteOrder;
+        header.log_offset = logOffset;
+        header.theater_count = static_cast<std::uint32_t>(catalog.theater_names.size());
+        header.movie_count = static_cast<std::uint32_t>(catalog.movie_names.size());
+        header.showing_count = static_cast<std::uint32_t>(catalog.showings.size());
+
+        std::vector<SnapshotTheater> theaters(catalog.theater_names.size());
+        std::vector<SnapshotMovie> movies(catalog.movie_names.size());
+        std::vector<SnapshotShowing> showings(catalog.showings.size());
+        for (std::size_t i = 0; i < theaters.size(); ++i)
+        {
+            theaters[i] = { header.string_bytes, static_cast<std::uint32_t>(catalog.theater_names[i].size()),
+                            static_cast<std::uint32_t>(catalog.theater_seats[i]) };
+            header.string_bytes += catalog.theater_names[i].size();
+        }
+        for (std::size_t i = 0; i < movies.size(); ++i)
+        {
+            movies[i] = { header.string_bytes, static_cast<std::uint32_t>(catalog.movie_names[i].size()), 0 };
+            header.string_bytes += catalog.movie_names[i].size();
+        }
+        for (std::size_t i = 0; i < showings.size(); ++i)
+        {
+            const TheaterEntry* entry = catalog.showings[i];
+            if (!entry)
+            {
+                showings[i] = { kSnapshotRemovedShowing, 0, header.word_count };
+                continue;
+            }
+            showings[i] = { entry->movie_id, static_cast<std::uint32_t>(entry->theater_id), header.word_count };
+            header.word_count += entry->seats.WordCount();
+        }
+
+        ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+            && std::fwrite(theaters.data(), sizeof(SnapshotTheater), theaters.size(), file) == theaters.size()
+            && std::fwrite(movies.data(), sizeof(SnapshotMovie), movies.size(), file) == movies.size()
+            && std::fwrite(showings.data(), sizeof(SnapshotShowing), showings.size(), file) == showings.size();
 
-    for (auto id : seatIds) 
+        // seats are copied while bookings go on, each showing between two of
+        // its changes (a seqlock read); held seats are written as free. A
+        // showing that never settles fails this snapshot rather than stall it
+        std::vector<std::uint64_t> words, held;
+        for (std::size_t i = 0; ok && i < catalog.showings.size(); ++i)
+        {
+            if (!catalog.showings[i])
+                continue;
+            const TheaterEntry &entry = *catalog.showings[i];
+            words.resize(entry.seats.WordCount());
+            held.resize(entry.held.WordCount());
+            bool copied = false;
+            for (unsigned int attempt = 0; !copied && attempt < kSnapshotCopyAttempts; ++attempt)
+            {
+                if (attempt >= 10)
+                    std::this_thread::sleep_for(std::chrono::microseconds(10 * (attempt - 9)));   // back off, up to 50 ms in all
+                else if (attempt > 0)
+                    std::this_thread::yield();
+                const std::uint64_t started = entry.changes.started.load(std::memory_order_acquire);
+                if (entry.changes.finished.load(std::memory_order_acquire) != started)
+                    continue;
+                entry.seats.StoreWords(words.data());
+                entry.held.StoreWords(held.data());
+                std::atomic_thread_fence(std::memory_order_acquire);
+                copied = entry.changes.started.load(std::memory_order_relaxed) == started;
+            }
+            ok = copied;
+            if (!ok)
+                break;
+            for (std::size_t w = 0; w < words.size(); ++w)
+                words[w] &= ~held[w];
+            ok = std::fwrite(words.data(), sizeof(std::uint64_t), words.size(), file) == words.size();
+        }
+        for (const auto &name : catalog.theater_names)
+            ok = ok && std::fwrite(name.data(), 1, name.size(), file) == name.size();
+        for (const auto &name : catalog.movie_names)
+            ok = ok && std::fwrite(name.data(), 1, name.size(), file) == name.size();
+    }
+
+#ifdef _MSC_VER
+    ok = ok && std::fflush(file) == 0 && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code ec;
+    if (ok)
+    {
+        std::filesystem::rename(temp, path, ec);        // replaces the previous snapshot atomically
+        ok = !ec;
+    }
+    if (!ok)
+        std::filesystem::remove(temp, ec);
+    return ok;
+}
+
+bool MovieBooker::RestoreSeats(const std::string& theater, const std::string& movie, const std::vector<unsigned int>& seatIds)
+{
+    TheaterEntry* entry;
     {
-        std::size_t idx = static_cast<std::size_t>(id - 1);
-        if (entry.seats[idx]) 
-            return false;                                       // already booked seat in list
+        EpochManager::ReadGuard guard;
+        entry = FindShowing(theater, movie);
     }
-    for (auto id : seatIds) 
-        entry.seats[static_cast<std::size_t>(id - 1)] = true;
+    if (!entry)
+        return false;
+
+    const ChangeGuard change(entry, track_changes_);
+    for (unsigned int seat : seatIds)
+        entry->seats.TryClaim(&seat, 1);                // already booked (e.g. by the snapshot) or out of range: skip
+    return true;
+}
+
+bool MovieBooker::LoadSnapshot(const std::string& path, std::uint64_t& logOffset)
+{
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(SnapshotHeader))
+        return false;
+
+    SnapshotHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 || header.byte_order != kSnapshotByteOrder)
+        return false;
+
+    // section offsets; the counts are bounded by the file size before any multiplication can overflow
+    const std::uint64_t size = file.Size();
+    const std::uint64_t theatersAt = sizeof(SnapshotHeader);
+    const std::uint64_t moviesAt = theatersAt + std::uint64_t(header.theater_count) * sizeof(SnapshotTheater);
+    const std::uint64_t showingsAt = moviesAt + std::uint64_t(header.movie_count) * sizeof(SnapshotMovie);
+    const std::uint64_t wordsAt = showingsAt + std::uint64_t(header.showing_count) * sizeof(SnapshotShowing);
+    if (wordsAt > size || header.word_count > (size - wordsAt) / sizeof(std::uint64_t))
+        return false;
+    const std::uint64_t stringsAt = wordsAt + header.word_count * sizeof(std::uint64_t);
+    if (header.string_bytes != size - stringsAt)
+        return false;
+
+    // the tables are read in place from the mapping (all 8-byte aligned)
+    const char* data = file.Data();
+    const auto* theaters = reinterpret_cast<const SnapshotTheater*>(data + theatersAt);
+    const auto* movies = reinterpret_cast<const SnapshotMovie*>(data + moviesAt);
+    const auto* showings = reinterpret_cast<const SnapshotShowing*>(data + showingsAt);
+    const auto* words = reinterpret_cast<const std::uint64_t*>(data + wordsAt);
+    const char* strings = data + stringsAt;
+    auto name = [&](std::uint64_t offset, std::uint32_t length, std::string& out) {
+        if (length == 0 || offset > header.string_bytes || length > header.string_bytes - offset)
+            return false;
+        out.assign(strings + offset, length);
+        return true;
+    };
+
+    auto next = std::make_unique<Catalog>();
+    next->theater_index.reserve(header.theater_count);
+    next->theater_seats.reserve(header.theater_count);
+    next->theater_names.resize(header.theater_count);
+    for (std::uint32_t i = 0; i < header.theater_count; ++i)
+    {
+        if (theaters[i].seats == 0 || !name(theaters[i].name_offset, theaters[i].name_length, next->theater_names[i])
+            || !next->theater_index.emplace(next->theater_names[i], i).second)
+            return false;
+        next->theater_seats.push_back(theaters[i].seats);
+    }
+
+    next->movie_index.reserve(header.movie_count);
+    next->movie_theaters.reserve(header.movie_count);
+    next->movie_names.resize(header.movie_count);
+    next->movie_showings.resize(header.movie_count);
+    for (std::uint32_t i = 0; i < header.movie_count; ++i)
+    {
+        if (!name(movies[i].name_offset, movies[i].name_length, next->movie_names[i])
+            || !next->movie_index.emplace(next->movie_names[i], i).second)
+            return false;
+    }
+
+    // size every per-movie map up front so the showing pass never rehashes
+    std::vector<std::uint32_t> perMovie(header.movie_count);
+    for (std::uint32_t i = 0; i < header.showing_count; ++i)
+    {
+        if (showings[i].movie == kSnapshotRemovedShowing)
+            continue;
+        if (showings[i].movie >= header.movie_count || showings[i].theater >= header.theater_count)
+            return false;
+        ++perMovie[showings[i].movie];
+    }
+    std::vector<std::unordered_map<std::string, ShowingId>*> byName(header.movie_count);
+    for (std::uint32_t i = 0; i < header.movie_count; ++i)
+    {
+        if (perMovie[i] == 0)
+            continue;                                   // removed by a reload; keeps its id only
+        byName[i] = &next->movie_theaters[next->movie_names[i]];
+        byName[i]->reserve(perMovie[i]);
+        next->movie_showings[i].reserve(perMovie[i]);
+    }
+
+    std::vector<TheaterEntry> block;
+    block.reserve(header.showing_count);
+    next->showings.reserve(header.showing_count);
+    for (std::uint32_t i = 0; i < header.showing_count; ++i)
+    {
+        const SnapshotShowing &showing = showings[i];
+        if (showing.movie == kSnapshotRemovedShowing)
+        {
+            next->showings.push_back(nullptr);
+            continue;
+        }
+        if (!next->movie_showings[showing.movie].emplace(showing.theater, i).second)
+            return false;
+        TheaterEntry &entry = block.emplace_back(showing.movie, showing.theater, next->theater_seats[showing.theater]);
+        if (showing.first_word > header.word_count || entry.seats.WordCount() > header.word_count - showing.first_word)
+            return false;
+        entry.seats.LoadWords(words + showing.first_word);
+        byName[showing.movie]->emplace(next->theater_names[showing.theater], i);
+        next->showings.push_back(&entry);
+    }
+
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    next->version = current_->version + 1;
+    if (!block.empty())
+        entries_.push_back(std::move(block));
+    Publish(std::move(next));
+    logOffset = header.log_offset;
     return true;
 }
@@ -6,15 +6,16 @@
 #include <string>
 #include <MovieBooker.hpp>
 #include <AsioServer.hpp>
-
-
-
-// RapidJSON headers
-#include <rapidjson/document.h>
-#include <rapidjson/istreamwrapper.h>
+#include <BookingLog.hpp>
+#include <MovieDataLoader.hpp>
 
 #include <filesystem>
+#include <csignal>
 #include <cstdlib>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 
 #ifdef _WIN32
     #include <direct.h>
@@ -25,85 +26,284 @@
     #define PATHSEP "/"
 #endif
 
-// Simple loader: expects a JSON file with structure:
-// {
-//   "movies": [
-//     { "title": "Movie1", "theaters": ["T1","T2"] },
-//     { "title": "Movie2", "theaters": ["T3"] }
-//   ]
-// }
-
-class MovieDataLoader 
+// Writes a snapshot of the booker every interval on a background thread
+// while bookings go on. The log is synced and its offset read before the
+// seats are copied, so replaying the log from it on top of the snapshot
+// loses nothing, and replay can seek straight to it. After each snapshot
+// the log is rotated to the offset of the previous one: a crash that loses
+// the newest snapshot's rename still finds every record the older one needs.
+class SnapshotWriter
 {
 public:
-    static bool LoadFromFile(const std::string& path, MovieBooker& booker) 
+    SnapshotWriter(const MovieBooker& booker, BookingLog& log, std::string path, std::chrono::seconds interval, std::uint64_t restoredOffset)
+        : booker_(booker), log_(log), path_(std::move(path)), interval_(interval), previous_(restoredOffset), thread_(&SnapshotWriter::Loop, this)
     {
-        std::ifstream ifs;
-
-		ifs.open(path);
+    }
 
-        if (!ifs.is_open()) 
+    ~SnapshotWriter()
+    {
         {
-            return false;
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
         }
+        cv_.notify_all();
+        thread_.join();
+    }
 
-        rapidjson::IStreamWrapper isw(ifs);
-        rapidjson::Document doc;
-        doc.ParseStream(isw);
-        if (doc.HasParseError() || 
-            !doc.IsObject()) 
+private:
+    void Loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, interval_, [this]() { return stop_; }))
         {
-            return false;
+            std::uint64_t offset = 0;
+            if (log_.IsOpen())
+            {
+                if (!log_.Sync())
+                {
+                    std::cerr << "Warning: booking log failed, snapshot '" << path_ << "' not written\n";
+                    continue;
+                }
+                offset = log_.SyncedBytes();
+            }
+            if (!booker_.WriteSnapshot(path_, offset))
+            {
+                std::cerr << "Warning: failed to write snapshot '" << path_ << "'\n";
+                continue;
+            }
+            if (log_.IsOpen() && previous_ != 0 && !log_.Rotate(previous_))
+                std::cerr << "Warning: failed to rotate the booking log\n";
+            previous_ = offset;
         }
+    }
 
-        if (!doc.HasMember("movies") || !doc["movies"].IsArray()) return false;
+    const MovieBooker& booker_;
+    BookingLog& log_;
+    const std::string path_;
+    const std::chrono::seconds interval_;
+    std::uint64_t previous_;                // log offset of the last snapshot written; 0 for none
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;                    // last: starts once the members above are set
+};
 
-        for (const auto& mv : doc["movies"].GetArray()) 
-        {
-            if (!mv.IsObject()) 
-                continue;
-            if (!mv.HasMember("title") || !mv["title"].IsString()) 
-                continue;
-            std::string title = mv["title"].GetString();
+// Re-reads the catalog on SIGHUP and swaps it in with MovieBooker::ReplaceCatalog.
+// Parsing and diffing run on this class's own thread: server threads and
+// bookings never wait for a reload. A catalog with a failing file is not
+// applied, since it would remove that file's showings.
+class CatalogReloader
+{
+public:
+    CatalogReloader(MovieBooker& booker, std::string source, unsigned int threads, int signal)
+        : booker_(booker), source_(std::move(source)), threads_(threads), signals_(io_context_, signal)
+    {
+        Wait();
+        thread_ = std::thread([this]() { io_context_.run(); });
+    }
 
-            std::vector<std::string> theaters;
-            if (mv.HasMember("theaters") && mv["theaters"].IsArray()) 
-            {
-                for (const auto& th : mv["theaters"].GetArray()) 
-                    if (th.IsString()) 
-                        theaters.emplace_back(th.GetString());
-            }
+    ~CatalogReloader()
+    {
+        io_context_.stop();
+        thread_.join();
+    }
 
-            if (!theaters.empty()) {
-                booker.AddMovie(title, theaters);
-            }
+private:
+    void Wait()
+    {
+        signals_.async_wait([this](const boost::system::error_code& ec, int) {
+            if (ec)
+                return;
+            Reload();
+            Wait();
+        });
+    }
+
+    void Reload()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        IMovieBooker::CatalogChunk chunk;
+        std::vector<CatalogLoadError> errors;
+        const std::vector<std::string> paths = MovieDataLoader::ExpandPaths(source_);
+        if (paths.empty() || !MovieDataLoader::ParseFiles(paths, threads_, chunk, errors))
+        {
+            for (const auto &error : errors)
+                std::cerr << "Warning: failed to reload '" << error.path << "' (line " << error.line << ", column "
+                          << error.column << "): " << error.message << "\n";
+            std::cerr << "Warning: catalog reload from '" << source_ << "' failed; keeping the current catalog.\n";
+            return;
         }
+        const auto parsed = std::chrono::steady_clock::now();
+        CatalogDiff diff;
+        booker_.ReplaceCatalog(chunk, &diff);
+        const auto swapped = std::chrono::steady_clock::now();
 
-        return true;
+        auto ms = [](auto duration) { return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count(); };
+        std::cout << "Reloaded catalog from " << source_ << " in " << ms(swapped - start) << " ms (parse " << ms(parsed - start)
+                  << " ms, swap " << ms(swapped - parsed) << " ms): " << diff.added_showings << " showing(s) added, "
+                  << diff.removed_showings << " removed, " << diff.kept_showings << " kept; " << diff.added_movies
+                  << " movie(s) added, " << diff.removed_movies << " removed\n";
     }
+
+    MovieBooker& booker_;
+    const std::string source_;
+    const unsigned int threads_;
+    boost::asio::io_context io_context_;
+    boost::asio::signal_set signals_;
+    std::thread thread_;
 };
 
+// usage: movie_booker [data.json|DIR|GLOB] [--threads N] [--max-connections N] [--hold-ttl SECONDS]
+//                     [--wal FILE] [--wal-mode none|group|fsync] [--wal-interval MS]
+//                     [--snapshot FILE] [--snapshot-interval SECONDS] [--load-threads N]
+//                     [--admin-port N]
 int main(int argc, char** argv)
 {
     // determine data file path; if none provided, use movies.json in current directory
 
 	std::string dataFile;
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::size_t maxConnections = 0;                     // no limit
+    std::chrono::milliseconds holdTtl = tcp_connection::kDefaultHoldTtl;
+    std::string walFile;                                // no write-ahead log
+    std::string walMode = "fsync";
+    std::chrono::milliseconds walInterval = BookingLog::kDefaultGroupInterval;
+    std::string snapshotFile;                           // no snapshots
+    std::chrono::seconds snapshotInterval(60);
+    unsigned int loadThreads = std::thread::hardware_concurrency();
+    unsigned short adminPort = 0;                       // no admin port
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i] ? argv[i] : "";
+        if (arg == "--threads" && i + 1 < argc)
+            threads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--max-connections" && i + 1 < argc)
+            maxConnections = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--hold-ttl" && i + 1 < argc)
+            holdTtl = std::chrono::seconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--wal" && i + 1 < argc)
+            walFile = argv[++i];
+        else if (arg == "--wal-mode" && i + 1 < argc)
+            walMode = argv[++i];
+        else if (arg == "--wal-interval" && i + 1 < argc)
+            walInterval = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--snapshot" && i + 1 < argc)
+            snapshotFile = argv[++i];
+        else if (arg == "--snapshot-interval" && i + 1 < argc)
+            snapshotInterval = std::chrono::seconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--admin-port" && i + 1 < argc)
+            adminPort = static_cast<unsigned short>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--load-threads" && i + 1 < argc)
+            loadThreads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (!arg.empty() && dataFile.empty())
+            dataFile = arg;
+    }
 
-    if (argc > 1 && argv[1] != nullptr && argv[1][0] != '\0')
-        dataFile = argv[1];
-    else
+    if (dataFile.empty())
         dataFile = "movies.json";
+    if (threads == 0)
+        threads = 1;
+    if (snapshotInterval.count() == 0)
+        snapshotInterval = std::chrono::seconds(1);
 
     MovieBooker booker;
 
-    if (!MovieDataLoader::LoadFromFile(dataFile, booker)) 
+    // a snapshot replaces the JSON catalog and the log up to the offset it was taken at
+    bool restored = false;
+    std::uint64_t replayFrom = 0;
+    if (!snapshotFile.empty() && std::filesystem::exists(snapshotFile))
+    {
+        const auto start = std::chrono::steady_clock::now();
+        restored = booker.LoadSnapshot(snapshotFile, replayFrom);
+        if (restored)
+            std::cout << "Restored catalog from snapshot " << snapshotFile << " in "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+        else
+            std::cerr << "Warning: ignoring invalid snapshot '" << snapshotFile << "'\n";
+    }
+
+    std::vector<CatalogLoadError> loadErrors;
+    if (!restored && !MovieDataLoader::LoadFiles(MovieDataLoader::ExpandPaths(dataFile), loadThreads, booker, loadErrors))
+    {
+        if (loadErrors.empty())
+            std::cerr << "Warning: no catalog files match '" << dataFile << "'.\n";
+        for (const auto &loadError : loadErrors)
+        {
+            std::cerr << "Warning: failed to load movie data from '" << loadError.path << "'";
+            if (loadError.line > 0)
+                std::cerr << " (line " << loadError.line << ", column " << loadError.column << ")";
+            std::cerr << ": " << loadError.message << "\n";
+        }
+        std::cerr << "Starting with " << (booker.GetMovies().empty() ? "empty" : "partial") << " catalog.\n";
+    }
+
+    // replay the bookings of previous runs on top of the catalog, then log new ones
+    BookingLog bookingLog;
+    if (!walFile.empty())
+    {
+        Durability durability = Durability::Fsync;
+        if (walMode == "none")
+            durability = Durability::None;
+        else if (walMode == "group")
+            durability = Durability::Group;
+        else if (walMode != "fsync")
+        {
+            std::cerr << "Unknown --wal-mode '" << walMode << "' (use none, group or fsync)\n";
+            return 1;
+        }
+
+        std::size_t replayed = 0, skipped = 0;
+        const LogReplayResult replay = BookingLog::Replay(walFile,
+            [&](std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats) {
+                if (booker.RestoreSeats(std::string(theater), std::string(movie), seats))
+                    ++replayed;
+                else
+                    ++skipped;                          // showing gone from the catalog
+            }, replayFrom);
+        if (replay.rotated_past)
+        {
+            std::cerr << "Error: booking log '" << walFile << "' starts at offset " << replay.start << " but replay must start at "
+                      << replayFrom << "; it needs the snapshot it was rotated for\n";
+            return 1;
+        }
+        if (replay.corrupt)
+        {
+            std::cerr << "Error: booking log '" << walFile << "' has a malformed record at byte " << replay.valid_bytes
+                      << " whose checksum matches; refusing to truncate it\n";
+            return 1;
+        }
+        if (!replay.ok || !bookingLog.Open(walFile, durability, walInterval, replay))
+        {
+            std::cerr << "Error: cannot use '" << walFile << "' as booking log\n";
+            return 1;
+        }
+        std::cout << "Replayed " << replay.records << " logged booking(s) from " << walFile << " (" << replayed << " showing(s) booked, "
+                  << skipped << " skipped" << (replay.torn_tail ? ", torn tail discarded" : "") << ")\n";
+        booker.SetBookingLog(&bookingLog);
+    }
+
+    std::unique_ptr<SnapshotWriter> snapshots;
+    if (!snapshotFile.empty())
     {
-        std::cerr << "Warning: failed to load movie data from '" << dataFile << "'. Starting with empty catalog.\n";
+        booker.EnableConcurrentSnapshots();             // before any session books
+        snapshots = std::make_unique<SnapshotWriter>(booker, bookingLog, snapshotFile, snapshotInterval, replayFrom);
     }
 
+#ifdef SIGHUP
+    // kill -HUP reloads the catalog source while the server runs
+    CatalogReloader reloader(booker, dataFile, loadThreads, SIGHUP);
+#endif
+
     try {
-        AsioServer server(booker);
-        std::cout << "Starting AsioServer on port 8080...\n";
+        AsioServer server(booker, 8080, threads, maxConnections);
+        server.SetHoldTtl(holdTtl);
+        if (adminPort)
+        {
+            server.EnableAdmin(adminPort);
+            std::cout << "Serving metrics on http://127.0.0.1:" << server.GetAdminPort() << "/metrics\n";
+        }
+        std::cout << "Starting AsioServer on port 8080 with " << threads << " thread(s)...\n";
         server.Run();
     }
     catch (const std::exception& e) {
@@ -0,0 +1,445 @@
+#include <MovieDataLoader.hpp>
+
+// RapidJSON headers
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/istreamwrapper.h>
+#include <rapidjson/reader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t kReadBuffer = 64 * 1024;
+    constexpr std::size_t kMinChunkShowings = 4096;
+
+    // SAX handler for the catalog layout, collecting theaters and movies into
+    // a chunk. With a booker the chunk is handed to AddCatalog once it holds
+    // as many showings as the booker already has: each chunk copies the
+    // catalog once, so the copies add up to O(showings) while the pending
+    // chunk never outgrows what is already loaded. Without one the caller
+    // gets the whole file in the chunk. Values the layout does not expect are
+    // skipped whole, nested or not.
+    class CatalogHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, CatalogHandler>
+    {
+    public:
+        CatalogHandler(MovieBooker* booker, IMovieBooker::CatalogChunk& chunk) : booker_(booker), chunk_(chunk) {}
+
+        bool SawMovies() const { return saw_movies_; }
+        const std::string& Error() const { return error_; }
+
+        // hand the collected theaters and movies to the booker, if there is one
+        void Flush()
+        {
+            if (!booker_)
+                return;
+            booker_->AddCatalog(chunk_);                // known theaters are refused; that is fine here
+            loaded_ += pending_;
+            pending_ = 0;
+            chunk_.theaters.clear();
+            chunk_.movies.clear();
+        }
+
+        bool StartObject()
+        {
+            if (skip_ > 0 || !Expecting(Kind::Object))
+                return Skip(true);
+            switch (state_)
+            {
+            case State::Start:      state_ = State::Root; break;
+            case State::TheaterList: state_ = State::Theater; name_.clear(); seats_ = 0; break;
+            case State::MovieList:  state_ = State::Movie; title_.clear(); theaters_.clear(); break;
+            default: break;
+            }
+            field_ = Field::None;
+            return true;
+        }
+
+        bool EndObject(rapidjson::SizeType)
+        {
+            if (skip_ > 0)
+            {
+                --skip_;
+                return true;
+            }
+            switch (state_)
+            {
+            case State::Root:
+                state_ = State::Done;
+                break;
+            case State::Theater:
+                if (!name_.empty() && seats_ > 0)
+                    chunk_.theaters.emplace_back(std::move(name_), seats_);
+                state_ = State::TheaterList;
+                break;
+            case State::Movie:
+                if (!title_.empty() && !theaters_.empty())
+                {
+                    pending_ += theaters_.size();
+                    chunk_.movies.emplace_back(std::move(title_), std::move(theaters_));
+                    if (booker_ && pending_ >= std::max(kMinChunkShowings, loaded_))
+                        Flush();
+                }
+                state_ = State::MovieList;
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        bool StartArray()
+        {
+            if (skip_ > 0 || !Expecting(Kind::Array))
+                return Skip(true);
+            switch (field_)
+            {
+            case Field::Theaters:   state_ = State::TheaterList; break;
+            case Field::Movies:     state_ = State::MovieList; saw_movies_ = true; break;
+            case Field::Showings:   state_ = State::ShowingList; break;
+            default: break;
+            }
+            return true;
+        }
+
+        bool EndArray(rapidjson::SizeType)
+        {
+            if (skip_ > 0)
+            {
+                --skip_;
+                return true;
+            }
+            state_ = state_ == State::ShowingList ? State::Movie : State::Root;
+            field_ = Field::None;
+            return true;
+        }
+
+        bool Key(const char* text, rapidjson::SizeType length, bool)
+        {
+            if (skip_ > 0)
+                return true;
+            const std::string_view key(text, length);
+            field_ = Field::None;
+            if (state_ == State::Root)
+                field_ = key == "theaters" ? Field::Theaters : key == "movies" ? Field::Movies : Field::None;
+            else if (state_ == State::Theater)
+                field_ = key == "name" ? Field::Name : key == "seats" ? Field::Seats : Field::None;
+            else if (state_ == State::Movie)
+                field_ = key == "title" ? Field::Title : key == "theaters" ? Field::Showings : Field::None;
+            return true;
+        }
+
+        bool String(const char* text, rapidjson::SizeType length, bool)
+        {
+            if (skip_ > 0 || !Expecting(Kind::String))
+                return Skip(false);
+            if (state_ == State::ShowingList)
+                theaters_.emplace_back(text, length);
+            else if (field_ == Field::Name)
+                name_.assign(text, length);
+            else if (field_ == Field::Title)
+                title_.assign(text, length);
+            return true;
+        }
+
+        bool Uint(unsigned value)
+        {
+            if (skip_ > 0 || !Expecting(Kind::Uint))
+                return Skip(false);
+            seats_ = value;
+            return true;
+        }
+
+        // every other scalar
+        bool Default()
+        {
+            return Skip(false);
+        }
+
+    private:
+        enum class State { Start, Root, TheaterList, Theater, MovieList, Movie, ShowingList, Done };
+        enum class Field { None, Theaters, Movies, Name, Seats, Title, Showings };
+        enum class Kind { Object, Array, String, Uint };
+
+        // whether a value of this kind is one the layout uses at the current position
+        bool Expecting(Kind value) const
+        {
+            switch (state_)
+            {
+            case State::Start:       return value == Kind::Object;
+            case State::Root:        return value == Kind::Array && field_ != Field::None;
+            case State::TheaterList:
+            case State::MovieList:   return value == Kind::Object;
+            case State::Theater:     return (value == Kind::String && field_ == Field::Name) || (value == Kind::Uint && field_ == Field::Seats);
+            case State::Movie:       return (value == Kind::String && field_ == Field::Title) || (value == Kind::Array && field_ == Field::Showings);
+            case State::ShowingList: return value == Kind::String;
+            case State::Done:        return false;
+            }
+            return false;
+        }
+
+        // ignore a value; containers are skipped up to their end. A root that is
+        // not an object, or "movies" that is not an array, fails the load.
+        bool Skip(bool container)
+        {
+            if (skip_ == 0 && (state_ == State::Start || (state_ == State::Root && field_ == Field::Movies)))
+            {
+                error_ = state_ == State::Start ? "the catalog is not a JSON object" : "\"movies\" is not an array";
+                return false;
+            }
+            if (container)
+                ++skip_;
+            field_ = Field::None;                       // the member's value is consumed
+            return true;
+        }
+
+        MovieBooker* booker_;
+        State state_ = State::Start;
+        Field field_ = Field::None;                     // member whose value comes next
+        std::size_t skip_ = 0;                          // depth inside an ignored value
+        bool saw_movies_ = false;
+        std::string error_;
+
+        std::string name_;                              // theater being read
+        unsigned seats_ = 0;
+        std::string title_;                             // movie being read
+        std::vector<std::string> theaters_;
+
+        IMovieBooker::CatalogChunk& chunk_;             // read but not yet added
+        std::size_t pending_ = 0;                       // showings in chunk_
+        std::size_t loaded_ = 0;                        // showings handed to the booker
+    };
+
+    // line and column of a byte offset; only called on failure, so rescanning is fine
+    void locate(std::FILE* file, CatalogLoadError& error)
+    {
+        std::rewind(file);
+        error.line = error.column = 1;
+        for (std::size_t i = 0; i < error.offset; ++i)
+        {
+            const int c = std::fgetc(file);
+            if (c == EOF)
+                break;
+            if (c == '\n')
+            {
+                ++error.line;
+                error.column = 1;
+            }
+            else
+                ++error.column;
+        }
+    }
+}
+
+bool MovieDataLoader::LoadFromFile(const std::string& path, MovieBooker& booker)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        return false;
+
+    rapidjson::IStreamWrapper isw(ifs);
+    rapidjson::Document doc;
+    doc.ParseStream(isw);
+    if (doc.HasParseError() || !doc.IsObject())
+        return false;
+
+    if (!doc.HasMember("movies") || !doc["movies"].IsArray()) return false;
+
+    // capacities first: a theater is sized when its first showing is created
+    IMovieBooker::CatalogChunk chunk;
+    if (doc.HasMember("theaters") && doc["theaters"].IsArray())
+    {
+        for (const auto& th : doc["theaters"].GetArray())
+        {
+            if (!th.IsObject() || !th.HasMember("name") || !th["name"].IsString())
+                continue;
+            if (!th.HasMember("seats") || !th["seats"].IsUint() || th["seats"].GetUint() == 0)
+                continue;
+            chunk.theaters.emplace_back(th["name"].GetString(), th["seats"].GetUint());
+        }
+    }
+
+    for (const auto& mv : doc["movies"].GetArray())
+    {
+        if (!mv.IsObject())
+            continue;
+        if (!mv.HasMember("title") || !mv["title"].IsString())
+            continue;
+        std::string title = mv["title"].GetString();
+
+        std::vector<std::string> theaters;
+        if (mv.HasMember("theaters") && mv["theaters"].IsArray())
+        {
+            for (const auto& th : mv["theaters"].GetArray())
+                if (th.IsString())
+                    theaters.emplace_back(th.GetString());
+        }
+
+        if (!theaters.empty()) {
+            chunk.movies.emplace_back(std::move(title), std::move(theaters));
+        }
+    }
+
+    booker.AddCatalog(chunk);                           // one catalog change for the whole file
+    return true;
+}
+
+namespace
+{
+    // stream `path` through `handler`; fills `error` on failure
+    bool parse(const std::string& path, CatalogHandler& handler, CatalogLoadError& error)
+    {
+        error = CatalogLoadError();
+        error.path = path;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            error.message = "cannot open '" + path + "'";
+            return false;
+        }
+
+        std::vector<char> buffer(kReadBuffer);
+        rapidjson::FileReadStream stream(file, buffer.data(), buffer.size());
+        rapidjson::Reader reader;
+        const rapidjson::ParseResult result = reader.Parse(stream, handler);
+
+        bool ok = true;
+        if (!result)
+        {
+            ok = false;
+            error.message = result.Code() == rapidjson::kParseErrorTermination && !handler.Error().empty()
+                ? handler.Error() : rapidjson::GetParseError_En(result.Code());
+            error.offset = result.Offset();
+        }
+        else if (!handler.SawMovies())
+        {
+            ok = false;
+            error.message = "no \"movies\" array";
+            error.offset = stream.Tell();
+        }
+        if (!ok)
+            locate(file, error);
+        std::fclose(file);
+        return ok;
+    }
+
+    // '*' and '?' wildcard match of a whole file name
+    bool matches(const char* pattern, const char* name)
+    {
+        if (*pattern == '\0')
+            return *name == '\0';
+        if (*pattern == '*')
+            return matches(pattern + 1, name) || (*name != '\0' && matches(pattern, name + 1));
+        return *name != '\0' && (*pattern == '?' || *pattern == *name) && matches(pattern + 1, name + 1);
+    }
+}
+
+bool MovieDataLoader::StreamFromFile(const std::string& path, MovieBooker& booker, CatalogLoadError* error)
+{
+    CatalogLoadError local;
+    IMovieBooker::CatalogChunk chunk;
+    CatalogHandler handler(&booker, chunk);
+    const bool ok = parse(path, handler, error ? *error : local);
+    handler.Flush();                                    // also keeps what was read before an error
+    return ok;
+}
+
+bool MovieDataLoader::ParseFile(const std::string& path, IMovieBooker::CatalogChunk& chunk, CatalogLoadError* error)
+{
+    CatalogLoadError local;
+    CatalogHandler handler(nullptr, chunk);
+    return parse(path, handler, error ? *error : local);
+}
+
+std::vector<std::string> MovieDataLoader::ExpandPaths(const std::string& spec)
+{
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+    std::error_code ec;
+
+    const fs::path path(spec);
+    const std::string name = path.filename().string();
+    if (name.find_first_of("*?") != std::string::npos)
+    {
+        const fs::path dir = path.has_parent_path() ? path.parent_path() : fs::path(".");
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+            if (it->is_regular_file(ec) && matches(name.c_str(), it->path().filename().string().c_str()))
+                paths.push_back(it->path().string());
+    }
+    else if (fs::is_directory(path, ec))
+    {
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+            if (it->is_regular_file(ec) && it->path().extension() == ".json")
+                paths.push_back(it->path().string());
+    }
+    else
+        paths.push_back(spec);
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool MovieDataLoader::ParseFiles(const std::vector<std::string>& paths, unsigned int threads,
+                                 IMovieBooker::CatalogChunk& merged, std::vector<CatalogLoadError>& errors)
+{
+    // each file parses into its own chunk; workers take the next file until none is left
+    std::vector<IMovieBooker::CatalogChunk> chunks(paths.size());
+    std::vector<CatalogLoadError> results(paths.size());
+    std::vector<char> parsed(paths.size(), 0);
+    std::atomic<std::size_t> next{ 0 };
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < paths.size(); i = next++)
+            parsed[i] = ParseFile(paths[i], chunks[i], &results[i]);
+    };
+    const std::size_t count = std::min<std::size_t>(std::max(threads, 1u), paths.size());
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < count; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+
+    // merge in path order, all capacities before all movies, whatever order the files finished in
+    bool ok = true;
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!parsed[i])
+        {
+            ok = false;
+            errors.push_back(std::move(results[i]));
+            continue;
+        }
+        std::move(chunks[i].theaters.begin(), chunks[i].theaters.end(), std::back_inserter(merged.theaters));
+    }
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        if (parsed[i])
+            std::move(chunks[i].movies.begin(), chunks[i].movies.end(), std::back_inserter(merged.movies));
+    return ok;
+}
+
+bool MovieDataLoader::LoadFiles(const std::vector<std::string>& paths, unsigned int threads, MovieBooker& booker,
+                                std::vector<CatalogLoadError>& errors)
+{
+    if (paths.size() == 1)
+    {
+        // a single file streams into the booker and never holds more than the chunk
+        CatalogLoadError error;
+        if (StreamFromFile(paths.front(), booker, &error))
+            return true;
+        errors.push_back(std::move(error));
+        return false;
+    }
+
+    IMovieBooker::CatalogChunk merged;
+    const bool ok = ParseFiles(paths, threads, merged, errors);
+    booker.AddCatalog(merged);
+    return ok && !paths.empty();
+}
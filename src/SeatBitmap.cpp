@@ -0,0 +1,306 @@
+#include <SeatBitmap.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace
+{
+    // ClaimBest callers that keep losing races take turns on one of these, picked by bitmap address
+    constexpr std::size_t kBestLocks = 64;
+    std::mutex best_locks[kBestLocks];
+
+    inline unsigned int popcount64(std::uint64_t w)
+    {
+#ifdef _MSC_VER
+        return static_cast<unsigned int>(__popcnt64(w));
+#else
+        return static_cast<unsigned int>(__builtin_popcountll(w));
+#endif
+    }
+
+    // index of the lowest set bit; w must not be 0
+    inline unsigned int ctz64(std::uint64_t w)
+    {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward64(&idx, w);
+        return static_cast<unsigned int>(idx);
+#else
+        return static_cast<unsigned int>(__builtin_ctzll(w));
+#endif
+    }
+}
+
+SeatBitmap::SeatBitmap(std::size_t seats)
+    : seats_(seats),
+      word_count_((seats + kBitsPerWord - 1) / kBitsPerWord),
+      words_(new std::atomic<std::uint64_t>[word_count_ ? word_count_ : 1])
+{
+    for (std::size_t i = 0; i < word_count_; ++i)
+        words_[i].store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t SeatBitmap::ValidMask(std::size_t index) const
+{
+    std::size_t bits = seats_ - index * kBitsPerWord;
+    return bits >= kBitsPerWord ? ~std::uint64_t(0) : ((std::uint64_t(1) << bits) - 1);
+}
+
+bool SeatBitmap::ClaimWord(std::size_t index, std::uint64_t mask)
+{
+    auto &word = words_[index];
+    std::uint64_t current = word.load(std::memory_order_acquire);
+    do
+    {
+        if (current & mask)
+            return false;                                       // at least one seat already booked
+    } while (!word.compare_exchange_weak(current, current | mask, std::memory_order_acq_rel, std::memory_order_acquire));
+    return true;
+}
+
+bool SeatBitmap::TryClaim(const unsigned int* seatIds, std::size_t count)
+{
+    if (count == 0)
+        return false;
+
+    // fast path: every seat lives in the same word -> one CAS, no allocation
+    const std::size_t first = (seatIds[0] - 1) / kBitsPerWord;
+    std::uint64_t mask = 0;
+    bool singleWord = true;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        unsigned int id = seatIds[i];
+        if (id == 0 || id > seats_)                             // seat number out of range
+            return false;
+        if ((id - 1) / kBitsPerWord != first)
+        {
+            singleWord = false;
+            continue;
+        }
+        mask |= std::uint64_t(1) << ((id - 1) % kBitsPerWord);
+    }
+    if (singleWord)
+        return popcount64(mask) == count && ClaimWord(first, mask);   // popcount catches repeated ids
+
+    // fallback: group seats per word and claim the words in ascending order
+    std::vector<std::pair<std::size_t, std::uint64_t>> masks;
+    masks.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        masks.emplace_back((seatIds[i] - 1) / kBitsPerWord, std::uint64_t(1) << ((seatIds[i] - 1) % kBitsPerWord));
+    std::sort(masks.begin(), masks.end());
+
+    std::size_t groups = 0;
+    for (std::size_t i = 0; i < masks.size(); ++i)
+    {
+        if (groups && masks[groups - 1].first == masks[i].first)
+        {
+            if (masks[groups - 1].second & masks[i].second)
+                return false;                                   // seats are not unique
+            masks[groups - 1].second |= masks[i].second;
+        }
+        else
+            masks[groups++] = masks[i];
+    }
+
+    for (std::size_t g = 0; g < groups; ++g)
+    {
+        if (!ClaimWord(masks[g].first, masks[g].second))
+        {
+            // undo the words claimed so far; nobody else can clear bits we own
+            for (std::size_t u = 0; u < g; ++u)
+                words_[masks[u].first].fetch_and(~masks[u].second, std::memory_order_acq_rel);
+            return false;
+        }
+    }
+    return true;
+}
+
+void SeatBitmap::Release(const unsigned int* seatIds, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        unsigned int id = seatIds[i];
+        if (id == 0 || id > seats_)
+            continue;
+        words_[(id - 1) / kBitsPerWord].fetch_and(~(std::uint64_t(1) << ((id - 1) % kBitsPerWord)), std::memory_order_acq_rel);
+    }
+}
+
+bool SeatBitmap::IsBooked(unsigned int seatId) const
+{
+    if (seatId == 0 || seatId > seats_)
+        return false;
+    std::uint64_t word = words_[(seatId - 1) / kBitsPerWord].load(std::memory_order_acquire);
+    return (word >> ((seatId - 1) % kBitsPerWord)) & 1u;
+}
+
+std::size_t SeatBitmap::LoadFree(std::uint64_t* free) const
+{
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < word_count_; ++i)
+    {
+        free[i] = ~words_[i].load(std::memory_order_acquire) & ValidMask(i);
+        total += popcount64(free[i]);
+    }
+    return total;
+}
+
+void SeatBitmap::CollectFree(std::vector<unsigned int>& out) const
+{
+    // snapshot the free masks first so the output can be sized exactly once
+    constexpr std::size_t kStackWords = 32;                     // 2048 seats without touching the heap
+    std::uint64_t stackWords[kStackWords];
+    std::vector<std::uint64_t> heapWords;
+    std::uint64_t* free = stackWords;
+    if (word_count_ > kStackWords)
+    {
+        heapWords.resize(word_count_);
+        free = heapWords.data();
+    }
+
+    const std::size_t total = LoadFree(free);
+
+    const std::size_t start = out.size();
+    out.resize(start + total);
+    unsigned int* dst = out.data() + start;
+
+    for (std::size_t i = 0; i < word_count_; ++i)
+    {
+        std::uint64_t w = free[i];
+        const unsigned int base = static_cast<unsigned int>(i * kBitsPerWord) + 1;
+        if (w == ~std::uint64_t(0))
+        {
+            // whole word free (the common case in a large hall): straight-line fill the compiler vectorizes
+            for (unsigned int b = 0; b < kBitsPerWord; ++b)
+                dst[b] = base + b;
+            dst += kBitsPerWord;
+            continue;
+        }
+        while (w)
+        {
+            *dst++ = base + ctz64(w);
+            w &= w - 1;                                         // clear lowest set bit
+        }
+    }
+}
+
+std::size_t SeatBitmap::CountFree() const
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < word_count_; ++i)
+        count += popcount64(~words_[i].load(std::memory_order_acquire) & ValidMask(i));
+    return count;
+}
+
+void SeatBitmap::StoreWords(std::uint64_t* out) const
+{
+    for (std::size_t i = 0; i < word_count_; ++i)
+        out[i] = words_[i].load(std::memory_order_acquire);
+}
+
+void SeatBitmap::LoadWords(const std::uint64_t* words)
+{
+    for (std::size_t i = 0; i < word_count_; ++i)
+        words_[i].store(words[i] & ValidMask(i), std::memory_order_relaxed);
+}
+
+bool SeatBitmap::ClaimBest(std::size_t count, bool contiguous, std::vector<unsigned int>& seats)
+{
+    seats.clear();
+    if (count == 0 || count > seats_)
+        return false;
+
+    constexpr std::size_t kStackWords = 32;
+    std::uint64_t stackWords[kStackWords];
+    std::vector<std::uint64_t> heapWords;
+    std::uint64_t* free = stackWords;
+    if (word_count_ > kStackWords)
+    {
+        heapWords.resize(word_count_);
+        free = heapWords.data();
+    }
+    seats.reserve(count);
+
+    BestResult result = BestResult::Lost;
+    for (unsigned int attempt = 0; attempt < kMaxBestAttempts && result == BestResult::Lost; ++attempt)
+        result = ClaimBestOnce(count, contiguous, free, seats);
+    if (result != BestResult::Lost)
+        return result == BestResult::Claimed;
+
+    // heavy contention: take turns with the other ClaimBest callers of this
+    // bitmap and retry until the seats are claimed or really missing; a race
+    // is now only lost to a TryClaim() that booked (or tried) a seat meanwhile
+    std::lock_guard<std::mutex> lock(best_locks[reinterpret_cast<std::uintptr_t>(this) / alignof(SeatBitmap) % kBestLocks]);
+    do
+        result = ClaimBestOnce(count, contiguous, free, seats);
+    while (result == BestResult::Lost);
+    return result == BestResult::Claimed;
+}
+
+SeatBitmap::BestResult SeatBitmap::ClaimBestOnce(std::size_t count, bool contiguous, std::uint64_t* free, std::vector<unsigned int>& seats)
+{
+    if (LoadFree(free) < count)
+        return BestResult::Unavailable;
+
+    // walk the free runs word by word: ctz of the inverted bits gives the
+    // length of a free run, ctz of the bits gives the gap to the next one
+    std::size_t runStart = 0, runLength = 0;
+    bool found = false;
+    for (std::size_t i = 0; i < word_count_ && !found; ++i)
+    {
+        const std::uint64_t w = free[i];
+        unsigned int bit = 0;
+        while (bit < kBitsPerWord)
+        {
+            const std::uint64_t rest = w >> bit;
+            if (rest & 1)
+            {
+                const std::uint64_t booked = ~rest;             // 0 only if bit == 0 and the word is all free
+                const unsigned int length = booked ? ctz64(booked) : static_cast<unsigned int>(kBitsPerWord);
+                if (runLength == 0)
+                    runStart = i * kBitsPerWord + bit;
+                runLength += length;
+                if (runLength >= count)
+                {
+                    found = true;
+                    break;
+                }
+                bit += length;
+                if (bit < kBitsPerWord)
+                    runLength = 0;                              // the run ends inside this word
+            }
+            else
+            {
+                runLength = 0;
+                if (rest == 0)
+                    break;
+                bit += ctz64(rest);
+            }
+        }
+    }
+
+    if (found)
+    {
+        for (std::size_t k = 0; k < count; ++k)
+            seats.push_back(static_cast<unsigned int>(runStart + k + 1));
+    }
+    else if (contiguous)
+        return BestResult::Unavailable;
+    else
+    {
+        // no block large enough: the lowest free seats
+        for (std::size_t i = 0; i < word_count_ && seats.size() < count; ++i)
+            for (std::uint64_t w = free[i]; w && seats.size() < count; w &= w - 1)
+                seats.push_back(static_cast<unsigned int>(i * kBitsPerWord + ctz64(w) + 1));
+    }
+
+    if (TryClaim(seats.data(), seats.size()))
+        return BestResult::Claimed;
+    seats.clear();                                              // another claimer won a seat; look again
+    return BestResult::Lost;
+}
@@ -0,0 +1,239 @@
+#include <ServerMetrics.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    std::atomic<std::uint64_t> next_id{ 1 };
+
+    constexpr const char* kCommandNames[MetricsSnapshot::kCommands] = {
+        "unknown", "list_movies", "select_movie", "list_theaters", "select_theater", "get_free_seats",
+        "book_seats", "book_batch", "book_best", "binary", "hold_seats", "confirm_hold", "release_hold", "stats",
+    };
+
+    // upper bound in ns of histogram bucket b
+    std::uint64_t bucket_limit(std::size_t b)
+    {
+        return std::uint64_t(1) << b;
+    }
+
+    void append_number(std::string& out, std::uint64_t value)
+    {
+        out.append(std::to_string(value));
+    }
+
+    // ns as seconds, e.g. for Prometheus "le" labels
+    void append_seconds(std::string& out, std::uint64_t ns)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", static_cast<double>(ns) / 1e9);
+        out.append(text);
+    }
+
+    void append_micros(std::string& out, std::uint64_t ns)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", static_cast<double>(ns) / 1e3);
+        out.append(text);
+    }
+}
+
+thread_local std::vector<ServerMetrics::LocalEntry> ServerMetrics::local_;
+
+std::uint64_t MetricsSnapshot::Quantile(Command command, double q) const
+{
+    const CommandStats &stats = commands[static_cast<std::size_t>(command)];
+    if (stats.samples == 0)
+        return 0;
+    // rank of the quantile among the samples, 1-based
+    const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * static_cast<double>(stats.samples) + 0.5));
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < kBuckets; ++b)
+    {
+        seen += stats.buckets[b];
+        if (seen >= rank)
+            return bucket_limit(b);
+    }
+    return bucket_limit(kBuckets - 1);
+}
+
+ServerMetrics::ServerMetrics(std::uint32_t latencySample) : id_(next_id++), sample_mask_([latencySample]() {
+        std::uint64_t every = 1;
+        while (every < latencySample)
+            every <<= 1;
+        return every - 1;
+    }())
+{
+}
+
+ServerMetrics::~ServerMetrics() = default;
+
+ServerMetrics::Shard& ServerMetrics::FindShard()
+{
+    auto it = std::find_if(local_.begin(), local_.end(), [this](const LocalEntry& entry) { return entry.id == id_; });
+    if (it == local_.end())
+    {
+        // first use on this thread: register once, the shard lives as long as the instance
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::make_unique<Shard>());
+        local_.push_back({ id_, shards_.back().get() });
+        it = local_.end() - 1;
+    }
+    std::rotate(local_.begin(), it, it + 1);
+    return *local_.front().shard;
+}
+
+std::size_t ServerMetrics::ThreadCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shards_.size();
+}
+
+void ServerMetrics::RecordLatency(Command command, std::chrono::nanoseconds latency)
+{
+    Shard &shard = LocalShard();
+    const std::size_t c = Index(command);
+    const std::uint64_t ns = latency.count() > 0 ? static_cast<std::uint64_t>(latency.count()) : 0;
+
+    // first bucket whose limit is above the latency
+    std::size_t b = 0;
+    while (b + 1 < MetricsSnapshot::kBuckets && ns >= bucket_limit(b))
+        ++b;
+    Bump(shard.buckets[c][b], 1);
+    Bump(shard.samples[c], 1);
+    Bump(shard.latency_ns[c], ns);
+}
+
+MetricsSnapshot ServerMetrics::Snapshot() const
+{
+    MetricsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &shard : shards_)
+    {
+        for (std::size_t c = 0; c < MetricsSnapshot::kCommands; ++c)
+        {
+            auto &stats = snapshot.commands[c];
+            stats.count += shard->count[c].load(std::memory_order_relaxed);
+            stats.samples += shard->samples[c].load(std::memory_order_relaxed);
+            stats.latency_ns += shard->latency_ns[c].load(std::memory_order_relaxed);
+            for (std::size_t b = 0; b < MetricsSnapshot::kBuckets; ++b)
+                stats.buckets[b] += shard->buckets[c][b].load(std::memory_order_relaxed);
+        }
+        snapshot.booked += shard->booked.load(std::memory_order_relaxed);
+        snapshot.conflicts += shard->conflicts.load(std::memory_order_relaxed);
+        snapshot.bytes_in += shard->bytes_in.load(std::memory_order_relaxed);
+        snapshot.bytes_out += shard->bytes_out.load(std::memory_order_relaxed);
+        snapshot.accepted += shard->accepted.load(std::memory_order_relaxed);
+        snapshot.rejected += shard->rejected.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+std::string_view ServerMetrics::CommandName(Command command)
+{
+    return kCommandNames[Index(command)];
+}
+
+std::string ServerMetrics::FormatText(const MetricsSnapshot& snapshot)
+{
+    // e.g. "book_seats count=120 p50_us=1.024 p99_us=4.096 p999_us=8.192"
+    std::string out;
+    for (std::size_t c = 0; c < MetricsSnapshot::kCommands; ++c)
+    {
+        const Command command = static_cast<Command>(c);
+        if (snapshot.commands[c].count == 0)
+            continue;
+        out.append(CommandName(command)).append(" count=");
+        append_number(out, snapshot.commands[c].count);
+        out.append(" p50_us=");
+        append_micros(out, snapshot.Quantile(command, 0.5));
+        out.append(" p99_us=");
+        append_micros(out, snapshot.Quantile(command, 0.99));
+        out.append(" p999_us=");
+        append_micros(out, snapshot.Quantile(command, 0.999));
+        out.push_back('\n');
+    }
+    out.append("bookings booked=");
+    append_number(out, snapshot.booked);
+    out.append(" conflicts=");
+    append_number(out, snapshot.conflicts);
+    out.append("\nbytes in=");
+    append_number(out, snapshot.bytes_in);
+    out.append(" out=");
+    append_number(out, snapshot.bytes_out);
+    out.append("\nconnections live=");
+    append_number(out, snapshot.live_connections);
+    out.append(" peak=");
+    append_number(out, snapshot.peak_connections);
+    out.append(" accepted=");
+    append_number(out, snapshot.accepted);
+    out.append(" rejected=");
+    append_number(out, snapshot.rejected);
+    out.append("\n\n");
+    return out;
+}
+
+std::string ServerMetrics::FormatPrometheus(const MetricsSnapshot& snapshot)
+{
+    std::string out;
+    auto family = [&out](const char* name, const char* type, const char* help) {
+        out.append("# HELP ").append(name).append(" ").append(help).append("\n# TYPE ").append(name).append(" ").append(type).push_back('\n');
+    };
+    auto sample = [&out](const char* name, const char* labels, std::uint64_t value) {
+        out.append(name);
+        if (*labels)
+            out.append("{").append(labels).append("}");
+        out.push_back(' ');
+        append_number(out, value);
+        out.push_back('\n');
+    };
+
+    family("movie_booker_requests_total", "counter", "Commands served, text and binary.");
+    for (std::size_t c = 0; c < MetricsSnapshot::kCommands; ++c)
+        if (snapshot.commands[c].count)
+            sample("movie_booker_requests_total", ("command=\"" + std::string(CommandName(static_cast<Command>(c))) + "\"").c_str(),
+                   snapshot.commands[c].count);
+
+    family("movie_booker_request_duration_seconds", "histogram", "Latency of sampled commands.");
+    for (std::size_t c = 0; c < MetricsSnapshot::kCommands; ++c)
+    {
+        const auto &stats = snapshot.commands[c];
+        if (stats.samples == 0)
+            continue;
+        const std::string label = "command=\"" + std::string(CommandName(static_cast<Command>(c))) + "\"";
+        std::uint64_t cumulative = 0;
+        for (std::size_t b = 0; b + 1 < MetricsSnapshot::kBuckets; ++b)
+        {
+            cumulative += stats.buckets[b];
+            out.append("movie_booker_request_duration_seconds_bucket{").append(label).append(",le=\"");
+            append_seconds(out, bucket_limit(b));
+            out.append("\"} ");
+            append_number(out, cumulative);
+            out.push_back('\n');
+        }
+        out.append("movie_booker_request_duration_seconds_bucket{").append(label).append(",le=\"+Inf\"} ");
+        append_number(out, stats.samples);
+        out.append("\nmovie_booker_request_duration_seconds_sum{").append(label).append("} ");
+        append_seconds(out, stats.latency_ns);
+        out.append("\nmovie_booker_request_duration_seconds_count{").append(label).append("} ");
+        append_number(out, stats.samples);
+        out.push_back('\n');
+    }
+
+    family("movie_booker_bookings_total", "counter", "Booking commands by outcome.");
+    sample("movie_booker_bookings_total", "result=\"booked\"", snapshot.booked);
+    sample("movie_booker_bookings_total", "result=\"conflict\"", snapshot.conflicts);
+    family("movie_booker_received_bytes_total", "counter", "Bytes read from clients.");
+    sample("movie_booker_received_bytes_total", "", snapshot.bytes_in);
+    family("movie_booker_sent_bytes_total", "counter", "Bytes written to clients.");
+    sample("movie_booker_sent_bytes_total", "", snapshot.bytes_out);
+    family("movie_booker_sessions_total", "counter", "Client sessions by admission.");
+    sample("movie_booker_sessions_total", "result=\"accepted\"", snapshot.accepted);
+    sample("movie_booker_sessions_total", "result=\"rejected\"", snapshot.rejected);
+    family("movie_booker_connections", "gauge", "Client sessions currently open.");
+    sample("movie_booker_connections", "", snapshot.live_connections);
+    family("movie_booker_connections_peak", "gauge", "Most client sessions open at once.");
+    sample("movie_booker_connections_peak", "", snapshot.peak_connections);
+    return out;
+}
@@ -0,0 +1,57 @@
+#include <TimerWheel.hpp>
+
+TimerWheel::TimerWheel(std::uint64_t start) : now_(start)
+{
+}
+
+void TimerWheel::Schedule(std::uint64_t id, std::uint64_t deadline)
+{
+    if (deadline <= now_)
+        deadline = now_ + 1;                            // the current tick has already been processed
+    else if (deadline - now_ >= kHorizon)
+        deadline = now_ + kHorizon - 1;
+    Insert({ id, deadline });
+    ++size_;
+}
+
+void TimerWheel::Insert(const Entry& entry)
+{
+    // the lowest level whose span covers the distance; the slot comes from the
+    // deadline's own bits so the entry is reached exactly when its slot turns
+    const std::uint64_t delta = entry.deadline - now_;
+    unsigned int level = 0;
+    while (level + 1 < kLevels && delta >= (std::uint64_t(1) << (kSlotBits * (level + 1))))
+        ++level;
+    const std::size_t slot = (entry.deadline >> (kSlotBits * level)) & (kSlots - 1);
+    slots_[level][slot].push_back(entry);
+}
+
+void TimerWheel::Advance(std::uint64_t now, std::vector<std::uint64_t>& expired)
+{
+    while (now_ < now)
+    {
+        ++now_;
+
+        // cascade higher levels whose slot boundary is reached, top down, so
+        // entries can fall through several levels in one tick
+        unsigned int top = 0;
+        while (top + 1 < kLevels && (now_ & ((std::uint64_t(1) << (kSlotBits * (top + 1))) - 1)) == 0)
+            ++top;
+        for (unsigned int level = top; level > 0; --level)
+        {
+            auto &slot = slots_[level][(now_ >> (kSlotBits * level)) & (kSlots - 1)];
+            if (slot.empty())
+                continue;
+            cascade_.swap(slot);                        // slot keeps the scratch's capacity
+            for (const auto &entry : cascade_)
+                Insert(entry);
+            cascade_.clear();
+        }
+
+        auto &due = slots_[0][now_ & (kSlots - 1)];
+        for (const auto &entry : due)
+            expired.push_back(entry.id);
+        size_ -= due.size();
+        due.clear();                                    // keeps capacity for the next round
+    }
+}
@@ -1,46 +1,285 @@
 // movie_booker_client.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
+// Interactive by default: one command typed, one reply printed. With --batch
+// it runs a command file (or stdin) pipelined over one AsyncClient session and
+// writes every reply with its latency, e.g. to warm caches, pre-book blocks or
+// smoke test a server.
 
 #include <iostream>
 #include <AsioClient.hpp>
+#include <AsyncClient.hpp>
+#include <CommandParser.hpp>
 
-int main()
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace
 {
-    AsioClient client;
-    if (!client.Connect("127.0.0.1", "8080")) {
-        std::cerr << "Failed to connect to server 127.0.0.1:8080\n";
-        return 1;
-    }
+    using Clock = std::chrono::steady_clock;
 
-    // Read initial server greeting (if any)
-    std::string serverLine = client.ReadLine();
-    if (!serverLine.empty())
-        std::cout << serverLine << std::endl;
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        std::string batch;                  // command file, "-" for stdin; empty: interactive
+        std::string out;                    // results file; empty: stdout
+        std::size_t window = 64;            // commands in flight at most
+    };
 
-    std::cout << "Type commands (type 'quit' or 'exit' to close):" << std::endl;
-    while (true) 
+    int interactive(const Options& options)
     {
-        std::cout << "> ";
-        std::string input;
-        if (!std::getline(std::cin, input))
-            break; // EOF or error on stdin
+        AsioClient client;
+        if (!client.Connect(options.host, options.port)) {
+            std::cerr << "Failed to connect to server " << options.host << ":" << options.port << "\n";
+            return 1;
+        }
 
-        if (input == "quit" || input == "exit")
-            break;
+        // Read initial server greeting (if any): a line and an empty line
+        for (std::string serverLine = client.ReadLine(); !serverLine.empty(); serverLine = client.ReadLine())
+            std::cout << serverLine << std::endl;
 
-        if (input.empty())
-            continue;
+        std::cout << "Type commands (type 'quit' or 'exit' to close):" << std::endl;
+        while (true)
+        {
+            std::cout << "> ";
+            std::string input;
+            if (!std::getline(std::cin, input))
+                break; // EOF or error on stdin
 
-        client.WriteLine(input);
+            if (input == "quit" || input == "exit")
+                break;
 
-        // Read single-line response from server
-        std::string resp = client.ReadLine();
-        if (resp.empty())
-            std::cout << "(no response)" << std::endl;
-        else
+            if (input.empty())
+                continue;
+
+            // recognize commands the way the server does, whatever their case and spacing
+            const Command command = CommandParser::Parse(input).command;
+            if (command == Command::Binary)
+            {
+                std::cout << "binary mode is not supported by this client" << std::endl;
+                continue;
+            }
+
+            client.WriteLine(input);
+
+            // Read the response: one line, or for stats lines up to an empty one
+            std::string resp = client.ReadLine();
+            if (resp.empty())
+            {
+                std::cout << "(no response)" << std::endl;
+                continue;
+            }
             std::cout << resp << std::endl;
+            if (command == Command::Stats && resp.compare(0, 6, "Error!") != 0)
+                for (std::string more = client.ReadLine(); !more.empty(); more = client.ReadLine())
+                    std::cout << more << std::endl;
+        }
+
+        return 0;
     }
 
-    return 0;
+    // Runs the commands of `in` on one session, at most options.window in flight.
+    // Each reply is written as soon as it arrives, in command order:
+    //   <line number> TAB <latency us> TAB <command> TAB <reply>
+    // where the latency runs from queueing the command to its reply, and the
+    // lines of a multi-line reply are joined with " | ".
+    class Batch
+    {
+    public:
+        Batch(boost::asio::io_context& io, std::istream& in, std::ostream& out, std::size_t window)
+            : session_(AsyncClient::Create(io)), in_(in), out_(out), window_(std::max<std::size_t>(1, window))
+        {
+        }
+
+        void Start(const boost::asio::ip::tcp::resolver::results_type& endpoints)
+        {
+            begin_ = Clock::now();
+            session_->AsyncConnect(endpoints, [this](const boost::system::error_code& error) {
+                if (error)
+                {
+                    std::cerr << "Failed to connect: " << error.message() << "\n";
+                    failed_ = true;
+                    return;
+                }
+                fill();
+            });
+        }
+
+        // exit status: 0 when every command got a reply that is not an error
+        int Report() const
+        {
+            const double seconds = std::chrono::duration<double>(end_ - begin_).count();
+            std::vector<std::uint32_t> sorted = latency_us_;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&sorted](double q) {
+                return sorted.empty() ? 0u : sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * static_cast<double>(sorted.size())))];
+            };
+            std::cerr << sorted.size() << " commands in " << std::fixed << std::setprecision(3) << seconds << " s, "
+                      << errors_ << " error replies; latency us p50=" << percentile(0.50) << " p99=" << percentile(0.99)
+                      << " max=" << (sorted.empty() ? 0u : sorted.back()) << "\n";
+            if (failed_)
+                std::cerr << "The session failed before all commands were answered\n";
+            return failed_ || errors_ ? 1 : 0;
+        }
+
+    private:
+        struct Sent
+        {
+            std::size_t line;
+            std::string command;
+            Clock::time_point at;
+        };
+
+        // queue commands until the window is full or the input ends
+        void fill()
+        {
+            std::string command;
+            while (!done_ && sent_.size() < window_)
+            {
+                if (!std::getline(in_, command) || command == "quit" || command == "exit")
+                {
+                    done_ = true;
+                    break;
+                }
+                ++line_;
+                if (!command.empty() && command.back() == '\r')
+                    command.pop_back();
+                if (command.empty() || command[0] == '#')
+                    continue;
+                if (CommandParser::Parse(command).command == Command::Binary)
+                {
+                    std::cerr << "line " << line_ << ": binary mode is not supported in batch mode, skipped\n";
+                    continue;
+                }
+                sent_.push_back({ line_, command, Clock::now() });
+                session_->AsyncCommand(command, [this](const boost::system::error_code& error, std::string_view reply) {
+                    on_reply(error, reply);
+                });
+            }
+            if (done_ && sent_.empty())
+            {
+                end_ = Clock::now();
+                session_->Close();
+            }
+        }
+
+        void on_reply(const boost::system::error_code& error, std::string_view reply)
+        {
+            if (error)
+            {
+                if (!failed_)
+                    std::cerr << "Session failed: " << error.message() << "\n";
+                failed_ = true;
+                end_ = Clock::now();
+                done_ = true;
+                sent_.clear();
+                return;
+            }
+            const Clock::time_point now = Clock::now();
+            const Sent &sent = sent_.front();
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - sent.at).count();
+            latency_us_.push_back(static_cast<std::uint32_t>(us));
+            if (reply.compare(0, 6, "Error!") == 0)
+                ++errors_;
+
+            out_ << sent.line << '\t' << us << '\t' << sent.command << '\t';
+            for (std::size_t start = 0; start <= reply.size();)
+            {
+                const std::size_t eol = std::min(reply.find('\n', start), reply.size());
+                if (start)
+                    out_ << " | ";
+                out_ << reply.substr(start, eol - start);
+                start = eol + 1;
+            }
+            out_ << '\n';
+            sent_.pop_front();
+            fill();
+        }
+
+        AsyncClient::pointer session_;
+        std::istream& in_;
+        std::ostream& out_;
+        const std::size_t window_;
+        std::deque<Sent> sent_;             // commands awaiting their reply, oldest first
+        std::size_t line_ = 0;
+        bool done_ = false;                 // no more commands to send
+        bool failed_ = false;
+        std::size_t errors_ = 0;
+        std::vector<std::uint32_t> latency_us_;
+        Clock::time_point begin_, end_;
+    };
+
+    int batch(const Options& options)
+    {
+        std::ifstream file;
+        if (options.batch != "-")
+        {
+            file.open(options.batch);
+            if (!file)
+            {
+                std::cerr << "Cannot open " << options.batch << "\n";
+                return 1;
+            }
+        }
+        std::ofstream results;
+        if (!options.out.empty())
+        {
+            results.open(options.out);
+            if (!results)
+            {
+                std::cerr << "Cannot write " << options.out << "\n";
+                return 1;
+            }
+        }
+
+        boost::asio::io_context io;
+        boost::asio::ip::tcp::resolver::results_type endpoints;
+        try {
+            endpoints = boost::asio::ip::tcp::resolver(io).resolve(options.host, options.port);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Cannot resolve " << options.host << ":" << options.port << ": " << e.what() << "\n";
+            return 1;
+        }
+
+        Batch run(io, options.batch == "-" ? std::cin : file, options.out.empty() ? std::cout : results, options.window);
+        run.Start(endpoints);
+        io.run();
+        return run.Report();
+    }
 }
 
+// usage: movie_booker_client [--host H] [--port P] [--batch FILE|-] [--out FILE] [--window N]
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool value = i + 1 < argc;
+        if (arg == "--host" && value)
+            options.host = argv[++i];
+        else if (arg == "--port" && value)
+            options.port = argv[++i];
+        else if (arg == "--batch" && value)
+            options.batch = argv[++i];
+        else if (arg == "--out" && value)
+            options.out = argv[++i];
+        else if (arg == "--window" && value)
+            options.window = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else
+        {
+            std::cerr << "Unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+
+    return options.batch.empty() ? interactive(options) : batch(options);
+}
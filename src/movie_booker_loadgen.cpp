@@ -0,0 +1,444 @@
+// movie_booker_loadgen.cpp : load generator for movie_booker.
+//
+// Opens many concurrent sessions (AsyncClient on a shared io_context) that
+// each run a random mix of text commands against the showings found at
+// startup, then reports throughput, latency percentiles per command and
+// the share of bookings refused because the seats were taken.
+
+#include <AsioClient.hpp>
+#include <AsyncClient.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // commands whose latency is reported, in report order
+    enum Op { ListMovies, SelectMovie, ListTheaters, SelectTheater, GetFreeSeats, BookSeats, kOps };
+    constexpr const char* kOpNames[kOps] = { "list_movies", "select_movie", "list_theaters", "select_theater", "get_free_seats", "book_seats" };
+
+    // what a session does next; "select" is a select_movie + select_theater pair
+    enum Action { DoListMovies, DoListTheaters, DoSelect, DoGetFreeSeats, DoBookSeats, kActions };
+    constexpr const char* kActionNames[kActions] = { "list_movies", "list_theaters", "select", "get_free_seats", "book_seats" };
+
+    struct Showing
+    {
+        std::string movie;
+        std::string theater;
+        unsigned int seats = 0;                 // highest seat number seen free at startup
+    };
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        std::size_t connections = 1000;
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        std::chrono::seconds duration{ 10 };
+        double weights[kActions] = { 10, 10, 20, 40, 20 };
+        double zipf = 0.0;                      // 0: every showing equally popular
+        std::size_t showings = 1000;            // showings discovered and targeted
+        unsigned int seats = 2;                 // seats per booking
+        std::chrono::milliseconds think{ 0 };   // pause between a reply and the next command
+    };
+
+    // split a comma-terminated list reply ("a,b,c,") into its items
+    std::vector<std::string> split_list(std::string_view reply)
+    {
+        std::vector<std::string> items;
+        while (!reply.empty())
+        {
+            const std::size_t comma = reply.find(',');
+            if (comma)
+                items.emplace_back(reply.substr(0, comma));
+            if (comma == std::string_view::npos)
+                break;
+            reply.remove_prefix(comma + 1);
+        }
+        return items;
+    }
+
+    // "list_movies=10,select=20,..."; unnamed actions get weight 0
+    bool parse_mix(std::string_view mix, double (&weights)[kActions])
+    {
+        std::fill(std::begin(weights), std::end(weights), 0.0);
+        for (const std::string &item : split_list(mix))
+        {
+            const std::size_t eq = item.find('=');
+            const auto name = std::find_if(std::begin(kActionNames), std::end(kActionNames),
+                [&](const char* n) { return item.compare(0, eq, n) == 0; });
+            if (eq == std::string::npos || name == std::end(kActionNames))
+                return false;
+            weights[name - std::begin(kActionNames)] = std::strtod(item.c_str() + eq + 1, nullptr);
+        }
+        return std::any_of(std::begin(weights), std::end(weights), [](double w) { return w > 0; });
+    }
+
+    // walk the catalog over one blocking session: movies, their theaters, each showing's seats
+    std::vector<Showing> discover(const Options& options)
+    {
+        std::vector<Showing> showings;
+        AsioClient client;
+        if (!client.Connect(options.host, options.port))
+            return showings;
+        client.ReadLine();                                  // greeting
+        client.ReadLine();
+
+        client.WriteLine("list_movies");
+        for (const std::string &movie : split_list(client.ReadLine()))
+        {
+            client.WriteLine("select_movie " + movie);
+            client.ReadLine();
+            client.WriteLine("list_theaters");
+            for (const std::string &theater : split_list(client.ReadLine()))
+            {
+                client.WriteLine("select_theater " + theater);
+                client.ReadLine();
+                client.WriteLine("get_free_seats");
+                unsigned int highest = 0;
+                for (const std::string &seat : split_list(client.ReadLine()))
+                    highest = std::max(highest, static_cast<unsigned int>(std::strtoul(seat.c_str(), nullptr, 10)));
+                if (highest >= options.seats)               // skip sold out showings
+                    showings.push_back({ movie, theater, highest });
+                if (showings.size() == options.showings)
+                    return showings;
+            }
+        }
+        return showings;
+    }
+
+    // samples of one session; merged after the run
+    struct Stats
+    {
+        std::vector<std::uint32_t> latency_ns[kOps];
+        std::uint64_t booked = 0;
+        std::uint64_t conflicts = 0;
+        std::uint64_t errors = 0;               // replies other than the expected ones
+    };
+
+    struct Shared
+    {
+        Options options;
+        std::vector<Showing> showings;
+        std::vector<double> popularity;         // cumulative Zipf weights of showings by rank
+        std::discrete_distribution<int> actions;
+        std::atomic<bool> stopping{ false };
+        std::atomic<std::size_t> connected{ 0 };
+        std::atomic<std::size_t> failed{ 0 };
+        std::string first_error;                // written once, by the first failing connect
+    };
+
+    class Session
+    {
+    public:
+        Session(boost::asio::io_context& io, Shared& shared, std::uint64_t seed)
+            : shared_(shared), client_(AsyncClient::Create(io)), think_(io), rng_(seed), actions_(shared.actions)
+        {
+        }
+
+        void Start(const boost::asio::ip::tcp::resolver::results_type& endpoints)
+        {
+            client_->AsyncConnect(endpoints, [this](const boost::system::error_code& error) {
+                if (error)
+                {
+                    if (shared_.failed.fetch_add(1) == 0)
+                        shared_.first_error = error.message();
+                    return;
+                }
+                shared_.connected.fetch_add(1);
+                Next();
+            });
+        }
+
+        const Stats& GetStats() const { return stats_; }
+
+    private:
+        void Next()
+        {
+            if (shared_.options.think.count() == 0)
+            {
+                Act();
+                return;
+            }
+            think_.expires_after(shared_.options.think);
+            think_.async_wait([this](const boost::system::error_code& error) {
+                if (!error)
+                    Act();
+            });
+        }
+
+        void Act()
+        {
+            if (shared_.stopping.load(std::memory_order_relaxed))
+            {
+                client_->Close();
+                return;
+            }
+
+            Action action = static_cast<Action>(actions_(rng_));
+            if (action == DoListTheaters && !movie_selected_)
+                action = DoSelect;
+            if ((action == DoGetFreeSeats || action == DoBookSeats) && !showing_)
+                action = DoSelect;
+
+            switch (action)
+            {
+            case DoListMovies:
+                Send(ListMovies, "list_movies", [this](std::string_view) { Next(); });
+                break;
+            case DoListTheaters:
+                Send(ListTheaters, "list_theaters", [this](std::string_view) { Next(); });
+                break;
+            case DoSelect:
+            {
+                const Showing *showing = &shared_.showings[PickShowing()];
+                showing_ = nullptr;
+                free_.clear();
+                Send(SelectMovie, "select_movie " + showing->movie, [this, showing](std::string_view reply) {
+                    movie_selected_ = reply.compare(0, 6, "Error!") != 0;
+                    if (!movie_selected_)
+                    {
+                        ++stats_.errors;
+                        Next();
+                        return;
+                    }
+                    Send(SelectTheater, "select_theater " + showing->theater, [this, showing](std::string_view reply) {
+                        if (reply.compare(0, 6, "Error!") == 0)
+                            ++stats_.errors;
+                        else
+                            showing_ = showing;
+                        Next();
+                    });
+                });
+                break;
+            }
+            case DoGetFreeSeats:
+                Send(GetFreeSeats, "get_free_seats", [this](std::string_view reply) {
+                    free_.clear();
+                    for (const std::string &seat : split_list(reply))
+                        free_.push_back(static_cast<unsigned int>(std::strtoul(seat.c_str(), nullptr, 10)));
+                    Next();
+                });
+                break;
+            case DoBookSeats:
+                Send(BookSeats, BookingCommand(), [this](std::string_view reply) {
+                    if (reply == "Seats booked successfully")
+                        ++stats_.booked;
+                    else if (reply == "Error! Could not book seats")
+                        ++stats_.conflicts;
+                    else
+                        ++stats_.errors;
+                    free_.clear();                      // stale either way; fetch again before choosing
+                    Next();
+                });
+                break;
+            case kActions:
+                break;
+            }
+        }
+
+        // rank of a showing drawn from the popularity distribution
+        std::size_t PickShowing()
+        {
+            const auto &cdf = shared_.popularity;
+            const double u = std::uniform_real_distribution<double>(0.0, cdf.back())(rng_);
+            return std::min<std::size_t>(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin(), cdf.size() - 1);
+        }
+
+        // adjacent free seats from the last get_free_seats, or a random block if none were fetched
+        std::string BookingCommand()
+        {
+            const unsigned int count = shared_.options.seats;
+            unsigned int first;
+            if (free_.size() >= count)
+                first = free_[std::uniform_int_distribution<std::size_t>(0, free_.size() - count)(rng_)];
+            else
+                first = std::uniform_int_distribution<unsigned int>(1, showing_->seats - count + 1)(rng_);
+            std::string command = "book_seats ";
+            for (unsigned int s = 0; s < count; ++s)
+                command.append(s ? "," : "").append(std::to_string(first + s));
+            return command;
+        }
+
+        template <typename OnReply>
+        void Send(Op op, const std::string& command, OnReply on_reply)
+        {
+            const Clock::time_point start = Clock::now();
+            client_->AsyncCommand(command, [this, op, start, on_reply](const boost::system::error_code& error, std::string_view reply) {
+                if (error)
+                {
+                    ++stats_.errors;                    // the session ends with its connection
+                    return;
+                }
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                stats_.latency_ns[op].push_back(static_cast<std::uint32_t>(std::min<std::int64_t>(ns, UINT32_MAX)));
+                on_reply(reply);
+            });
+        }
+
+        Shared& shared_;
+        AsyncClient::pointer client_;
+        boost::asio::steady_timer think_;
+        std::mt19937_64 rng_;
+        std::discrete_distribution<int> actions_;
+        Stats stats_;
+        bool movie_selected_ = false;
+        const Showing* showing_ = nullptr;      // selected movie and theater
+        std::vector<unsigned int> free_;        // free seats of showing_ as last fetched
+    };
+
+    double percentile_us(const std::vector<std::uint32_t>& sorted, double q)
+    {
+        if (sorted.empty())
+            return 0.0;
+        return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * static_cast<double>(sorted.size())))] / 1e3;
+    }
+}
+
+// usage: movie_booker_loadgen [--host H] [--port P] [--connections N] [--threads N] [--duration SECONDS]
+//                             [--mix list_movies=10,list_theaters=10,select=20,get_free_seats=40,book_seats=20]
+//                             [--zipf S] [--showings N] [--seats N] [--think-ms MS]
+int main(int argc, char** argv)
+{
+    Shared shared;
+    Options &options = shared.options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool value = i + 1 < argc;
+        if (arg == "--host" && value)
+            options.host = argv[++i];
+        else if (arg == "--port" && value)
+            options.port = argv[++i];
+        else if (arg == "--connections" && value)
+            options.connections = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && value)
+            options.threads = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+        else if (arg == "--duration" && value)
+            options.duration = std::chrono::seconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--zipf" && value)
+            options.zipf = std::strtod(argv[++i], nullptr);
+        else if (arg == "--showings" && value)
+            options.showings = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--seats" && value)
+            options.seats = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+        else if (arg == "--think-ms" && value)
+            options.think = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--mix" && value)
+        {
+            if (!parse_mix(argv[++i], options.weights))
+            {
+                std::cerr << "Invalid --mix; use e.g. list_movies=10,list_theaters=10,select=20,get_free_seats=40,book_seats=20\n";
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+
+    shared.showings = discover(options);
+    if (shared.showings.empty())
+    {
+        std::cerr << "No bookable showings found on " << options.host << ":" << options.port << "\n";
+        return 1;
+    }
+    // showing r (0-based) is drawn with weight 1 / (r + 1)^s
+    double total = 0.0;
+    for (std::size_t r = 0; r < shared.showings.size(); ++r)
+        shared.popularity.push_back(total += 1.0 / std::pow(static_cast<double>(r + 1), options.zipf));
+    shared.actions = std::discrete_distribution<int>(std::begin(options.weights), std::end(options.weights));
+
+    std::cout << "Found " << shared.showings.size() << " showings; running " << options.connections << " sessions on "
+              << options.threads << " thread(s) for " << options.duration.count() << " s\n";
+
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::resolver::results_type endpoints;
+    try {
+        endpoints = boost::asio::ip::tcp::resolver(io).resolve(options.host, options.port);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Cannot resolve " << options.host << ":" << options.port << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::seed_seq seeds{ static_cast<std::uint64_t>(Clock::now().time_since_epoch().count()) };
+    std::vector<std::uint64_t> seed(options.connections);
+    seeds.generate(seed.begin(), seed.end());
+    for (std::size_t i = 0; i < options.connections; ++i)
+    {
+        sessions.push_back(std::make_unique<Session>(io, shared, seed[i]));
+        sessions.back()->Start(endpoints);
+    }
+
+    boost::asio::steady_timer deadline(io, options.duration);
+    deadline.async_wait([&shared](const boost::system::error_code&) { shared.stopping = true; });
+
+    // sessions finish the command in flight after the deadline, then close; run() returns once all have
+    const Clock::time_point begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < options.threads; ++t)
+        threads.emplace_back([&io]() { io.run(); });
+    io.run();
+    for (auto &thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    // merge and report
+    std::vector<std::uint32_t> latency[kOps];
+    Stats total_stats;
+    for (const auto &session : sessions)
+    {
+        const Stats &stats = session->GetStats();
+        for (int op = 0; op < kOps; ++op)
+            latency[op].insert(latency[op].end(), stats.latency_ns[op].begin(), stats.latency_ns[op].end());
+        total_stats.booked += stats.booked;
+        total_stats.conflicts += stats.conflicts;
+        total_stats.errors += stats.errors;
+    }
+    std::size_t commands = 0;
+    for (auto &samples : latency)
+    {
+        std::sort(samples.begin(), samples.end());
+        commands += samples.size();
+    }
+
+    std::cout << "connections: " << shared.connected.load() << " opened, " << shared.failed.load() << " failed";
+    if (shared.failed.load())
+        std::cout << " (" << shared.first_error << ")";
+    std::cout << "\n" << std::fixed << std::setprecision(1)
+              << "commands: " << commands << " in " << seconds << " s, " << commands / seconds << " commands/s\n\n"
+              << std::left << std::setw(16) << "command" << std::right << std::setw(12) << "count"
+              << std::setw(12) << "p50_us" << std::setw(12) << "p99_us" << std::setw(12) << "p999_us" << "\n";
+    for (int op = 0; op < kOps; ++op)
+    {
+        if (latency[op].empty())
+            continue;
+        std::cout << std::left << std::setw(16) << kOpNames[op] << std::right << std::setw(12) << latency[op].size()
+                  << std::setw(12) << percentile_us(latency[op], 0.5) << std::setw(12) << percentile_us(latency[op], 0.99)
+                  << std::setw(12) << percentile_us(latency[op], 0.999) << "\n";
+    }
+
+    const std::uint64_t attempts = total_stats.booked + total_stats.conflicts;
+    std::cout << "\nbookings: " << attempts << " attempted, " << total_stats.booked << " booked, " << total_stats.conflicts
+              << " conflicts (" << (attempts ? 100.0 * total_stats.conflicts / attempts : 0.0) << "%)\n"
+              << "errors: " << total_stats.errors << "\n";
+    return shared.connected.load() ? 0 : 1;
+}
@@ -3,9 +3,12 @@
 #include <boost/asio.hpp>
 #include "AsioServer.hpp"
 #include "IMovieBooker.hpp"
+#include "MovieBooker.hpp"
+#include "AsioClient.hpp"
 #include <thread>
 #include <chrono>
 #include <random>
+#include <atomic>
 
 using ::testing::Return;
 using boost::asio::ip::tcp;
@@ -15,11 +18,28 @@ class MockMovieBooker : public IMovieBooker
 {
 public:
     MOCK_METHOD(bool, AddMovie, (const std::string&, const std::vector<std::string>&), (override));
+    MOCK_METHOD(bool, AddTheater, (const std::string&, std::size_t), (override));
+    MOCK_METHOD(bool, AddCatalog, (const CatalogChunk&), (override));
     MOCK_METHOD(std::vector<std::string>, GetMovies, (), (override));
     MOCK_METHOD(std::vector<std::string>, GetTheatersForMovie, (const std::string&), (override));
     MOCK_METHOD(std::vector<unsigned int>, GetFreeSeats, (const std::string&, const std::string&), (override));
     MOCK_METHOD(bool, BookSeats, (const std::string&, const std::string&, const std::vector<unsigned int>&), (override));
     MOCK_METHOD(bool, IsTheater, (const std::string&), (override));
+    MOCK_METHOD(std::optional<MovieId>, ResolveMovie, (const std::string&), (override));
+    MOCK_METHOD(std::optional<TheaterId>, ResolveTheater, (const std::string&), (override));
+    MOCK_METHOD(std::optional<ShowingId>, ResolveShowing, (MovieId, TheaterId), (override));
+    MOCK_METHOD((std::vector<std::pair<MovieId, std::string>>), GetMovieList, (), (override));
+    MOCK_METHOD((std::vector<std::pair<TheaterId, std::string>>), GetTheaterList, (MovieId), (override));
+    MOCK_METHOD(std::vector<unsigned int>, GetFreeSeats, (ShowingId), (override));
+    MOCK_METHOD(bool, BookSeats, (ShowingId, const std::vector<unsigned int>&), (override));
+    MOCK_METHOD(bool, BookBatch, (const std::vector<BookingItem>&), (override));
+    MOCK_METHOD(bool, BookBest, (ShowingId, std::size_t, bool, std::vector<unsigned int>&), (override));
+    MOCK_METHOD(std::optional<HoldId>, HoldSeats, (ShowingId, const std::vector<unsigned int>&, std::chrono::milliseconds), (override));
+    MOCK_METHOD(bool, ConfirmHold, (HoldId), (override));
+    MOCK_METHOD(bool, ReleaseHold, (HoldId), (override));
+    MOCK_METHOD(std::size_t, ExpireHolds, (std::chrono::steady_clock::time_point), (override));
+    MOCK_METHOD(std::size_t, GetSeatCount, (ShowingId), (override));
+    MOCK_METHOD(std::uint64_t, GetCatalogVersion, (), (const, override));
 };
 
 // Small helper that trims a trailing carriage return from a string (\r).
@@ -90,6 +110,7 @@ TEST(AsioServerTest, ListMoviesCommandCallsBackendAndReturnsList)
     MockMovieBooker mock;
     // include a movie name containing a space to test handling of names with whitespace
     EXPECT_CALL(mock, GetMovies()).WillOnce(Return(std::vector<std::string>{"Movie A", "MovieB"}));
+    EXPECT_CALL(mock, GetCatalogVersion()).WillRepeatedly(Return(1));     // the reply is cached per catalog version
 
     unsigned short port = random_port();
     AsioServer server(mock, port);
@@ -170,8 +191,8 @@ TEST(AsioServerTest, SelectMovieInvalidReturnsError)
 {
     MockMovieBooker mock;
 
-    // Expect the backend to be queried for the movie and return empty list to indicate not found
-    EXPECT_CALL(mock, GetTheatersForMovie("NoSuchMovie")).WillOnce(Return(std::vector<std::string>{}));
+    // Expect the backend to be asked to resolve the movie and report it as unknown
+    EXPECT_CALL(mock, ResolveMovie("NoSuchMovie")).WillOnce(Return(std::nullopt));
 
     // No further expectation needed: server should respond with an error when movie not provided/recognized
     unsigned short port = random_port();
@@ -213,18 +234,20 @@ TEST(AsioServerTest, BookSeatsAndListFreeSeats)
 {
     MockMovieBooker mock;
 
-    // Enforce call order: select_movie -> select_theater -> book_seats -> get_free_seats
+    // Enforce call order: select_movie -> select_theater (resolves the showing once) -> book_seats -> get_free_seats
     ::testing::InSequence seq;
-    EXPECT_CALL(mock, GetTheatersForMovie("MovieX")).WillOnce(Return(std::vector<std::string>{"Theater1"}));
-    EXPECT_CALL(mock, IsTheater("Theater1")).WillOnce(Return(true));
-    EXPECT_CALL(mock, BookSeats("Theater1", "MovieX", ::testing::ElementsAre(5u, 6u))).WillOnce(Return(true));
+    EXPECT_CALL(mock, ResolveMovie("MovieX")).WillOnce(Return(IMovieBooker::MovieId{2}));
+    EXPECT_CALL(mock, ResolveTheater("Theater1")).WillOnce(Return(IMovieBooker::TheaterId{3}));
+    EXPECT_CALL(mock, ResolveShowing(2u, 3u)).WillOnce(Return(IMovieBooker::ShowingId{7}));
+    EXPECT_CALL(mock, GetSeatCount(7u)).WillOnce(Return(20u));
+    EXPECT_CALL(mock, BookSeats(7u, ::testing::ElementsAre(5u, 6u))).WillOnce(Return(true));
 
     // After booking, GetFreeSeats should not include 5 and 6
     std::vector<unsigned int> freeSeats;
     for (unsigned int i = 1; i <= 20; ++i)
         if (i != 5 && i != 6)
             freeSeats.push_back(i);
-    EXPECT_CALL(mock, GetFreeSeats("Theater1", "MovieX")).WillOnce(Return(freeSeats));
+    EXPECT_CALL(mock, GetFreeSeats(7u)).WillOnce(Return(freeSeats));
 
     unsigned short port = random_port();
     AsioServer server(mock, port);
@@ -287,13 +310,13 @@ TEST(AsioServerTest, BookSeatsAndListFreeSeats)
     thr.join();
 }
 
-// Test: selecting a theater calls IsTheater on the backend and returns selection confirmation
-TEST(AsioServerTest, SelectTheaterCallsIsTheaterAndReturnsSelected)
+// Test: selecting a theater resolves it on the backend and returns selection confirmation
+TEST(AsioServerTest, SelectTheaterResolvesTheaterAndReturnsSelected)
 {
     MockMovieBooker mock;
 
-    // Expect IsTheater to be called and return true indicating theater exists
-    EXPECT_CALL(mock, IsTheater("TheaterExist")).WillOnce(Return(true));
+    // Expect ResolveTheater to be called and return an id indicating theater exists
+    EXPECT_CALL(mock, ResolveTheater("TheaterExist")).WillOnce(Return(IMovieBooker::TheaterId{0}));
 
     unsigned short port = random_port();
     AsioServer server(mock, port);
@@ -328,3 +351,728 @@ TEST(AsioServerTest, SelectTheaterCallsIsTheaterAndReturnsSelected)
     server.Stop();
     thr.join();
 }
+
+// Test: many client sessions run concurrently against a multi-threaded server backed by a real
+// MovieBooker. Every session books one seat; exactly one session per seat may succeed.
+TEST(AsioServerTest, ConcurrentSessionsOnThreadPool)
+{
+    MovieBooker booker;
+    booker.AddMovie("MovieX", {"Theater1"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port, 4);
+    EXPECT_EQ(server.GetThreadCount(), 4u);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    const int sessions = 64;
+    std::atomic<int> booked{0}, failed{0}, errors{0};
+    std::vector<std::thread> clients;
+    for (int i = 0; i < sessions; ++i)
+    {
+        clients.emplace_back([&, i]()
+        {
+            try
+            {
+                boost::asio::io_context io;
+                tcp::socket sock(io);
+                connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+                boost::asio::streambuf buf;
+                auto read_line = [&]() {
+                    boost::asio::read_until(sock, buf, '\n');
+                    std::istream is(&buf);
+                    std::string line;
+                    std::getline(is, line);
+                    return trim_cr(line);
+                };
+
+                read_line();                                        // greeting
+                read_line();                                        // empty line after greeting
+                boost::asio::write(sock, boost::asio::buffer(std::string("select_movie MovieX\n")));
+                if (read_line().find("Movie MovieX selected") == std::string::npos)
+                    ++errors;
+                boost::asio::write(sock, boost::asio::buffer(std::string("select_theater Theater1\n")));
+                if (read_line().find("Theater Theater1 selected") == std::string::npos)
+                    ++errors;
+
+                // 64 sessions over 20 seats: three or four sessions compete for each seat
+                std::string cmd = "book_seats " + std::to_string(i % 20 + 1) + "\n";
+                boost::asio::write(sock, boost::asio::buffer(cmd));
+                std::string resp = read_line();
+                if (resp.find("Seats booked successfully") != std::string::npos)
+                    ++booked;
+                else if (resp.find("Error! Could not book seats") != std::string::npos)
+                    ++failed;
+                else
+                    ++errors;
+            }
+            catch (const std::exception&)
+            {
+                ++errors;
+            }
+        });
+    }
+    for (auto &c : clients)
+        c.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(booked.load(), 20);
+    EXPECT_EQ(failed.load(), sessions - 20);
+    EXPECT_TRUE(booker.GetFreeSeats("Theater1", "MovieX").empty());
+
+    server.Stop();
+    thr.join();
+}
+
+// Waits (bounded) until the server reports the expected number of live sessions.
+static bool wait_for_live(const AsioServer& server, std::size_t expected)
+{
+    for (int i = 0; i < 200; ++i)
+    {
+        if (server.GetLiveConnections() == expected)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// Test: a released slot is reused and the idle connection object is recycled instead of reallocated.
+TEST(ConnectionRegistryTest, ReleasedSlotAndConnectionAreReused)
+{
+    MockMovieBooker mock;
+    boost::asio::io_context io;
+    connection_registry registry(1);
+
+    auto first = registry.acquire(io, mock);
+    EXPECT_TRUE(registry.admit(first));
+    EXPECT_EQ(registry.live(), 1u);
+
+    auto second = registry.acquire(io, mock);
+    EXPECT_FALSE(registry.admit(second));            // limit of 1 reached
+    second->close();
+    first->close();
+    EXPECT_EQ(registry.live(), 0u);
+    EXPECT_EQ(registry.peak(), 1u);
+
+    tcp_connection* recycled = first.get();
+    first.reset();
+    second.reset();
+
+    auto third = registry.acquire(io, mock);
+    EXPECT_EQ(third.get(), recycled);                // last released slot, same object
+    EXPECT_EQ(registry.slots(), 2u);                 // no new slot was created
+}
+
+// Test: sessions are removed from the server when the client disconnects.
+TEST(AsioServerTest, DisconnectedSessionsAreReaped)
+{
+    MockMovieBooker mock;
+    unsigned short port = random_port();
+    AsioServer server(mock, port, 2);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        boost::asio::io_context io;
+        tcp::socket sock(io);
+        connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+        boost::asio::streambuf buf;
+        boost::asio::read_until(sock, buf, '\n');
+        EXPECT_EQ(server.GetLiveConnections(), 1u);
+        sock.close();
+        EXPECT_TRUE(wait_for_live(server, 0));
+    }
+    EXPECT_EQ(server.GetPeakConnections(), 1u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: clients above the max-connections limit get an error and are disconnected.
+TEST(AsioServerTest, MaxConnectionsRejectsExtraClients)
+{
+    MockMovieBooker mock;
+    unsigned short port = random_port();
+    AsioServer server(mock, port, 1, 2);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto read_first_line = [](tcp::socket& sock) {
+        boost::asio::streambuf buf;
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+
+    boost::asio::io_context io;
+    tcp::socket c1(io), c2(io), c3(io), c4(io);
+    connect_to_localhost(io, c1, std::to_string(server.GetPort()));
+    EXPECT_NE(read_first_line(c1).find("Hello!"), std::string::npos);
+    connect_to_localhost(io, c2, std::to_string(server.GetPort()));
+    EXPECT_NE(read_first_line(c2).find("Hello!"), std::string::npos);
+
+    connect_to_localhost(io, c3, std::to_string(server.GetPort()));
+    EXPECT_EQ(read_first_line(c3).find("Error! Server busy"), 0u);
+    EXPECT_EQ(server.GetLiveConnections(), 2u);
+
+    // once a session ends there is room again
+    c1.close();
+    EXPECT_TRUE(wait_for_live(server, 1));
+    connect_to_localhost(io, c4, std::to_string(server.GetPort()));
+    EXPECT_NE(read_first_line(c4).find("Hello!"), std::string::npos);
+    EXPECT_EQ(server.GetPeakConnections(), 2u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: book_seats validates seat ids against the selected theater's real capacity.
+TEST(AsioServerTest, BookSeatsValidatesAgainstTheaterCapacity)
+{
+    MovieBooker booker;
+    booker.AddTheater("Arena", 5000);
+    booker.AddMovie("Concert", {"Arena"});
+    booker.AddMovie("Opera", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    tcp::socket sock(io);
+    connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+    boost::asio::streambuf buf;
+    auto read_line = [&]() {
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+    auto command = [&](const std::string& cmd) {
+        boost::asio::write(sock, boost::asio::buffer(cmd + "\n"));
+        return read_line();
+    };
+
+    read_line();                                        // greeting
+    read_line();
+    command("select_movie Concert");
+    command("select_theater Arena");
+
+    EXPECT_EQ(command("book_seats 4999,5000"), "Seats booked successfully");
+    EXPECT_EQ(command("book_seats 5001"), "Error! Seats not in range 1-5000");
+    EXPECT_EQ(command("book_seats 1"), "Seats booked successfully");    // exactly one reply per command
+    EXPECT_TRUE(booker.GetFreeSeats("Arena", "Concert").size() == 4997u);
+
+    // a theater that does not show the movie selects no showing, so no seat range applies
+    command("select_theater Hall");
+    EXPECT_EQ(command("book_seats 5001"), "Error! No valid theater selected");
+    EXPECT_EQ(command("hold_seats 1"), "Error! No valid theater selected");
+    EXPECT_EQ(command("book_best 2"), "Error! No valid theater selected");
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: several commands sent in one write are all answered, in order, and a
+// trailing partial line is kept until the rest of it arrives.
+TEST(AsioServerTest, PipelinedCommandsAreAnsweredInOrder)
+{
+    MovieBooker booker;
+    booker.AddTheater("Hall", 5);
+    booker.AddMovie("Film", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    tcp::socket sock(io);
+    connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+    boost::asio::streambuf buf;
+    auto read_line = [&]() {
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+
+    read_line();                                        // greeting
+    read_line();
+
+    boost::asio::write(sock, boost::asio::buffer(std::string(
+        "select_movie Film\r\nselect_theater Nowhere\nselect_theater Hall\nbook_seats 1,2\nbook_seats 2\nget_free_seats\nbogus\nbook_seats 5")));
+    EXPECT_EQ(read_line(), "Movie Film selected");
+    EXPECT_EQ(read_line(), "Error! Select a valid theater");
+    EXPECT_EQ(read_line(), "Theater Hall selected");
+    EXPECT_EQ(read_line(), "Seats booked successfully");
+    EXPECT_EQ(read_line(), "Error! Could not book seats");
+    EXPECT_EQ(read_line(), "3,4,5,");
+    EXPECT_EQ(read_line(), "Error! Enter a valid command");
+
+    boost::asio::write(sock, boost::asio::buffer(std::string("\n")));   // completes "book_seats 5"
+    EXPECT_EQ(read_line(), "Seats booked successfully");
+    EXPECT_EQ(booker.GetFreeSeats("Hall", "Film").size(), 2u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: cached list replies keep their place among pipelined replies and follow catalog changes.
+TEST(AsioServerTest, ListRepliesFollowCatalogChanges)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    tcp::socket sock(io);
+    connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+    boost::asio::streambuf buf;
+    auto read_line = [&]() {
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+
+    read_line();                                        // greeting
+    read_line();
+
+    boost::asio::write(sock, boost::asio::buffer(std::string(
+        "bogus\nlist_movies\nselect_movie Film\nlist_theaters\nlist_movies\nbogus\n")));
+    EXPECT_EQ(read_line(), "Error! Enter a valid command");
+    EXPECT_EQ(read_line(), "Film,");
+    EXPECT_EQ(read_line(), "Movie Film selected");
+    EXPECT_EQ(read_line(), "Hall,");
+    EXPECT_EQ(read_line(), "Film,");
+    EXPECT_EQ(read_line(), "Error! Enter a valid command");
+
+    ASSERT_TRUE(booker.AddMovie("Film", {"Hall", "Annex"}));
+    ASSERT_TRUE(booker.AddMovie("Sequel", {"Annex"}));
+    boost::asio::write(sock, boost::asio::buffer(std::string("list_theaters\nlist_movies\n")));
+    const std::string theaters = read_line(), movies = read_line();
+    EXPECT_TRUE(theaters == "Hall,Annex," || theaters == "Annex,Hall,") << theaters;
+    EXPECT_TRUE(movies == "Film,Sequel," || movies == "Sequel,Film,") << movies;
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: a client that pipelines many large requests before reading any reply
+// gets every reply, complete and in order, once it starts reading (the server
+// pauses reading while its outbound queue is above the high-water mark).
+TEST(AsioServerTest, SlowReaderReceivesAllQueuedReplies)
+{
+    MovieBooker booker;
+    booker.AddTheater("Arena", 4000);
+    booker.AddMovie("Concert", {"Arena"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    tcp::socket sock(io);
+    connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+    boost::asio::streambuf buf;
+    auto read_line = [&]() {
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+
+    // ~19KB per reply, ~4MB in total: far beyond the high-water mark and socket buffers
+    const int requests = 200;
+    std::string batch = "select_movie Concert\nselect_theater Arena\nbook_seats 1,no_theater\n";
+    for (int i = 0; i < requests; ++i)
+        batch += "get_free_seats\n";
+    boost::asio::write(sock, boost::asio::buffer(batch));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    read_line();                                        // greeting
+    read_line();
+    EXPECT_EQ(read_line(), "Movie Concert selected");
+    EXPECT_EQ(read_line(), "Theater Arena selected");
+    EXPECT_EQ(read_line(), "Seats booked successfully");
+    for (int i = 0; i < requests; ++i)
+    {
+        std::string line = read_line();
+        ASSERT_EQ(line.compare(0, 4, "2,3,"), 0) << "reply " << i;
+        ASSERT_EQ(line.compare(line.size() - 5, 5, "4000,"), 0) << "reply " << i;
+    }
+    EXPECT_EQ(server.GetLiveConnections(), 1u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: commands that arrived in one read stop executing once the replies queued
+// for a client that does not read reach the high-water mark, so the server's
+// queue stays bounded; every reply still arrives once the client reads.
+TEST(AsioServerTest, PipelinedCommandsPauseAtHighWaterMark)
+{
+    MovieBooker booker;
+    booker.AddTheater("Stadium", 20000);
+    booker.AddMovie("Final", {"Stadium"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    tcp::socket sock(io);
+    sock.open(tcp::v4());
+    sock.set_option(boost::asio::socket_base::receive_buffer_size(4096));
+    connect_to_localhost(io, sock, std::to_string(server.GetPort()));
+
+    boost::asio::streambuf buf;
+    auto read_line = [&]() {
+        boost::asio::read_until(sock, buf, '\n');
+        std::istream is(&buf);
+        std::string line;
+        std::getline(is, line);
+        return trim_cr(line);
+    };
+
+    // ~110KB per reply: 600 replies would queue ~66MB without the pause
+    const int requests = 600;
+    std::string batch = "select_movie Final\nselect_theater Stadium\n";
+    for (int i = 0; i < requests; ++i)
+        batch += "get_free_seats\n";
+    boost::asio::write(sock, boost::asio::buffer(batch));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // what was served fits the high-water mark plus the socket buffers (a few MB), far from all of it
+    const auto served = [&server]() {
+        return server.GetMetrics().commands[static_cast<std::size_t>(Command::GetFreeSeats)].count;
+    };
+    EXPECT_LT(served(), 100u);
+
+    read_line();                                        // greeting
+    read_line();
+    EXPECT_EQ(read_line(), "Movie Final selected");
+    EXPECT_EQ(read_line(), "Theater Stadium selected");
+    for (int i = 0; i < requests; ++i)
+    {
+        std::string line = read_line();
+        ASSERT_EQ(line.compare(0, 4, "1,2,"), 0) << "reply " << i;
+        ASSERT_EQ(line.compare(line.size() - 6, 6, "20000,"), 0) << "reply " << i;
+    }
+    EXPECT_EQ(served(), static_cast<std::uint64_t>(requests));
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: after "binary" the session serves stateless framed requests through
+// AsioClient's binary mode, backed by the same booker as the text protocol.
+TEST(AsioServerTest, BinaryModeServesStatelessRequests)
+{
+    MovieBooker booker;
+    booker.AddTheater("Hall", 30);
+    booker.AddMovie("Film", {"Hall", "Annex"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    AsioClient client;
+    ASSERT_TRUE(client.Connect("127.0.0.1", std::to_string(server.GetPort())));
+    ASSERT_TRUE(client.EnterBinaryMode());
+
+    std::vector<std::pair<std::uint32_t, std::string>> movies, theaters;
+    ASSERT_EQ(client.ListMovies(movies), FrameStatus::Ok);
+    ASSERT_EQ(movies.size(), 1u);
+    EXPECT_EQ(movies[0].second, "Film");
+    ASSERT_EQ(client.ListTheaters(movies[0].first, theaters), FrameStatus::Ok);
+    EXPECT_EQ(theaters.size(), 2u);
+
+    const std::uint32_t movie = movies[0].first;
+    const std::uint32_t hall = *booker.ResolveTheater("Hall");
+    EXPECT_EQ(client.BookSeats(movie, hall, { 1, 30 }), FrameStatus::Ok);
+    EXPECT_EQ(client.BookSeats(movie, hall, { 2, 30 }), FrameStatus::SeatsUnavailable);
+    EXPECT_EQ(client.BookSeats(movie, hall, { 31 }), FrameStatus::InvalidSeats);
+    EXPECT_EQ(client.BookSeats(movie, 999, { 1 }), FrameStatus::UnknownShowing);
+
+    std::vector<unsigned int> seats;
+    ASSERT_EQ(client.GetFreeSeats(movie, hall, seats), FrameStatus::Ok);
+    EXPECT_EQ(seats.size(), 28u);
+    EXPECT_EQ(seats.front(), 2u);
+    EXPECT_EQ(seats.back(), 29u);
+    EXPECT_EQ(booker.GetFreeSeats("Hall", "Film").size(), 28u);
+
+    std::string response;
+    EXPECT_EQ(client.Request(static_cast<Opcode>(77), "", response), FrameStatus::BadRequest);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: book_batch books items across showings in one command, all or nothing,
+// over the text protocol and as a binary BookBatch frame.
+TEST(AsioServerTest, BookBatchBooksAcrossShowings)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall", "Annex"});
+    booker.AddMovie("Other", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    AsioClient client;
+    ASSERT_TRUE(client.Connect("127.0.0.1", std::to_string(server.GetPort())));
+    client.ReadLine();                                  // greeting
+    client.ReadLine();
+
+    client.WriteLine("book_batch Film|Hall|1,2; Film|Annex|1; Other|Hall|5");
+    EXPECT_EQ(client.ReadLine(), "Batch booked successfully");
+    client.WriteLine("book_batch Film|Annex|2; Other|Hall|5");         // seat 5 is taken
+    EXPECT_EQ(client.ReadLine(), "Error! Could not book batch");
+    client.WriteLine("book_batch Film|Annex|3; Film|Nowhere|1");
+    EXPECT_EQ(client.ReadLine(), "Error! Invalid batch item 2");
+    client.WriteLine("book_batch Film|Annex|21");
+    EXPECT_EQ(client.ReadLine(), "Error! Invalid batch item 1");
+    client.WriteLine("book_batch");
+    EXPECT_EQ(client.ReadLine(), "Error! No valid batch specified");
+
+    EXPECT_EQ(booker.GetFreeSeats("Hall", "Film").size(), 18u);
+    EXPECT_EQ(booker.GetFreeSeats("Annex", "Film").size(), 19u);
+    EXPECT_EQ(booker.GetFreeSeats("Hall", "Other").size(), 19u);
+
+    // binary: two items, the second one conflicting, then both free
+    ASSERT_TRUE(client.EnterBinaryMode());
+    const std::uint32_t film = *booker.ResolveMovie("Film"), hall = *booker.ResolveTheater("Hall"), annex = *booker.ResolveTheater("Annex");
+    auto batch = [&](unsigned int annexSeat) {
+        std::string payload, response;
+        BinaryProtocol::AppendU32(payload, 2);
+        BinaryProtocol::AppendU32(payload, film);
+        BinaryProtocol::AppendU32(payload, hall);
+        BinaryProtocol::AppendSeatBitmap(payload, { 10 }, 10);
+        BinaryProtocol::AppendU32(payload, film);
+        BinaryProtocol::AppendU32(payload, annex);
+        BinaryProtocol::AppendSeatBitmap(payload, { annexSeat }, annexSeat);
+        return client.Request(Opcode::BookBatch, payload, response);
+    };
+    EXPECT_EQ(batch(1), FrameStatus::SeatsUnavailable);
+    EXPECT_EQ(batch(21), FrameStatus::InvalidSeats);
+    EXPECT_EQ(batch(11), FrameStatus::Ok);
+    EXPECT_EQ(booker.GetFreeSeats("Hall", "Film").size(), 17u);
+    EXPECT_EQ(booker.GetFreeSeats("Annex", "Film").size(), 18u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: hold_seats reserves seats for the selected showing, confirm_hold books
+// them, and holds left alone are expired by the server's timer.
+TEST(AsioServerTest, HoldsAreConfirmedOrExpire)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    server.SetHoldTtl(std::chrono::milliseconds(200));
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    AsioClient client;
+    ASSERT_TRUE(client.Connect("127.0.0.1", std::to_string(server.GetPort())));
+    client.ReadLine();                                  // greeting
+    client.ReadLine();
+
+    client.WriteLine("hold_seats 1,2");
+    EXPECT_EQ(client.ReadLine(), "Error! No valid movie selected");
+    client.WriteLine("select_movie Film");
+    client.ReadLine();
+    client.WriteLine("select_theater Hall");
+    client.ReadLine();
+
+    client.WriteLine("hold_seats 1,2");
+    const std::string created = client.ReadLine();
+    ASSERT_EQ(created.rfind("Hold ", 0), 0u);
+    const std::string first = created.substr(5, created.find(' ', 5) - 5);
+    client.WriteLine("hold_seats 2,3");
+    EXPECT_EQ(client.ReadLine(), "Error! Could not hold seats");
+    client.WriteLine("book_seats 1");
+    EXPECT_EQ(client.ReadLine(), "Error! Could not book seats");
+    client.WriteLine("hold_seats 5");
+    const std::string second = client.ReadLine();
+    ASSERT_EQ(second.rfind("Hold ", 0), 0u);
+
+    client.WriteLine("confirm_hold " + first);
+    EXPECT_EQ(client.ReadLine(), "Hold confirmed");
+    client.WriteLine("release_hold " + first);
+    EXPECT_EQ(client.ReadLine(), "Error! Unknown or expired hold");
+    client.WriteLine("confirm_hold abc");
+    EXPECT_EQ(client.ReadLine(), "Error! Specify a valid hold id");
+
+    // the second hold is never confirmed; the expiry timer gives seat 5 back
+    const auto showing = *booker.ResolveShowing(*booker.ResolveMovie("Film"), *booker.ResolveTheater("Hall"));
+    for (int i = 0; i < 100 && booker.GetHeldSeatCount(showing) > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(booker.GetHeldSeatCount(showing), 0u);
+    EXPECT_EQ(booker.GetFreeSeats(showing).size(), 18u);      // 1 and 2 stay booked
+
+    // binary: hold, then release
+    ASSERT_TRUE(client.EnterBinaryMode());
+    std::string payload, response;
+    BinaryProtocol::AppendU32(payload, *booker.ResolveMovie("Film"));
+    BinaryProtocol::AppendU32(payload, *booker.ResolveTheater("Hall"));
+    BinaryProtocol::AppendSeatBitmap(payload, { 7, 8 }, 8);
+    ASSERT_EQ(client.Request(Opcode::HoldSeats, payload, response), FrameStatus::Ok);
+    FrameReader in(response);
+    std::string holdPayload;
+    BinaryProtocol::AppendU64(holdPayload, in.U64());
+    ASSERT_TRUE(in.Ok() && in.AtEnd());
+    EXPECT_EQ(booker.GetHeldSeatCount(showing), 2u);
+    EXPECT_EQ(client.Request(Opcode::HoldSeats, payload, response), FrameStatus::SeatsUnavailable);
+
+    EXPECT_EQ(client.Request(Opcode::ReleaseHold, holdPayload, response), FrameStatus::Ok);
+    EXPECT_EQ(client.Request(Opcode::ConfirmHold, holdPayload, response), FrameStatus::UnknownHold);
+    EXPECT_EQ(booker.GetHeldSeatCount(showing), 0u);
+    EXPECT_EQ(booker.GetFreeSeats(showing).size(), 18u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: book_best lets the server pick the seats for the selected showing,
+// over the text protocol and as a binary BookBest frame.
+TEST(AsioServerTest, BookBestBooksServerChosenSeats)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    const auto showing = *booker.ResolveShowing(*booker.ResolveMovie("Film"), *booker.ResolveTheater("Hall"));
+    ASSERT_TRUE(booker.BookSeats(showing, {2}));
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    AsioClient client;
+    ASSERT_TRUE(client.Connect("127.0.0.1", std::to_string(server.GetPort())));
+    client.ReadLine();                                  // greeting
+    client.ReadLine();
+
+    client.WriteLine("select_movie Film");
+    client.ReadLine();
+    client.WriteLine("select_theater Hall");
+    client.ReadLine();
+
+    client.WriteLine("book_best 3 contiguous");
+    EXPECT_EQ(client.ReadLine(), "Seats booked: 3,4,5");
+    client.WriteLine("book_best 2");
+    EXPECT_EQ(client.ReadLine(), "Seats booked: 6,7");
+    client.WriteLine("book_best 21");
+    EXPECT_EQ(client.ReadLine(), "Error! Too many seats requested; request 1 to 20 seats");
+    client.WriteLine("book_best x");
+    EXPECT_EQ(client.ReadLine(), "Error! Specify a number of seats");
+    client.WriteLine("book_best 14 contiguous");        // 1 and 8..20 are free
+    EXPECT_EQ(client.ReadLine(), "Error! Could not book seats");
+
+    ASSERT_TRUE(client.EnterBinaryMode());
+    std::string payload, response;
+    BinaryProtocol::AppendU32(payload, *booker.ResolveMovie("Film"));
+    BinaryProtocol::AppendU32(payload, *booker.ResolveTheater("Hall"));
+    BinaryProtocol::AppendU32(payload, 13);
+    BinaryProtocol::AppendU16(payload, BinaryProtocol::kContiguousFlag);
+    ASSERT_EQ(client.Request(Opcode::BookBest, payload, response), FrameStatus::Ok);
+    FrameReader in(response);
+    std::vector<unsigned int> seats;
+    std::size_t capacity = 0;
+    ASSERT_TRUE(BinaryProtocol::ReadSeatBitmap(in, seats, &capacity));
+    EXPECT_EQ(capacity, 20u);
+    EXPECT_EQ(seats.size(), 13u);
+    EXPECT_EQ(seats.front(), 8u);
+    EXPECT_EQ(client.Request(Opcode::BookBest, payload, response), FrameStatus::SeatsUnavailable);
+    EXPECT_EQ(booker.GetFreeSeats(showing).size(), 1u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Test: "stats" and the admin port's /metrics report the commands, bookings
+// and connections of the server's sessions.
+TEST(AsioServerTest, StatsAndAdminEndpointReportMetrics)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+
+    unsigned short port = random_port();
+    AsioServer server(booker, port);
+    server.EnableAdmin(0);
+    ASSERT_NE(server.GetAdminPort(), 0);
+    auto thr = start_server(&server);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    AsioClient client;
+    ASSERT_TRUE(client.Connect("127.0.0.1", std::to_string(server.GetPort())));
+    client.ReadLine();                                  // greeting
+    client.ReadLine();
+    client.WriteLine("select_movie Film");
+    client.ReadLine();
+    client.WriteLine("select_theater Hall");
+    client.ReadLine();
+    client.WriteLine("book_seats 1,2");
+    EXPECT_EQ(client.ReadLine(), "Seats booked successfully");
+    client.WriteLine("book_seats 2");
+    EXPECT_EQ(client.ReadLine(), "Error! Could not book seats");
+    client.WriteLine("no_such_command");
+    client.ReadLine();
+
+    client.WriteLine("stats");
+    std::vector<std::string> lines;
+    for (std::string line = client.ReadLine(); !line.empty(); line = client.ReadLine())
+        lines.push_back(line);
+    EXPECT_THAT(lines, ::testing::Contains(::testing::StartsWith("book_seats count=2 p50_us=")));
+    EXPECT_THAT(lines, ::testing::Contains(::testing::StartsWith("unknown count=1 ")));
+    EXPECT_THAT(lines, ::testing::Contains("bookings booked=1 conflicts=1"));
+    EXPECT_THAT(lines, ::testing::Contains(::testing::StartsWith("connections live=1 peak=1 accepted=1 ")));
+
+    auto http_get = [&](const std::string& path) {
+        boost::asio::io_context io;
+        tcp::socket sock(io);
+        connect_to_localhost(io, sock, std::to_string(server.GetAdminPort()));
+        boost::asio::write(sock, boost::asio::buffer("GET " + path + " HTTP/1.0\r\nHost: localhost\r\n\r\n"));
+        std::string response;
+        boost::system::error_code ec;
+        boost::asio::read(sock, boost::asio::dynamic_buffer(response), ec);     // until the server closes
+        return response;
+    };
+    const std::string metrics = http_get("/metrics");
+    EXPECT_EQ(metrics.compare(0, 15, "HTTP/1.0 200 OK"), 0);
+    EXPECT_THAT(metrics, ::testing::HasSubstr("\nmovie_booker_requests_total{command=\"book_seats\"} 2\n"));
+    EXPECT_THAT(metrics, ::testing::HasSubstr("\nmovie_booker_request_duration_seconds_count{command=\"book_seats\"} 1\n"));
+    EXPECT_THAT(metrics, ::testing::HasSubstr("\nmovie_booker_bookings_total{result=\"conflict\"} 1\n"));
+    EXPECT_THAT(metrics, ::testing::HasSubstr("\nmovie_booker_connections 1\n"));
+    EXPECT_EQ(http_get("/").compare(0, 22, "HTTP/1.0 404 Not Found"), 0);
+
+    server.Stop();
+    thr.join();
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <AsioServer.hpp>
+#include <AsyncClient.hpp>
+#include <MovieBooker.hpp>
+
+#include <chrono>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    unsigned short random_port()
+    {
+        static std::mt19937 rng((std::random_device())());
+        return static_cast<unsigned short>(std::uniform_int_distribution<int>(20000, 40000)(rng));
+    }
+}
+
+// Tests that a session connects, chains commands from its handlers and gets each reply, multi-line "stats" included.
+TEST(AsyncClientTest, CommandsChainFromHandlers)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    AsioServer server(booker, random_port());
+    std::thread thr([&server]() { server.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    const auto endpoints = boost::asio::ip::tcp::resolver(io).resolve("127.0.0.1", std::to_string(server.GetPort()));
+    const std::vector<std::string> commands = { "list_movies", "select_movie Film", "select_theater Hall", "book_seats 1,2", "book_seats 2", "stats" };
+    std::vector<std::string> replies;
+    bool connected = false;
+
+    auto session = AsyncClient::Create(io);
+    std::function<void()> next = [&]() {
+        if (replies.size() == commands.size())
+        {
+            session->Close();
+            return;
+        }
+        session->AsyncCommand(commands[replies.size()], [&](const boost::system::error_code& error, std::string_view reply) {
+            ASSERT_FALSE(error);
+            replies.emplace_back(reply);
+            next();
+        });
+    };
+    session->AsyncConnect(endpoints, [&](const boost::system::error_code& error) {
+        connected = !error;
+        if (connected)
+            next();
+    });
+    io.run();
+
+    EXPECT_TRUE(connected);
+    ASSERT_EQ(replies.size(), commands.size());
+    EXPECT_EQ(replies[0], "Film,");
+    EXPECT_EQ(replies[2], "Theater Hall selected");
+    EXPECT_EQ(replies[3], "Seats booked successfully");
+    EXPECT_EQ(replies[4], "Error! Could not book seats");
+    EXPECT_EQ(replies[5].compare(0, 11, "list_movies"), 0);
+    EXPECT_NE(replies[5].find("\nbookings booked=1 conflicts=1\n"), std::string::npos);
+
+    server.Stop();
+    thr.join();
+}
+
+// Tests that "stats" spelled the way the server still accepts gets its multi-line reply, and the replies after it stay in step.
+TEST(AsyncClientTest, StatsIsRecognizedLikeTheServerDoes)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    AsioServer server(booker, random_port());
+    std::thread thr([&server]() { server.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    const auto endpoints = boost::asio::ip::tcp::resolver(io).resolve("127.0.0.1", std::to_string(server.GetPort()));
+    auto session = AsyncClient::Create(io);
+    const std::vector<std::string> commands = { "STATS", " stats ", "select_movie Film" };
+    std::vector<std::string> replies;
+    for (const auto &command : commands)
+        session->AsyncCommand(command, [&](const boost::system::error_code& error, std::string_view reply) {
+            EXPECT_FALSE(error);
+            replies.emplace_back(reply);
+            if (replies.size() == commands.size())
+                session->Close();
+        });
+    session->AsyncConnect(endpoints, [](const boost::system::error_code& error) { EXPECT_FALSE(error); });
+    io.run();
+
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_NE(replies[0].find("\nbookings "), std::string::npos) << replies[0];
+    EXPECT_NE(replies[1].find("\nbookings "), std::string::npos) << replies[1];
+    EXPECT_EQ(replies[2], "Movie Film selected");
+
+    server.Stop();
+    thr.join();
+}
+
+// Tests that connecting to a server at its connection limit fails with connection_refused.
+TEST(AsyncClientTest, BusyServerRefusesConnect)
+{
+    MovieBooker booker;
+    AsioServer server(booker, random_port(), 1, 1);
+    std::thread thr([&server]() { server.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    const auto endpoints = boost::asio::ip::tcp::resolver(io).resolve("127.0.0.1", std::to_string(server.GetPort()));
+    auto first = AsyncClient::Create(io), second = AsyncClient::Create(io);
+    boost::system::error_code first_error = boost::asio::error::timed_out, second_error = boost::asio::error::timed_out;
+    first->AsyncConnect(endpoints, [&](const boost::system::error_code& error) {
+        first_error = error;
+        second->AsyncConnect(endpoints, [&](const boost::system::error_code& error) {
+            second_error = error;
+            first->Close();
+        });
+    });
+    io.run();
+
+    EXPECT_FALSE(first_error);
+    EXPECT_EQ(second_error, boost::asio::error::connection_refused);
+
+    server.Stop();
+    thr.join();
+}
+
+// Tests that commands queued before the connection is up are pipelined and their replies come back in order.
+TEST(AsyncClientTest, PipelinedRepliesMatchCommandsInOrder)
+{
+    MovieBooker booker;
+    for (int m = 0; m < 10; ++m)
+        booker.AddMovie("Film " + std::to_string(m), {"Hall"});
+    AsioServer server(booker, random_port());
+    std::thread thr([&server]() { server.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    const auto endpoints = boost::asio::ip::tcp::resolver(io).resolve("127.0.0.1", std::to_string(server.GetPort()));
+    auto session = AsyncClient::Create(io);
+    std::vector<std::string> replies;
+    for (int i = 0; i < 100; ++i)
+    {
+        session->AsyncCommand("select_movie Film " + std::to_string(i % 10), [&](const boost::system::error_code& error, std::string_view reply) {
+            EXPECT_FALSE(error);
+            replies.emplace_back(reply);
+            if (replies.size() == 100)
+                session->Close();
+        });
+    }
+    EXPECT_EQ(session->Pending(), 100u);
+    session->AsyncConnect(endpoints, [](const boost::system::error_code& error) { EXPECT_FALSE(error); });
+    io.run();
+
+    ASSERT_EQ(replies.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(replies[i], "Movie Film " + std::to_string(i % 10) + " selected");
+    EXPECT_EQ(session->Pending(), 0u);
+
+    server.Stop();
+    thr.join();
+}
+
+// Tests that a pool answers futures from a thread not running the io_context, spreading them over its sessions.
+TEST(AsyncClientTest, PoolFuturesFromAnotherThread)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    AsioServer server(booker, random_port());
+    std::thread thr([&server]() { server.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    boost::asio::io_context io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread runner([&io]() { io.run(); });
+    {
+        AsyncClientPool pool(io, "127.0.0.1", std::to_string(server.GetPort()), 3);
+        std::vector<std::future<std::string>> replies;
+        for (int i = 0; i < 30; ++i)
+            replies.push_back(pool.Command("list_movies"));
+        for (auto &reply : replies)
+            EXPECT_EQ(reply.get(), "Film,");
+
+        // each session keeps its own connection to the server
+        const std::string stats = pool.Command("stats").get();
+        EXPECT_NE(stats.find("connections live=3 "), std::string::npos);
+    }
+    work.reset();
+    runner.join();
+
+    server.Stop();
+    thr.join();
+}
+
+// Tests that when the connection cannot be made every queued command fails with the connect error.
+TEST(AsyncClientTest, FailedConnectFailsQueuedCommands)
+{
+    boost::asio::io_context io;
+    const auto endpoints = boost::asio::ip::tcp::resolver(io).resolve("127.0.0.1", std::to_string(random_port()));
+    auto session = AsyncClient::Create(io);
+    std::future<std::string> reply = session->Command("list_movies");
+    boost::system::error_code connect_error;
+    session->AsyncConnect(endpoints, [&](const boost::system::error_code& error) { connect_error = error; });
+    io.run();
+
+    EXPECT_EQ(connect_error, boost::asio::error::connection_refused);
+    EXPECT_FALSE(session->IsOpen());
+    EXPECT_THROW(reply.get(), boost::system::system_error);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <BinaryProtocol.hpp>
+
+using ::testing::ElementsAre;
+
+// Tests that a frame header survives encoding, including the patched length and status.
+TEST(BinaryProtocolTest, FrameHeaderRoundTrip)
+{
+    std::string out = "xy";                             // frames may follow other data
+    const std::size_t frame = BinaryProtocol::BeginFrame(out, 3 | BinaryProtocol::kResponseFlag, 0xdeadbeef);
+    BinaryProtocol::AppendU32(out, 7);
+    BinaryProtocol::EndFrame(out, frame, FrameStatus::Ok);
+    ASSERT_EQ(out.size(), 2 + BinaryProtocol::kHeaderSize + 4);
+    EXPECT_EQ(out[2], 4);                               // little-endian length
+
+    FrameHeader header;
+    ASSERT_TRUE(BinaryProtocol::DecodeHeader(std::string_view(out).substr(2), header));
+    EXPECT_EQ(header.length, 4u);
+    EXPECT_EQ(header.opcode, 3 | BinaryProtocol::kResponseFlag);
+    EXPECT_EQ(header.status, FrameStatus::Ok);
+    EXPECT_EQ(header.request_id, 0xdeadbeefu);
+    EXPECT_FALSE(BinaryProtocol::DecodeHeader(std::string_view(out).substr(0, 10), header));
+}
+
+// Tests that a failed response drops its partial payload.
+TEST(BinaryProtocolTest, ErrorFrameHasNoPayload)
+{
+    std::string out;
+    const std::size_t frame = BinaryProtocol::BeginFrame(out, 4, 1);
+    BinaryProtocol::AppendU32(out, 123);
+    BinaryProtocol::EndFrame(out, frame, FrameStatus::SeatsUnavailable);
+
+    FrameHeader header;
+    ASSERT_TRUE(BinaryProtocol::DecodeHeader(out, header));
+    EXPECT_EQ(out.size(), BinaryProtocol::kHeaderSize);
+    EXPECT_EQ(header.length, 0u);
+    EXPECT_EQ(header.status, FrameStatus::SeatsUnavailable);
+}
+
+// Tests seat bitmaps and name lists round trip, and that malformed input is rejected.
+TEST(BinaryProtocolTest, SeatBitmapAndNameListRoundTrip)
+{
+    std::string out;
+    BinaryProtocol::AppendSeatBitmap(out, { 1, 8, 9, 20, 21 }, 20);    // 21 is beyond the bitmap
+    BinaryProtocol::AppendNameList(out, { { 5, "Movie A" }, { 9, "" } });
+
+    FrameReader in(out);
+    std::vector<unsigned int> seats;
+    std::size_t bits = 0;
+    ASSERT_TRUE(BinaryProtocol::ReadSeatBitmap(in, seats, &bits));
+    EXPECT_EQ(bits, 20u);
+    EXPECT_THAT(seats, ElementsAre(1u, 8u, 9u, 20u));
+
+    std::vector<std::pair<std::uint32_t, std::string>> names;
+    ASSERT_TRUE(BinaryProtocol::ReadNameList(in, names));
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_EQ(names[0].first, 5u);
+    EXPECT_EQ(names[0].second, "Movie A");
+    EXPECT_TRUE(in.AtEnd());
+
+    // padding bit set past the bit count
+    std::string bad;
+    BinaryProtocol::AppendU32(bad, 3);
+    bad.push_back(static_cast<char>(0x08));
+    FrameReader badIn(bad);
+    EXPECT_FALSE(BinaryProtocol::ReadSeatBitmap(badIn, seats));
+
+    // truncated bitmap
+    FrameReader shortIn(std::string_view(out).substr(0, 5));
+    EXPECT_FALSE(BinaryProtocol::ReadSeatBitmap(shortIn, seats));
+    EXPECT_FALSE(shortIn.Ok());
+}
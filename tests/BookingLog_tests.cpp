@@ -0,0 +1,344 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <BinaryProtocol.hpp>
+#include <BookingLog.hpp>
+#include <MovieBooker.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using ::testing::ElementsAre;
+
+namespace
+{
+    // log file in the temp directory, removed when the test ends
+    struct TempLog
+    {
+        std::string path;
+        TempLog()
+        {
+            std::random_device rd;
+            path = (std::filesystem::temp_directory_path() / ("movie_booker_" + std::to_string(rd()) + ".wal")).string();
+        }
+        ~TempLog()
+        {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    };
+
+    struct Replayed
+    {
+        std::string movie, theater;
+        std::vector<unsigned int> seats;
+    };
+
+    std::vector<Replayed> replay_all(const std::string& path, LogReplayResult* result = nullptr)
+    {
+        std::vector<Replayed> out;
+        const LogReplayResult r = BookingLog::Replay(path,
+            [&](std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats) {
+                out.push_back({ std::string(movie), std::string(theater), seats });
+            });
+        if (result)
+            *result = r;
+        return out;
+    }
+
+    // the log's record checksum (crc-32, reflected 0xedb88320)
+    std::uint32_t crc32(std::string_view data)
+    {
+        std::uint32_t c = 0xffffffffu;
+        for (unsigned char b : data)
+        {
+            c ^= b;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        return c ^ 0xffffffffu;
+    }
+}
+
+// Tests that records written in every durability mode replay in order.
+TEST(BookingLogTest, RecordsReplayInEveryMode)
+{
+    for (Durability mode : { Durability::None, Durability::Group, Durability::Fsync })
+    {
+        TempLog file;
+        {
+            BookingLog log;
+            ASSERT_TRUE(log.Open(file.path, mode, std::chrono::milliseconds(1)));
+            const unsigned int a[] = { 1, 2 }, b[] = { 7 };
+            const LoggedBooking first[] = { { "Matrix", "Hall 1", a, 2 } };
+            const LoggedBooking batch[] = { { "Up", "Annex", b, 1 }, { "Matrix", "Hall 2", a, 2 } };
+            EXPECT_TRUE(log.Append(first, 1));
+            EXPECT_TRUE(log.Append(batch, 2));
+        }                                               // Close() writes what Group mode still buffers
+
+        LogReplayResult result;
+        const auto replayed = replay_all(file.path, &result);
+        EXPECT_TRUE(result.ok);
+        EXPECT_EQ(result.records, 2u);
+        EXPECT_FALSE(result.torn_tail);
+        ASSERT_EQ(replayed.size(), 3u);
+        EXPECT_EQ(replayed[0].movie, "Matrix");
+        EXPECT_EQ(replayed[0].theater, "Hall 1");
+        EXPECT_THAT(replayed[0].seats, ElementsAre(1u, 2u));
+        EXPECT_EQ(replayed[1].theater, "Annex");
+        EXPECT_EQ(replayed[2].theater, "Hall 2");
+    }
+}
+
+// Tests that a torn tail is ignored by replay and cut off when the log is reopened.
+TEST(BookingLogTest, TornTailIsDiscarded)
+{
+    TempLog file;
+    const unsigned int seats[] = { 3 };
+    const LoggedBooking booking[] = { { "Matrix", "Hall 1", seats, 1 } };
+    {
+        BookingLog log;
+        ASSERT_TRUE(log.Open(file.path, Durability::Fsync));
+        ASSERT_TRUE(log.Append(booking, 1));
+        ASSERT_TRUE(log.Append(booking, 1));
+    }
+    const auto size = std::filesystem::file_size(file.path);
+    std::filesystem::resize_file(file.path, size - 3);  // crash in the middle of the second record
+
+    LogReplayResult result;
+    EXPECT_EQ(replay_all(file.path, &result).size(), 1u);
+    EXPECT_TRUE(result.ok);
+    EXPECT_TRUE(result.torn_tail);
+
+    {
+        BookingLog log;
+        ASSERT_TRUE(log.Open(file.path, Durability::None));
+        ASSERT_TRUE(log.Append(booking, 1));
+    }
+    EXPECT_EQ(replay_all(file.path, &result).size(), 2u);
+    EXPECT_FALSE(result.torn_tail);
+
+    // a flipped byte fails the crc: replay stops before the damaged record
+    {
+        std::fstream f(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(-2, std::ios::end);
+        f.put('\x7f');
+    }
+    EXPECT_EQ(replay_all(file.path, &result).size(), 1u);
+    EXPECT_TRUE(result.torn_tail);
+}
+
+// Tests that a record whose crc matches but whose contents do not parse fails
+// replay and Open instead of being cut off with the intact records after it.
+TEST(BookingLogTest, MalformedRecordIsNotTruncated)
+{
+    TempLog file;
+    const unsigned int seats[] = { 3 };
+    const LoggedBooking booking[] = { { "Matrix", "Hall 1", seats, 1 } };
+    {
+        BookingLog log;
+        ASSERT_TRUE(log.Open(file.path, Durability::Fsync));
+        ASSERT_TRUE(log.Append(booking, 1));
+    }
+    const auto good = std::filesystem::file_size(file.path);
+    std::string intact(static_cast<std::size_t>(good), '\0');
+    std::ifstream(file.path, std::ios::binary).read(&intact[0], static_cast<std::streamsize>(good));
+    intact.erase(0, 16);                                // the file header
+    {
+        // one showing announced and none written, then a copy of the intact record
+        std::string body, record;
+        BinaryProtocol::AppendU32(body, 1);
+        BinaryProtocol::AppendU32(record, static_cast<std::uint32_t>(body.size()));
+        BinaryProtocol::AppendU32(record, crc32(body));
+        std::ofstream(file.path, std::ios::binary | std::ios::app) << record << body << intact;
+    }
+    const auto size = std::filesystem::file_size(file.path);
+    {
+        BookingLog log;
+        EXPECT_FALSE(log.Open(file.path, Durability::Fsync));
+    }
+    EXPECT_EQ(std::filesystem::file_size(file.path), size);
+
+    LogReplayResult result;
+    EXPECT_EQ(replay_all(file.path, &result).size(), 1u);
+    EXPECT_FALSE(result.ok);
+    EXPECT_TRUE(result.corrupt);
+    EXPECT_FALSE(result.torn_tail);
+    EXPECT_EQ(result.valid_bytes, good);
+}
+
+// Tests that replay seeks to its start offset without reading earlier records,
+// and that Open takes over the replayed state without reading the file again.
+TEST(BookingLogTest, ReplaySeeksToStartOffset)
+{
+    TempLog file;
+    const unsigned int a[] = { 1 }, b[] = { 2 };
+    const LoggedBooking first[] = { { "Matrix", "Hall 1", a, 1 } }, second[] = { { "Matrix", "Hall 1", b, 1 } };
+    std::uint64_t from = 0;
+    {
+        BookingLog log;
+        ASSERT_TRUE(log.Open(file.path, Durability::Fsync));
+        ASSERT_TRUE(log.Append(first, 1));
+        from = log.SyncedBytes();
+        ASSERT_TRUE(log.Append(second, 1));
+        EXPECT_EQ(log.SyncedBytes(), log.AppendedBytes());
+    }
+    {
+        // damage the first record's crc: replay from `from` never looks at it
+        std::fstream f(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(20);
+        f.put('\x7f');
+    }
+
+    std::vector<unsigned int> seats;
+    const LogReplayResult result = BookingLog::Replay(file.path,
+        [&](std::string_view, std::string_view, const std::vector<unsigned int>& s) { seats.insert(seats.end(), s.begin(), s.end()); }, from);
+    EXPECT_TRUE(result.ok);
+    EXPECT_FALSE(result.torn_tail);
+    EXPECT_EQ(result.records, 1u);
+    EXPECT_THAT(seats, ElementsAre(2u));
+    EXPECT_EQ(result.valid_bytes, std::filesystem::file_size(file.path));
+
+    BookingLog log;
+    ASSERT_TRUE(log.Open(file.path, Durability::Fsync, BookingLog::kDefaultGroupInterval, result));
+    EXPECT_EQ(log.AppendedBytes(), result.end);
+    ASSERT_TRUE(log.Append(first, 1));
+    log.Close();
+    EXPECT_EQ(BookingLog::Replay(file.path, BookingLog::ReplayCallback(), from).records, 2u);
+}
+
+// Tests that rotating drops the records before an offset, keeps offsets valid
+// for later appends and refuses replays that need the dropped records.
+TEST(BookingLogTest, RotateDropsRecordsBeforeOffset)
+{
+    TempLog file;
+    const unsigned int seats[] = { 1, 2, 3 };
+    std::vector<LoggedBooking> bookings;
+    for (unsigned int i = 0; i < 3; ++i)
+        bookings.push_back({ "Matrix", "Hall 1", seats + i, 1 });
+
+    BookingLog log;
+    ASSERT_TRUE(log.Open(file.path, Durability::Group));
+    ASSERT_TRUE(log.Append(&bookings[0], 1));
+    ASSERT_TRUE(log.Append(&bookings[1], 1));
+    const std::uint64_t snapshot = log.AppendedBytes();
+    ASSERT_TRUE(log.Append(&bookings[2], 1));
+    EXPECT_FALSE(log.Rotate(log.AppendedBytes() + 1));  // not appended yet
+    const auto before = std::filesystem::file_size(file.path);
+    ASSERT_TRUE(log.Rotate(snapshot));
+    EXPECT_TRUE(log.Rotate(snapshot));                  // nothing left to drop
+    EXPECT_LT(std::filesystem::file_size(file.path), before);
+    EXPECT_FALSE(std::filesystem::exists(file.path + ".tmp"));
+
+    const std::uint64_t end = log.AppendedBytes();
+    ASSERT_TRUE(log.Append(&bookings[0], 1));           // appends go to the rotated file
+    const std::uint64_t last = log.AppendedBytes();
+    EXPECT_GT(last, end);
+    log.Close();
+
+    std::vector<unsigned int> replayed;
+    const auto collect = [&](std::string_view, std::string_view, const std::vector<unsigned int>& s) { replayed.insert(replayed.end(), s.begin(), s.end()); };
+    LogReplayResult result = BookingLog::Replay(file.path, collect, snapshot);
+    EXPECT_TRUE(result.ok);
+    EXPECT_EQ(result.start, snapshot);
+    EXPECT_THAT(replayed, ElementsAre(3u, 1u));
+
+    replayed.clear();
+    EXPECT_EQ(BookingLog::Replay(file.path, collect, end).records, 1u);
+    EXPECT_THAT(replayed, ElementsAre(1u));
+
+    result = BookingLog::Replay(file.path, collect, 0);
+    EXPECT_FALSE(result.ok);
+    EXPECT_TRUE(result.rotated_past);
+    EXPECT_FALSE(log.Open(file.path, Durability::None, BookingLog::kDefaultGroupInterval, result));
+
+    ASSERT_TRUE(log.Open(file.path, Durability::None));  // a plain Open still works on a rotated log
+    EXPECT_EQ(log.AppendedBytes(), last);
+}
+
+// Tests that a file that is not a booking log is refused.
+TEST(BookingLogTest, ForeignFileIsRefused)
+{
+    TempLog file;
+    std::ofstream(file.path) << "{ \"movies\": [] }";
+    BookingLog log;
+    EXPECT_FALSE(log.Open(file.path, Durability::None));
+    EXPECT_FALSE(BookingLog::Replay(file.path, BookingLog::ReplayCallback()).ok);
+
+    TempLog missing;
+    EXPECT_TRUE(BookingLog::Replay(missing.path, BookingLog::ReplayCallback()).ok);
+}
+
+// Tests that concurrent fsync-mode appends share fsyncs (group commit).
+TEST(BookingLogTest, ConcurrentFsyncAppendsShareSyncs)
+{
+    TempLog file;
+    BookingLog log;
+    ASSERT_TRUE(log.Open(file.path, Durability::Fsync));
+
+    constexpr int kThreads = 8, kPerThread = 50;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kPerThread; ++i)
+            {
+                const unsigned int seat = static_cast<unsigned int>(t * kPerThread + i + 1);
+                const LoggedBooking booking[] = { { "Matrix", "Hall 1", &seat, 1 } };
+                EXPECT_TRUE(log.Append(booking, 1));
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_LE(log.SyncCount(), static_cast<std::uint64_t>(kThreads * kPerThread));
+    log.Close();
+
+    std::vector<unsigned int> seats;
+    for (const auto &r : replay_all(file.path))
+        seats.insert(seats.end(), r.seats.begin(), r.seats.end());
+    std::sort(seats.begin(), seats.end());
+    ASSERT_EQ(seats.size(), static_cast<std::size_t>(kThreads * kPerThread));
+    EXPECT_EQ(seats.front(), 1u);
+    EXPECT_EQ(seats.back(), static_cast<unsigned int>(kThreads * kPerThread));
+}
+
+// Tests that a booker restarted from its log ends up with the same seats booked.
+TEST(BookingLogTest, MovieBookerStateSurvivesRestart)
+{
+    TempLog file;
+    auto load = [](MovieBooker& mb) {
+        mb.AddMovie("Matrix", {"Hall 1", "Hall 2"});
+        mb.AddMovie("Up", {"Hall 1"});
+    };
+    {
+        MovieBooker mb;
+        load(mb);
+        BookingLog log;
+        ASSERT_TRUE(log.Open(file.path, Durability::Group));
+        mb.SetBookingLog(&log);
+
+        const auto matrix = *mb.ResolveMovie("Matrix"), up = *mb.ResolveMovie("Up");
+        const auto hall1 = *mb.ResolveTheater("Hall 1"), hall2 = *mb.ResolveTheater("Hall 2");
+        ASSERT_TRUE(mb.BookSeats("Hall 1", "Matrix", {1, 2}));
+        EXPECT_FALSE(mb.BookSeats("Hall 1", "Matrix", {2}));            // failed bookings are not logged
+        ASSERT_TRUE(mb.BookBatch({ {*mb.ResolveShowing(matrix, hall2), {5}}, {*mb.ResolveShowing(up, hall1), {6, 7}} }));
+        std::vector<unsigned int> best;
+        ASSERT_TRUE(mb.BookBest(*mb.ResolveShowing(up, hall1), 3, true, best));
+        const auto hold = mb.HoldSeats(*mb.ResolveShowing(matrix, hall2), {10}, std::chrono::seconds(60));
+        const auto confirmed = mb.HoldSeats(*mb.ResolveShowing(matrix, hall2), {11}, std::chrono::seconds(60));
+        ASSERT_TRUE(hold && confirmed);
+        ASSERT_TRUE(mb.ConfirmHold(*confirmed));
+    }                                                   // open holds are not logged
+
+    MovieBooker restarted;
+    load(restarted);
+    const LogReplayResult result = BookingLog::Replay(file.path,
+        [&](std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats) {
+            EXPECT_TRUE(restarted.BookSeats(std::string(theater), std::string(movie), seats));
+        });
+    EXPECT_EQ(result.records, 4u);
+    EXPECT_THAT(restarted.GetFreeSeats("Hall 1", "Matrix").front(), 3u);
+    EXPECT_EQ(restarted.GetFreeSeats("Hall 1", "Matrix").size(), 18u);
+    EXPECT_EQ(restarted.GetFreeSeats("Hall 2", "Matrix").size(), 18u);   // 5 and the confirmed 11
+    EXPECT_EQ(restarted.GetFreeSeats("Hall 1", "Up").size(), 15u);       // 6, 7 and the best 1..3
+}
@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <MovieBooker.hpp>
+#include <BookingLog.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using ::testing::ElementsAre;
+
+namespace
+{
+    // file in the temp directory, removed when the test ends
+    struct TempFile
+    {
+        std::string path;
+        explicit TempFile(const char* extension)
+        {
+            std::random_device rd;
+            path = (std::filesystem::temp_directory_path() / ("movie_booker_" + std::to_string(rd()) + extension)).string();
+        }
+        ~TempFile()
+        {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    };
+}
+
+// Tests that a snapshot restores theaters, movies, ids and booked seats, but not holds.
+TEST(CatalogSnapshotTest, SnapshotRestoresCatalogAndSeats)
+{
+    TempFile file(".snap");
+    MovieBooker mb;
+    mb.AddTheater("IMAX", 100);
+    mb.AddTheater("Empty Hall", 5);
+    mb.AddMovie("Matrix", {"Hall 1", "IMAX"});
+    mb.AddMovie("Up", {"IMAX"});
+    ASSERT_TRUE(mb.BookSeats("IMAX", "Matrix", {1, 64, 65, 100}));
+    ASSERT_TRUE(mb.BookSeats("Hall 1", "Matrix", {20}));
+    const auto up = *mb.ResolveShowing(*mb.ResolveMovie("Up"), *mb.ResolveTheater("IMAX"));
+    ASSERT_TRUE(mb.HoldSeats(up, {7}, std::chrono::seconds(60)));
+    ASSERT_TRUE(mb.WriteSnapshot(file.path, 1234));
+    EXPECT_FALSE(std::filesystem::exists(file.path + ".tmp"));
+
+    MovieBooker restored;
+    restored.AddMovie("Stale", {"Old Hall"});                   // replaced by the snapshot
+    std::uint64_t offset = 0;
+    ASSERT_TRUE(restored.LoadSnapshot(file.path, offset));
+    EXPECT_EQ(offset, 1234u);
+
+    EXPECT_THAT(restored.GetMovieList(), ::testing::UnorderedElementsAreArray(mb.GetMovieList()));
+    EXPECT_EQ(restored.ResolveTheater("Empty Hall"), mb.ResolveTheater("Empty Hall"));
+    EXPECT_EQ(restored.ResolveShowing(*restored.ResolveMovie("Up"), *restored.ResolveTheater("IMAX")), up);
+    EXPECT_FALSE(restored.ResolveMovie("Stale").has_value());
+    EXPECT_EQ(restored.GetSeatCount(up), 100u);
+    EXPECT_EQ(restored.GetFreeSeats("IMAX", "Matrix"), mb.GetFreeSeats("IMAX", "Matrix"));
+    EXPECT_EQ(restored.GetFreeSeats("Hall 1", "Matrix").size(), 19u);
+    EXPECT_EQ(restored.GetFreeSeats(up).size(), 100u);                    // the hold was not persisted
+    EXPECT_FALSE(restored.BookSeats("IMAX", "Matrix", {65}));
+    EXPECT_TRUE(restored.BookSeats("IMAX", "Matrix", {66}));
+    EXPECT_TRUE(restored.AddMovie("Later", {"Empty Hall"}));             // the restored catalog takes changes
+    EXPECT_EQ(restored.GetFreeSeats("Empty Hall", "Later").size(), 5u);
+}
+
+// Tests that showings and movies removed by a reload stay removed, and their ids unused, after a restore.
+TEST(CatalogSnapshotTest, SnapshotKeepsReloadRemovals)
+{
+    TempFile file(".snap");
+    MovieBooker mb;
+    mb.AddMovie("Matrix", {"Hall 1", "Hall 2"});
+    mb.AddMovie("Up", {"Hall 1"});
+    const auto matrix = *mb.ResolveMovie("Matrix"), up = *mb.ResolveMovie("Up");
+    const auto removed = *mb.ResolveShowing(matrix, *mb.ResolveTheater("Hall 1"));
+    const auto kept = *mb.ResolveShowing(matrix, *mb.ResolveTheater("Hall 2"));
+    ASSERT_TRUE(mb.BookSeats(kept, {3}));
+    IMovieBooker::CatalogChunk chunk;
+    chunk.movies = { {"Matrix", {"Hall 2"}} };
+    mb.ReplaceCatalog(chunk);
+    ASSERT_TRUE(mb.WriteSnapshot(file.path, 0));
+
+    MovieBooker restored;
+    std::uint64_t offset = 0;
+    ASSERT_TRUE(restored.LoadSnapshot(file.path, offset));
+    EXPECT_THAT(restored.GetMovies(), ElementsAre("Matrix"));
+    EXPECT_FALSE(restored.ResolveMovie("Up"));
+    EXPECT_EQ(restored.ResolveShowing(matrix, *restored.ResolveTheater("Hall 2")), kept);
+    EXPECT_EQ(restored.GetFreeSeats(kept).size(), 19u);
+    EXPECT_EQ(restored.GetSeatCount(removed), 0u);
+
+    chunk.movies.push_back({ "Up", {"Hall 1"} });               // a returning movie keeps its id
+    restored.ReplaceCatalog(chunk);
+    EXPECT_EQ(restored.ResolveMovie("Up"), up);
+    ASSERT_TRUE(restored.WriteSnapshot(file.path, 0));
+    EXPECT_TRUE(restored.LoadSnapshot(file.path, offset));
+}
+
+// Tests that missing, foreign and damaged snapshots are refused and leave the catalog alone.
+TEST(CatalogSnapshotTest, InvalidSnapshotsAreRefused)
+{
+    TempFile file(".snap");
+    MovieBooker mb;
+    mb.AddMovie("Matrix", {"Hall 1", "Hall 2"});
+    ASSERT_TRUE(mb.WriteSnapshot(file.path, 0));
+    const auto size = std::filesystem::file_size(file.path);
+
+    MovieBooker target;
+    target.AddMovie("Up", {"Annex"});
+    std::uint64_t offset = 0;
+
+    TempFile missing(".snap");
+    EXPECT_FALSE(target.LoadSnapshot(missing.path, offset));
+
+    std::filesystem::resize_file(file.path, size - 1);          // strings cut short
+    EXPECT_FALSE(target.LoadSnapshot(file.path, offset));
+
+    TempFile foreign(".snap");
+    std::ofstream(foreign.path) << std::string(100, 'x');
+    EXPECT_FALSE(target.LoadSnapshot(foreign.path, offset));
+
+    // a showing pointing at a theater that does not exist
+    ASSERT_TRUE(mb.WriteSnapshot(file.path, 0));
+    {
+        std::fstream f(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint32_t badTheater = 99;
+        f.seekp(56 + 2 * 16 + 16 + 4);                  // header, 2 theaters, 1 movie, theater of showing 0
+        f.write(reinterpret_cast<const char*>(&badTheater), sizeof(badTheater));
+    }
+    EXPECT_FALSE(target.LoadSnapshot(file.path, offset));
+
+    EXPECT_THAT(target.GetMovies(), ElementsAre("Up"));
+}
+
+// Tests that a snapshot taken during bookings plus the log from its offset restores every booking.
+TEST(CatalogSnapshotTest, SnapshotAndLogTailRestoreConcurrentBookings)
+{
+    TempFile snapshot(".snap"), wal(".wal");
+    constexpr unsigned int kSeats = 2000;
+    {
+        MovieBooker mb;
+        mb.AddTheater("Arena", kSeats);
+        mb.AddMovie("Matrix", {"Arena"});
+        BookingLog log;
+        ASSERT_TRUE(log.Open(wal.path, Durability::Group));
+        mb.SetBookingLog(&log);
+        mb.EnableConcurrentSnapshots();
+
+        std::atomic<bool> done{ false };
+        std::thread snapshotter([&]() {
+            while (!done.load())
+                EXPECT_TRUE(mb.WriteSnapshot(snapshot.path, log.AppendedBytes()));
+        });
+        std::vector<std::thread> bookers;
+        for (unsigned int t = 0; t < 4; ++t)
+            bookers.emplace_back([&, t]() {
+                for (unsigned int seat = t + 1; seat <= kSeats; seat += 4)
+                    EXPECT_TRUE(mb.BookSeats("Arena", "Matrix", {seat}));
+            });
+        for (auto &thread : bookers)
+            thread.join();
+        done = true;
+        snapshotter.join();
+    }
+
+    MovieBooker restarted;
+    std::uint64_t offset = 0;
+    ASSERT_TRUE(restarted.LoadSnapshot(snapshot.path, offset));
+    const std::size_t inSnapshot = kSeats - restarted.GetFreeSeats("Arena", "Matrix").size();
+    std::size_t applied = 0;
+    const LogReplayResult result = BookingLog::Replay(wal.path,
+        [&](std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats) {
+            applied += restarted.BookSeats(std::string(theater), std::string(movie), seats);
+        }, offset);
+    EXPECT_TRUE(result.ok);
+    EXPECT_LE(applied, result.records);                 // records before the offset were skipped
+    EXPECT_EQ(inSnapshot + applied, kSeats);
+    EXPECT_TRUE(restarted.GetFreeSeats("Arena", "Matrix").empty());
+}
+
+// Tests that seats which are only held, or claimed and rolled back, never reach
+// a snapshot taken while holds come and go and a batch keeps failing.
+TEST(CatalogSnapshotTest, SnapshotSkipsHoldsAndRolledBackClaimsInProgress)
+{
+    TempFile snapshot(".snap");
+    MovieBooker mb;
+    mb.AddTheater("Arena", 200);
+    mb.AddMovie("Matrix", {"Arena"});
+    mb.AddMovie("Up", {"Arena"});
+    mb.EnableConcurrentSnapshots();
+    const auto arena = *mb.ResolveTheater("Arena");
+    const auto matrix = *mb.ResolveShowing(*mb.ResolveMovie("Matrix"), arena);
+    const auto up = *mb.ResolveShowing(*mb.ResolveMovie("Up"), arena);
+    ASSERT_TRUE(mb.BookSeats(up, {150}));              // makes every batch below fail on its second showing
+
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> writers;
+    writers.emplace_back([&]() {
+        const std::vector<unsigned int> seats = { 10, 63, 64, 65, 130 };    // three words
+        while (!done)
+            if (const auto hold = mb.HoldSeats(matrix, seats, std::chrono::seconds(60)))
+                mb.ReleaseHold(*hold);
+    });
+    writers.emplace_back([&]() {
+        while (!done)
+            EXPECT_FALSE(mb.BookBatch({ { matrix, {1, 2, 100} }, { up, {150} } }));
+    });
+
+    for (int i = 0; i < 200; ++i)
+    {
+        ASSERT_TRUE(mb.WriteSnapshot(snapshot.path, 0));
+        MovieBooker restored;
+        std::uint64_t offset = 0;
+        ASSERT_TRUE(restored.LoadSnapshot(snapshot.path, offset));
+        ASSERT_EQ(restored.GetFreeSeats(matrix).size(), 200u) << "snapshot " << i;
+        ASSERT_EQ(restored.GetFreeSeats(up).size(), 199u);
+    }
+    done = true;
+    for (auto &thread : writers)
+        thread.join();
+}
+
+// Tests that a logged booking spanning words that a snapshot holds only in part
+// is completed by the replay, and that replaying it again changes nothing.
+TEST(CatalogSnapshotTest, ReplayCompletesBookingsPartlyInSnapshot)
+{
+    TempFile snapshot(".snap"), wal(".wal");
+    const std::vector<unsigned int> spanning = { 60, 63, 64, 65, 128, 129 };    // words 0, 1 and 2
+    std::uint64_t offset = 0;
+    {
+        MovieBooker mb;
+        mb.AddTheater("Arena", 200);
+        mb.AddMovie("Matrix", {"Arena"});
+        BookingLog log;
+        ASSERT_TRUE(log.Open(wal.path, Durability::Fsync));
+        offset = log.AppendedBytes();
+        mb.SetBookingLog(&log);
+        ASSERT_TRUE(mb.BookSeats("Arena", "Matrix", spanning));
+        ASSERT_TRUE(mb.BookSeats("Arena", "Matrix", {5}));
+    }
+    {
+        // the state a snapshot copying the first word mid-claim would have seen
+        MovieBooker mb;
+        mb.AddTheater("Arena", 200);
+        mb.AddMovie("Matrix", {"Arena"});
+        ASSERT_TRUE(mb.BookSeats("Arena", "Matrix", {60, 63}));
+        ASSERT_TRUE(mb.WriteSnapshot(snapshot.path, offset));
+    }
+
+    MovieBooker restarted;
+    std::uint64_t from = 0;
+    ASSERT_TRUE(restarted.LoadSnapshot(snapshot.path, from));
+    auto replay = [&]() {
+        return BookingLog::Replay(wal.path,
+            [&](std::string_view movie, std::string_view theater, const std::vector<unsigned int>& seats) {
+                EXPECT_TRUE(restarted.RestoreSeats(std::string(theater), std::string(movie), seats));
+            }, from);
+    };
+    EXPECT_EQ(replay().records, 2u);
+    std::vector<unsigned int> expected = { 5 };
+    expected.insert(expected.end(), spanning.begin(), spanning.end());
+    const auto booked = [&]() {
+        std::vector<unsigned int> result;
+        const auto free = restarted.GetFreeSeats("Arena", "Matrix");
+        for (unsigned int seat = 1; seat <= 200; ++seat)
+            if (std::find(free.begin(), free.end(), seat) == free.end())
+                result.push_back(seat);
+        return result;
+    };
+    EXPECT_EQ(booked(), expected);
+
+    EXPECT_EQ(replay().records, 2u);                    // idempotent
+    EXPECT_EQ(booked(), expected);
+    EXPECT_FALSE(restarted.RestoreSeats("Nowhere", "Matrix", {1}));
+}
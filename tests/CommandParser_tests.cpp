@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <CommandParser.hpp>
+
+using ::testing::ElementsAre;
+
+// Tests that command words are matched case-insensitively and unknown words are rejected.
+TEST(CommandParserTest, LookupMatchesCommands)
+{
+    EXPECT_EQ(CommandParser::Lookup("list_movies"), Command::ListMovies);
+    EXPECT_EQ(CommandParser::Lookup("SELECT_MOVIE"), Command::SelectMovie);
+    EXPECT_EQ(CommandParser::Lookup("List_Theaters"), Command::ListTheaters);
+    EXPECT_EQ(CommandParser::Lookup("select_theater"), Command::SelectTheater);
+    EXPECT_EQ(CommandParser::Lookup("get_free_seats"), Command::GetFreeSeats);
+    EXPECT_EQ(CommandParser::Lookup("book_seats"), Command::BookSeats);
+    EXPECT_EQ(CommandParser::Lookup("Binary"), Command::Binary);
+
+    EXPECT_EQ(CommandParser::Lookup("book_seat"), Command::Unknown);
+    EXPECT_EQ(CommandParser::Lookup("set_free_seats"), Command::Unknown);    // same length as get_free_seats
+    EXPECT_EQ(CommandParser::Lookup(""), Command::Unknown);
+}
+
+// Tests that the argument is the rest of the line with surrounding blanks and '\r' removed.
+TEST(CommandParserTest, ParseSplitsCommandAndArgument)
+{
+    ParsedCommand parsed = CommandParser::Parse("  select_movie   The Matrix  \r");
+    EXPECT_EQ(parsed.command, Command::SelectMovie);
+    EXPECT_EQ(parsed.argument, "The Matrix");
+
+    parsed = CommandParser::Parse("list_movies\r");
+    EXPECT_EQ(parsed.command, Command::ListMovies);
+    EXPECT_TRUE(parsed.argument.empty());
+
+    EXPECT_EQ(CommandParser::Parse("").command, Command::Unknown);
+    EXPECT_EQ(CommandParser::Parse(" \r").command, Command::Unknown);
+    EXPECT_EQ(CommandParser::Parse("hello world").command, Command::Unknown);
+}
+
+// Tests seat list parsing, including blanks after commas and trailing garbage.
+TEST(CommandParserTest, ParseSeatsAcceptsLists)
+{
+    std::vector<unsigned int> seats;
+    EXPECT_EQ(CommandParser::ParseSeats("1,2,3", 20, seats), SeatListStatus::Ok);
+    EXPECT_THAT(seats, ElementsAre(1u, 2u, 3u));
+
+    EXPECT_EQ(CommandParser::ParseSeats(" 4, 5 ,6", 20, seats), SeatListStatus::Ok);
+    EXPECT_THAT(seats, ElementsAre(4u, 5u));                // the list ends at the first non-comma
+
+    EXPECT_EQ(CommandParser::ParseSeats("7,8abc", 20, seats), SeatListStatus::Ok);
+    EXPECT_THAT(seats, ElementsAre(7u, 8u));
+}
+
+// Tests the error statuses of seat list parsing.
+TEST(CommandParserTest, ParseSeatsRejectsInvalidLists)
+{
+    std::vector<unsigned int> seats;
+    EXPECT_EQ(CommandParser::ParseSeats("", 20, seats), SeatListStatus::Empty);
+    EXPECT_EQ(CommandParser::ParseSeats("abc", 20, seats), SeatListStatus::Empty);
+    EXPECT_EQ(CommandParser::ParseSeats("0", 20, seats), SeatListStatus::OutOfRange);
+    EXPECT_EQ(CommandParser::ParseSeats("-1", 20, seats), SeatListStatus::OutOfRange);
+    EXPECT_EQ(CommandParser::ParseSeats("1,21", 20, seats), SeatListStatus::OutOfRange);
+    EXPECT_TRUE(seats.empty());
+    EXPECT_EQ(CommandParser::ParseSeats("99999999999999999999999", 20, seats), SeatListStatus::OutOfRange);
+    EXPECT_EQ(CommandParser::ParseSeats("1,2,1", 2, seats), SeatListStatus::TooMany);
+    EXPECT_TRUE(seats.empty());
+}
+
+// Tests splitting a book_batch argument into items and item fields.
+TEST(CommandParserTest, BatchItemsAreSplit)
+{
+    EXPECT_EQ(CommandParser::Lookup("book_batch"), Command::BookBatch);
+
+    std::string_view rest = " The Matrix | Hall 1 | 1,2 ;; Up|Annex|3; ", item, movie, theater, seats;
+    ASSERT_TRUE(CommandParser::NextBatchItem(rest, item));
+    ASSERT_TRUE(CommandParser::SplitBatchItem(item, movie, theater, seats));
+    EXPECT_EQ(movie, "The Matrix");
+    EXPECT_EQ(theater, "Hall 1");
+    EXPECT_EQ(seats, "1,2");
+
+    ASSERT_TRUE(CommandParser::NextBatchItem(rest, item));     // the empty item is skipped
+    EXPECT_EQ(item, "Up|Annex|3");
+    EXPECT_FALSE(CommandParser::NextBatchItem(rest, item));
+
+    EXPECT_FALSE(CommandParser::SplitBatchItem("Up|Annex", movie, theater, seats));
+    EXPECT_FALSE(CommandParser::SplitBatchItem("Up|Annex|3|4", movie, theater, seats));
+    EXPECT_FALSE(CommandParser::SplitBatchItem("Up||3", movie, theater, seats));
+}
+
+// Tests the hold commands and parsing of their numeric ids.
+TEST(CommandParserTest, HoldCommandsAndIds)
+{
+    EXPECT_EQ(CommandParser::Lookup("hold_seats"), Command::HoldSeats);
+    EXPECT_EQ(CommandParser::Lookup("Confirm_Hold"), Command::ConfirmHold);
+    EXPECT_EQ(CommandParser::Lookup("release_hold"), Command::ReleaseHold);
+    EXPECT_EQ(CommandParser::Lookup("select_hold"), Command::Unknown);
+    EXPECT_EQ(CommandParser::Lookup("select_movie"), Command::SelectMovie);
+
+    std::uint64_t id = 0;
+    EXPECT_TRUE(CommandParser::ParseNumber("4294967297", id));
+    EXPECT_EQ(id, 4294967297ull);
+    EXPECT_FALSE(CommandParser::ParseNumber("", id));
+    EXPECT_FALSE(CommandParser::ParseNumber("12x", id));
+    EXPECT_FALSE(CommandParser::ParseNumber("-1", id));
+    EXPECT_FALSE(CommandParser::ParseNumber("99999999999999999999", id));
+}
+
+// Tests parsing of book_best arguments.
+TEST(CommandParserTest, BestRequestsAreParsed)
+{
+    EXPECT_EQ(CommandParser::Lookup("BOOK_BEST"), Command::BookBest);
+
+    std::uint64_t count = 0;
+    bool contiguous = true;
+    EXPECT_TRUE(CommandParser::ParseBestRequest("4", count, contiguous));
+    EXPECT_EQ(count, 4u);
+    EXPECT_FALSE(contiguous);
+    EXPECT_TRUE(CommandParser::ParseBestRequest("12  Contiguous ", count, contiguous));
+    EXPECT_EQ(count, 12u);
+    EXPECT_TRUE(contiguous);
+
+    EXPECT_FALSE(CommandParser::ParseBestRequest("", count, contiguous));
+    EXPECT_FALSE(CommandParser::ParseBestRequest("four", count, contiguous));
+    EXPECT_FALSE(CommandParser::ParseBestRequest("4 together", count, contiguous));
+}
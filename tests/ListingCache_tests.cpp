@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <ListingCache.hpp>
+#include <MovieBooker.hpp>
+#include <thread>
+#include <vector>
+
+// Tests that listings are formatted like the server's replies, empty lists included.
+TEST(ListingCacheTest, FormatsReplies)
+{
+    MovieBooker booker;
+    ListingCache cache(booker);
+    EXPECT_EQ(*cache.Movies(), "No movies running\n");
+
+    booker.AddMovie("Film", {"Hall", "Annex"});
+    const auto film = *booker.ResolveMovie("Film");
+    EXPECT_EQ(*cache.Movies(), "Film,\n");
+    const std::string theaters = *cache.Theaters(film);
+    EXPECT_TRUE(theaters == "Hall,Annex,\n" || theaters == "Annex,Hall,\n") << theaters;
+
+    EXPECT_EQ(ListingCache::Format({}, "none\n"), "none\n");
+    EXPECT_EQ(ListingCache::Format({ "a", "b c" }, "none\n"), "a,b c,\n");
+}
+
+// Tests that a listing is shared until the catalog version changes, and rebuilt after AddMovie.
+TEST(ListingCacheTest, SharedUntilCatalogChanges)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    const auto film = *booker.ResolveMovie("Film");
+    ListingCache cache(booker);
+
+    const auto movies = cache.Movies();
+    const auto theaters = cache.Theaters(film);
+    EXPECT_EQ(cache.Movies(), movies);                  // the same buffer, not a copy
+    EXPECT_EQ(cache.Theaters(film), theaters);
+    EXPECT_EQ(cache.GetVersion(), booker.GetCatalogVersion());
+
+    // bookings do not touch the catalog
+    const auto showing = *booker.ResolveShowing(film, *booker.ResolveTheater("Hall"));
+    ASSERT_TRUE(booker.BookSeats(showing, {1}));
+    EXPECT_EQ(cache.Movies(), movies);
+
+    ASSERT_TRUE(booker.AddMovie("Sequel", {"Hall", "Annex"}));
+    const auto after = cache.Movies();
+    EXPECT_NE(after, movies);
+    EXPECT_NE(after->find("Sequel,"), std::string::npos);
+    EXPECT_EQ(*movies, "Film,\n");                      // a buffer handed out earlier stays valid
+    EXPECT_EQ(cache.GetVersion(), booker.GetCatalogVersion());
+
+    ASSERT_TRUE(booker.AddMovie("Film", {"Hall", "Annex"}));
+    const std::string rebuilt = *cache.Theaters(film);
+    EXPECT_NE(rebuilt.find("Annex,"), std::string::npos);
+}
+
+// Tests that sessions on several threads get the same buffer while movies are added.
+TEST(ListingCacheTest, ConcurrentReadersDuringAddMovie)
+{
+    MovieBooker booker;
+    booker.AddMovie("Film", {"Hall"});
+    ListingCache cache(booker);
+
+    constexpr int kMovies = 50;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+        readers.emplace_back([&cache]() {
+            for (int i = 0; i < 2000; ++i)
+            {
+                const auto movies = cache.Movies();
+                ASSERT_NE(movies->find("Film,"), std::string::npos);
+                ASSERT_EQ(movies->back(), '\n');
+            }
+        });
+    for (int m = 0; m < kMovies; ++m)
+        booker.AddMovie("Movie " + std::to_string(m), {"Hall"});
+    for (auto &reader : readers)
+        reader.join();
+
+    // once writers are done, the next request sees every movie
+    const std::string movies = *cache.Movies();
+    for (int m = 0; m < kMovies; ++m)
+        EXPECT_NE(movies.find("Movie " + std::to_string(m) + ","), std::string::npos);
+}
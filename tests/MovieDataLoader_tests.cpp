@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <MovieDataLoader.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+namespace
+{
+    // JSON file in the temp directory, removed when the test ends
+    struct TempJson
+    {
+        std::string path;
+        explicit TempJson(const std::string& content)
+        {
+            std::random_device rd;
+            path = (std::filesystem::temp_directory_path() / ("movie_booker_" + std::to_string(rd()) + ".json")).string();
+            std::ofstream(path, std::ios::binary) << content;
+        }
+        ~TempJson()
+        {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    };
+
+    // directory of catalog files in the temp directory, removed when the test ends
+    struct TempDir
+    {
+        std::filesystem::path path;
+        TempDir()
+        {
+            std::random_device rd;
+            path = std::filesystem::temp_directory_path() / ("movie_booker_" + std::to_string(rd()));
+            std::filesystem::create_directory(path);
+        }
+        ~TempDir()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+        std::string Write(const std::string& name, const std::string& content) const
+        {
+            const std::string file = (path / name).string();
+            std::ofstream(file, std::ios::binary) << content;
+            return file;
+        }
+    };
+}
+
+// Tests that the streaming loader builds the same catalog as the DOM loader, skipping what it does not understand.
+TEST(MovieDataLoaderTest, StreamingMatchesDomLoader)
+{
+    TempJson file(R"({
+        "version": { "major": 2, "tags": ["a", {"b": []}] },
+        "theaters": [
+            { "name": "IMAX", "seats": 300, "screen": { "w": 20 } },
+            { "name": "Broken", "seats": -5 },
+            { "name": "Zero", "seats": 0 },
+            "not a theater"
+        ],
+        "movies": [
+            { "title": "Matrix", "theaters": ["IMAX", "Hall 1", 7, {"x": 1}], "rating": 8.7 },
+            { "theaters": ["Hall 2"] },
+            { "title": "Empty", "theaters": [] },
+            { "title": "Up", "theaters": "IMAX" },
+            { "title": "Dune", "year": null, "theaters": ["Zero"] },
+            42
+        ]
+    })");
+
+    MovieBooker dom, streamed;
+    ASSERT_TRUE(MovieDataLoader::LoadFromFile(file.path, dom));
+    CatalogLoadError error;
+    ASSERT_TRUE(MovieDataLoader::StreamFromFile(file.path, streamed, &error)) << error.message;
+
+    EXPECT_THAT(streamed.GetMovies(), UnorderedElementsAre("Matrix", "Dune"));
+    EXPECT_THAT(streamed.GetMovies(), ::testing::UnorderedElementsAreArray(dom.GetMovies()));
+    EXPECT_THAT(streamed.GetTheatersForMovie("Matrix"), UnorderedElementsAre("IMAX", "Hall 1"));
+    EXPECT_EQ(streamed.GetFreeSeats("IMAX", "Matrix").size(), 300u);
+    EXPECT_EQ(streamed.GetFreeSeats("Hall 1", "Matrix").size(), dom.GetFreeSeats("Hall 1", "Matrix").size());
+    EXPECT_EQ(streamed.GetFreeSeats("Zero", "Dune").size(), MovieBooker::kDefaultSeatsPerTheater);
+    EXPECT_FALSE(streamed.IsTheater("Broken"));
+}
+
+// Tests that syntax errors are reported with their line and column.
+TEST(MovieDataLoaderTest, SyntaxErrorsReportLineAndColumn)
+{
+    TempJson file("{\n  \"movies\": [\n    { \"title\": \"Matrix\", \"theaters\": [\"Hall 1\"] },\n    { \"title\" \"Up\" }\n  ]\n}\n");
+    MovieBooker mb;
+    CatalogLoadError error;
+    EXPECT_FALSE(MovieDataLoader::StreamFromFile(file.path, mb, &error));
+    EXPECT_EQ(error.line, 4u);
+    EXPECT_EQ(error.column, 15u);                               // where the colon is missing
+    EXPECT_FALSE(error.message.empty());
+    EXPECT_THAT(mb.GetMovies(), UnorderedElementsAre("Matrix")); // read before the error
+}
+
+// Tests that files that are not catalogs are refused with a reason.
+TEST(MovieDataLoaderTest, NonCatalogsAreRefused)
+{
+    for (const char* content : { "[1, 2]", "{ \"movies\": {} }", "{ \"theaters\": [] }", "" })
+    {
+        TempJson file(content);
+        MovieBooker mb;
+        CatalogLoadError error;
+        EXPECT_FALSE(MovieDataLoader::StreamFromFile(file.path, mb, &error)) << content;
+        EXPECT_FALSE(error.message.empty()) << content;
+        EXPECT_EQ(error.line, 1u) << content;
+        EXPECT_FALSE(MovieDataLoader::LoadFromFile(file.path, mb)) << content;
+    }
+
+    MovieBooker mb;
+    CatalogLoadError error;
+    EXPECT_FALSE(MovieDataLoader::StreamFromFile("/nonexistent/movies.json", mb, &error));
+    EXPECT_EQ(error.line, 0u);
+}
+
+// Tests that a directory or glob expands to its matching files in sorted order.
+TEST(MovieDataLoaderTest, PathsExpandSorted)
+{
+    TempDir dir;
+    const std::string b = dir.Write("b.json", "{}"), a = dir.Write("a.json", "{}"), c = dir.Write("c1.txt", "{}");
+    std::filesystem::create_directory(dir.path / "sub.json");
+
+    EXPECT_THAT(MovieDataLoader::ExpandPaths(dir.path.string()), ElementsAre(a, b));
+    EXPECT_THAT(MovieDataLoader::ExpandPaths((dir.path / "*").string()), ElementsAre(a, b, c));
+    EXPECT_THAT(MovieDataLoader::ExpandPaths((dir.path / "?1.*").string()), ElementsAre(c));
+    EXPECT_TRUE(MovieDataLoader::ExpandPaths((dir.path / "*.xml").string()).empty());
+    EXPECT_THAT(MovieDataLoader::ExpandPaths(a), ElementsAre(a));
+}
+
+// Tests that files loaded in parallel give the same ids whatever the thread count.
+TEST(MovieDataLoaderTest, ParallelLoadIsDeterministic)
+{
+    TempDir dir;
+    std::vector<std::string> paths;
+    for (int f = 0; f < 8; ++f)
+    {
+        std::string movies;
+        for (int m = 0; m < 20; ++m)
+            movies += std::string(m ? "," : "") + "{ \"title\": \"M" + std::to_string(f * 20 + m)
+                + "\", \"theaters\": [\"T" + std::to_string((f * 7 + m) % 13) + "\", \"T" + std::to_string(m % 5) + "\"] }";
+        paths.push_back(dir.Write("part" + std::to_string(f) + ".json", "{ \"movies\": [" + movies + "] }"));
+    }
+    dir.Write("sizes.json", R"({ "theaters": [ { "name": "T3", "seats": 64 } ], "movies": [] })");
+    paths = MovieDataLoader::ExpandPaths(dir.path.string());
+    ASSERT_EQ(paths.size(), 9u);
+
+    MovieBooker reference;
+    std::vector<CatalogLoadError> errors;
+    ASSERT_TRUE(MovieDataLoader::LoadFiles(paths, 1, reference, errors));
+    EXPECT_EQ(reference.GetFreeSeats("T3", "M3").size(), 64u);     // declared in a later file
+    for (unsigned int threads : { 2u, 4u, 16u })
+    {
+        MovieBooker mb;
+        ASSERT_TRUE(MovieDataLoader::LoadFiles(paths, threads, mb, errors));
+        for (int m = 0; m < 160; ++m)
+        {
+            const std::string movie = "M" + std::to_string(m);
+            ASSERT_EQ(mb.ResolveMovie(movie), reference.ResolveMovie(movie)) << movie;
+            for (const auto &theater : reference.GetTheatersForMovie(movie))
+                EXPECT_EQ(mb.ResolveShowing(*mb.ResolveMovie(movie), *mb.ResolveTheater(theater)),
+                          reference.ResolveShowing(*reference.ResolveMovie(movie), *reference.ResolveTheater(theater)));
+        }
+        for (int t = 0; t < 13; ++t)
+            EXPECT_EQ(mb.ResolveTheater("T" + std::to_string(t)), reference.ResolveTheater("T" + std::to_string(t)));
+    }
+    EXPECT_TRUE(errors.empty());
+}
+
+// Tests that a failing file is reported by path while the others still load.
+TEST(MovieDataLoaderTest, ParallelLoadReportsFailingFile)
+{
+    TempDir dir;
+    dir.Write("a.json", R"({ "movies": [ { "title": "Matrix", "theaters": ["Hall 1"] } ] })");
+    const std::string bad = dir.Write("b.json", "{ \"movies\": [\n  { \"title\" } ] }");
+    dir.Write("c.json", R"({ "movies": [ { "title": "Up", "theaters": ["Hall 2"] } ] })");
+
+    MovieBooker mb;
+    std::vector<CatalogLoadError> errors;
+    EXPECT_FALSE(MovieDataLoader::LoadFiles(MovieDataLoader::ExpandPaths(dir.path.string()), 4, mb, errors));
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_EQ(errors[0].path, bad);
+    EXPECT_EQ(errors[0].line, 2u);
+    EXPECT_THAT(mb.GetMovies(), UnorderedElementsAre("Matrix", "Up"));
+
+    errors.clear();
+    EXPECT_FALSE(MovieDataLoader::LoadFiles({}, 4, mb, errors));
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <SeatBitmap.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using ::testing::ElementsAre;
+
+// Tests that a fresh bitmap reports every seat free, including a partial last word.
+TEST(SeatBitmapTest, InitiallyAllFree)
+{
+    SeatBitmap seats(70);
+    EXPECT_EQ(seats.Size(), 70u);
+    EXPECT_EQ(seats.CountFree(), 70u);
+
+    std::vector<unsigned int> free;
+    seats.CollectFree(free);
+    ASSERT_EQ(free.size(), 70u);
+    EXPECT_EQ(free.front(), 1u);
+    EXPECT_EQ(free.back(), 70u);
+}
+
+// Tests claiming and releasing seats within one word and across words.
+TEST(SeatBitmapTest, ClaimAndRelease)
+{
+    SeatBitmap seats(130);
+    const unsigned int a[] = { 3, 64, 65, 130 };
+    EXPECT_TRUE(seats.TryClaim(a, 4));
+    EXPECT_TRUE(seats.IsBooked(64));
+    EXPECT_TRUE(seats.IsBooked(65));
+    EXPECT_FALSE(seats.IsBooked(66));
+    EXPECT_EQ(seats.CountFree(), 126u);
+
+    const unsigned int b[] = { 1, 130 };
+    EXPECT_FALSE(seats.TryClaim(b, 2));                 // 130 taken, 1 must stay free
+    EXPECT_FALSE(seats.IsBooked(1));
+
+    seats.Release(a, 2);
+    std::vector<unsigned int> free;
+    seats.CollectFree(free);
+    EXPECT_EQ(free.size(), 128u);
+    EXPECT_FALSE(seats.IsBooked(3));
+    EXPECT_TRUE(seats.IsBooked(65));
+}
+
+// Tests that invalid id sets are rejected without claiming anything.
+TEST(SeatBitmapTest, InvalidClaimsAreRejected)
+{
+    SeatBitmap seats(20);
+    const unsigned int zero[] = { 0 };
+    const unsigned int over[] = { 5, 21 };
+    const unsigned int dup[] = { 7, 7 };
+    EXPECT_FALSE(seats.TryClaim(zero, 1));
+    EXPECT_FALSE(seats.TryClaim(over, 2));
+    EXPECT_FALSE(seats.TryClaim(dup, 2));
+    EXPECT_FALSE(seats.TryClaim(dup, 0));
+    EXPECT_EQ(seats.CountFree(), 20u);
+
+    std::vector<unsigned int> free;
+    SeatBitmap tiny(3);
+    const unsigned int two[] = { 2 };
+    tiny.TryClaim(two, 1);
+    tiny.CollectFree(free);
+    EXPECT_THAT(free, ElementsAre(1u, 3u));
+}
+
+// Tests free-seat collection on a large bitmap mixing fully free, fully booked
+// and partial words, appended after existing output.
+TEST(SeatBitmapTest, CollectFreeOnLargeBitmap)
+{
+    SeatBitmap seats(20000);
+    std::vector<unsigned int> booked;
+    for (unsigned int id = 129; id <= 192; ++id)        // word 2 fully booked
+        booked.push_back(id);
+    booked.push_back(1);
+    booked.push_back(19999);
+    ASSERT_TRUE(seats.TryClaim(booked.data(), booked.size()));
+
+    std::vector<unsigned int> free = { 42 };
+    seats.CollectFree(free);
+    ASSERT_EQ(free.size(), 1u + 20000u - booked.size());
+    EXPECT_EQ(free[0], 42u);                            // existing content kept
+    EXPECT_EQ(free[1], 2u);
+    EXPECT_EQ(free[128], 193u);                         // 2..128 then the booked word is skipped
+    EXPECT_EQ(free.back(), 20000u);
+    EXPECT_EQ(seats.CountFree(), free.size() - 1);
+    EXPECT_TRUE(std::is_sorted(free.begin() + 1, free.end()));
+}
+
+// Tests that ClaimBest takes the lowest block of adjacent seats, across word
+// boundaries, and falls back to scattered seats only when allowed.
+TEST(SeatBitmapTest, ClaimBestPrefersContiguousBlocks)
+{
+    SeatBitmap seats(200);
+    std::vector<unsigned int> booked;
+    for (unsigned int id = 1; id <= 200; id += 4)       // every 4th seat: gaps of three
+        booked.push_back(id);
+    booked.push_back(62);                               // free run 63..64 then 66..68: but 65 is booked
+    ASSERT_TRUE(seats.TryClaim(booked.data(), booked.size()));
+
+    std::vector<unsigned int> best;
+    ASSERT_TRUE(seats.ClaimBest(3, true, best));
+    EXPECT_THAT(best, ElementsAre(2u, 3u, 4u));
+    EXPECT_FALSE(seats.ClaimBest(4, true, best));
+    EXPECT_TRUE(best.empty());
+
+    // open a 7 seat block spanning words 0 and 1 (seats 62..68)
+    const unsigned int reopen[] = { 62, 65 };
+    seats.Release(reopen, 2);
+    ASSERT_TRUE(seats.ClaimBest(6, true, best));
+    EXPECT_THAT(best, ElementsAre(62u, 63u, 64u, 65u, 66u, 67u));
+
+    // not contiguous: the lowest free seats
+    ASSERT_TRUE(seats.ClaimBest(4, false, best));
+    EXPECT_THAT(best, ElementsAre(6u, 7u, 8u, 10u));
+
+    EXPECT_FALSE(seats.ClaimBest(0, false, best));
+    EXPECT_FALSE(seats.ClaimBest(201, false, best));
+    EXPECT_FALSE(seats.ClaimBest(seats.CountFree() + 1, false, best));
+    ASSERT_TRUE(seats.ClaimBest(seats.CountFree(), false, best));
+    EXPECT_EQ(seats.CountFree(), 0u);
+}
+
+// Tests that concurrent ClaimBest calls never hand out a seat twice.
+TEST(SeatBitmapTest, ConcurrentClaimBestIsExclusive)
+{
+    SeatBitmap seats(500);
+    std::vector<std::vector<unsigned int>> results(8);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < results.size(); ++t)
+        threads.emplace_back([&, t]() {
+            std::vector<unsigned int> best;
+            while (seats.ClaimBest(3, t % 2 == 0, best))
+                results[t].insert(results[t].end(), best.begin(), best.end());
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    std::vector<unsigned int> all;
+    for (const auto &r : results)
+        all.insert(all.end(), r.begin(), r.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+    EXPECT_EQ(all.size(), 498u);                        // 166 triples; 2 seats are left over
+    EXPECT_EQ(seats.CountFree(), 2u);
+}
+
+// Tests that ClaimBest keeps going while another thread keeps taking the seat it
+// picked: a caller only gives up once every seat is booked.
+TEST(SeatBitmapTest, ClaimBestOutlastsContention)
+{
+    SeatBitmap seats(256);
+    std::atomic<bool> done{ false };
+    std::thread churn([&]() {
+        const unsigned int first[] = { 1 };             // the seat ClaimBest(1) always picks first
+        while (!done)
+            if (seats.TryClaim(first, 1))
+                seats.Release(first, 1);
+    });
+
+    std::vector<std::vector<unsigned int>> results(4);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < results.size(); ++t)
+        threads.emplace_back([&, t]() {
+            std::vector<unsigned int> best;
+            while (seats.ClaimBest(1, false, best))
+                results[t].push_back(best.front());
+        });
+    for (auto &thread : threads)
+        thread.join();
+    done = true;
+    churn.join();
+
+    std::vector<unsigned int> all;
+    for (const auto &r : results)
+        all.insert(all.end(), r.begin(), r.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+    ASSERT_GE(all.size(), 255u);
+    EXPECT_EQ(all.back(), 256u);
+    EXPECT_EQ(all[all.size() - 255], 2u);               // seats 2..256 all went to ClaimBest
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <ServerMetrics.hpp>
+#include <thread>
+#include <vector>
+
+using ::testing::HasSubstr;
+
+// Tests that counters recorded on several threads are merged on read.
+TEST(ServerMetricsTest, ThreadCountersAreMerged)
+{
+    ServerMetrics metrics(1);
+    constexpr int kThreads = 4, kPerThread = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kPerThread; ++i)
+            {
+                if (metrics.CountCommand(Command::BookSeats))
+                    metrics.RecordLatency(Command::BookSeats, std::chrono::nanoseconds(1500));
+                metrics.CountBooking(i % 4 != 0);
+                metrics.CountBytesIn(10);
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+    metrics.CountSession(true);                         // from this thread too
+
+    const MetricsSnapshot snapshot = metrics.Snapshot();
+    const auto &book = snapshot.commands[static_cast<std::size_t>(Command::BookSeats)];
+    EXPECT_EQ(book.count, static_cast<std::uint64_t>(kThreads * kPerThread));
+    EXPECT_EQ(book.samples, book.count);
+    EXPECT_EQ(book.latency_ns, book.count * 1500);
+    EXPECT_EQ(snapshot.booked, static_cast<std::uint64_t>(kThreads * kPerThread * 3 / 4));
+    EXPECT_EQ(snapshot.conflicts, static_cast<std::uint64_t>(kThreads * kPerThread / 4));
+    EXPECT_EQ(snapshot.bytes_in, static_cast<std::uint64_t>(kThreads * kPerThread * 10));
+    EXPECT_EQ(snapshot.accepted, 1u);
+    EXPECT_EQ(snapshot.commands[static_cast<std::size_t>(Command::ListMovies)].count, 0u);
+}
+
+// Tests that a thread switching between two instances registers with each of them once.
+TEST(ServerMetricsTest, AlternatingInstancesRegisterOnce)
+{
+    ServerMetrics first(1), second(1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        first.CountBytesIn(1);
+        second.CountBytesOut(1);
+    }
+    EXPECT_EQ(first.ThreadCount(), 1u);
+    EXPECT_EQ(second.ThreadCount(), 1u);
+    EXPECT_EQ(first.Snapshot().bytes_in, 1000u);
+    EXPECT_EQ(second.Snapshot().bytes_out, 1000u);
+}
+
+// Tests that latency is sampled once per period per command, starting with the first.
+TEST(ServerMetricsTest, LatencyIsSampled)
+{
+    ServerMetrics metrics(10);                          // rounded up to 16
+    std::vector<int> timed;
+    for (int i = 0; i < 40; ++i)
+        if (metrics.CountCommand(Command::GetFreeSeats))
+            timed.push_back(i);
+    EXPECT_THAT(timed, ::testing::ElementsAre(0, 16, 32));
+    EXPECT_TRUE(metrics.CountCommand(Command::Stats));  // each command has its own period
+}
+
+// Tests that quantiles come from the log2 buckets and the Prometheus histogram is cumulative.
+TEST(ServerMetricsTest, QuantilesAndPrometheusFormat)
+{
+    ServerMetrics metrics(1);
+    for (int i = 0; i < 99; ++i)
+    {
+        metrics.CountCommand(Command::BookSeats);
+        metrics.RecordLatency(Command::BookSeats, std::chrono::nanoseconds(600));       // bucket below 1024 ns
+    }
+    metrics.CountCommand(Command::BookSeats);
+    metrics.RecordLatency(Command::BookSeats, std::chrono::microseconds(100));          // below 131072 ns
+
+    const MetricsSnapshot snapshot = metrics.Snapshot();
+    EXPECT_EQ(snapshot.Quantile(Command::BookSeats, 0.5), 1024u);
+    EXPECT_EQ(snapshot.Quantile(Command::BookSeats, 0.99), 1024u);
+    EXPECT_EQ(snapshot.Quantile(Command::BookSeats, 0.999), 131072u);
+    EXPECT_EQ(snapshot.Quantile(Command::ListMovies, 0.5), 0u);
+
+    const std::string text = ServerMetrics::FormatPrometheus(snapshot);
+    EXPECT_THAT(text, HasSubstr("# TYPE movie_booker_request_duration_seconds histogram\n"));
+    EXPECT_THAT(text, HasSubstr("movie_booker_request_duration_seconds_bucket{command=\"book_seats\",le=\"5.12e-07\"} 0\n"));
+    EXPECT_THAT(text, HasSubstr("movie_booker_request_duration_seconds_bucket{command=\"book_seats\",le=\"1.024e-06\"} 99\n"));
+    EXPECT_THAT(text, HasSubstr("movie_booker_request_duration_seconds_bucket{command=\"book_seats\",le=\"0.000131072\"} 100\n"));
+    EXPECT_THAT(text, HasSubstr("movie_booker_request_duration_seconds_bucket{command=\"book_seats\",le=\"+Inf\"} 100\n"));
+    EXPECT_THAT(text, HasSubstr("movie_booker_requests_total{command=\"book_seats\"} 100\n"));
+    EXPECT_THAT(text, ::testing::Not(HasSubstr("command=\"list_movies\"")));
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <TimerWheel.hpp>
+
+using ::testing::ElementsAre;
+
+// Tests that ids expire exactly at their tick, in deadline order.
+TEST(TimerWheelTest, ExpiresAtDeadline)
+{
+    TimerWheel wheel;
+    wheel.Schedule(3, 30);
+    wheel.Schedule(1, 10);
+    wheel.Schedule(2, 10);
+    EXPECT_EQ(wheel.Size(), 3u);
+
+    std::vector<std::uint64_t> expired;
+    wheel.Advance(9, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.Advance(10, expired);
+    EXPECT_THAT(expired, ElementsAre(1, 2));
+    wheel.Advance(100, expired);
+    EXPECT_THAT(expired, ElementsAre(1, 2, 3));
+    EXPECT_EQ(wheel.Size(), 0u);
+    EXPECT_EQ(wheel.Now(), 100u);
+}
+
+// Tests that deadlines on higher levels cascade down and expire on time.
+TEST(TimerWheelTest, CascadesAcrossLevels)
+{
+    TimerWheel wheel(5);
+    const std::uint64_t deadlines[] = { 64, 65, 4095, 4096, 4101, 300000, 262144 + 77 };
+    for (std::uint64_t d : deadlines)
+        wheel.Schedule(d, d);
+
+    std::vector<std::uint64_t> expired;
+    for (std::uint64_t tick = 6; tick <= 300000; ++tick)
+    {
+        wheel.Advance(tick, expired);
+        for (std::uint64_t id : expired)
+            EXPECT_EQ(id, tick);                        // each id is its own deadline
+        expired.clear();
+    }
+    EXPECT_EQ(wheel.Size(), 0u);
+}
+
+// Tests that past deadlines fire on the next tick and far ones are clamped to the horizon.
+TEST(TimerWheelTest, ClampsDeadlines)
+{
+    TimerWheel wheel(100);
+    wheel.Schedule(1, 50);
+    wheel.Schedule(2, 100 + TimerWheel::kHorizon * 2);
+
+    std::vector<std::uint64_t> expired;
+    wheel.Advance(101, expired);
+    EXPECT_THAT(expired, ElementsAre(1));
+    wheel.Advance(100 + TimerWheel::kHorizon - 2, expired);
+    EXPECT_THAT(expired, ElementsAre(1));
+    wheel.Advance(100 + TimerWheel::kHorizon - 1, expired);
+    EXPECT_THAT(expired, ElementsAre(1, 2));
+}
@@ -123,3 +123,520 @@ TEST(MovieBookerTest, BookingInOneMovieDoesNotAffectOtherMovieInSameTheater)
     auto freeB = mb.GetFreeSeats("DualTheater", "MovieB");
     EXPECT_EQ(std::count(freeB.begin(), freeB.end(), 10u), 1);
 }
+
+// Tests that the one-winner guarantee holds with many more threads than seats
+// and cores, now that bookings no longer take a per-showing mutex.
+TEST(MovieBookerTest, ConcurrentBookingOnlyOneSucceedsHighThreadCount) 
+{
+    MovieBooker mb;
+    mb.AddMovie("M", {"Sala"});
+
+    const int threads = 64;
+    std::atomic<int> successCount{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> ths;
+    for (int i = 0; i < threads; ++i) {
+        ths.emplace_back( [&]() 
+        {
+            while (!go.load())
+                std::this_thread::yield();
+            if (mb.BookSeats("Sala", "M", {10, 11})) 
+                successCount.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    go = true;
+    for (auto &t : ths) t.join();
+
+    EXPECT_EQ(successCount.load(), 1);
+    EXPECT_EQ(mb.GetFreeSeats("Sala", "M").size(), 18u);
+}
+
+// Tests that a booking spanning several 64-seat words is all-or-nothing: a
+// conflict in a later word leaves the seats of earlier words free.
+TEST(MovieBookerTest, MultiWordBookingIsAllOrNothing) 
+{
+    MovieBooker mb(200);
+    mb.AddMovie("M", {"Big"});
+
+    EXPECT_TRUE(mb.BookSeats("Big", "M", {150}));
+    EXPECT_FALSE(mb.BookSeats("Big", "M", {1, 70, 150}));       // 150 is taken
+
+    auto free = mb.GetFreeSeats("Big", "M");
+    EXPECT_EQ(free.size(), 199u);
+    EXPECT_EQ(std::count(free.begin(), free.end(), 1u), 1);
+    EXPECT_EQ(std::count(free.begin(), free.end(), 70u), 1);
+
+    EXPECT_TRUE(mb.BookSeats("Big", "M", {1, 70, 130}));
+    EXPECT_FALSE(mb.BookSeats("Big", "M", {2, 70, 2}));          // repeated id
+    EXPECT_FALSE(mb.BookSeats("Big", "M", {201}));               // out of range
+}
+
+// Tests that overlapping multi-word bookings racing on many threads never
+// double-book a seat: for each seat pair exactly one thread wins.
+TEST(MovieBookerTest, ConcurrentMultiWordBookingsDoNotOverlap) 
+{
+    MovieBooker mb(256);
+    mb.AddMovie("M", {"Big"});
+
+    const int pairs = 16, threadsPerPair = 4;
+    std::atomic<int> successCount{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> ths;
+    for (int i = 0; i < pairs * threadsPerPair; ++i) {
+        unsigned int k = static_cast<unsigned int>(i % pairs) + 1;
+        ths.emplace_back( [&, k]() 
+        {
+            while (!go.load())
+                std::this_thread::yield();
+            // seats in word 0 and word 3, listed in both orders
+            std::vector<unsigned int> seats = (k % 2) ? std::vector<unsigned int>{k, 200 + k} : std::vector<unsigned int>{200 + k, k};
+            if (mb.BookSeats("Big", "M", seats)) 
+                successCount.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    go = true;
+    for (auto &t : ths) t.join();
+
+    EXPECT_EQ(successCount.load(), pairs);
+    EXPECT_EQ(mb.GetFreeSeats("Big", "M").size(), 256u - 2 * pairs);
+}
+
+// Tests that every catalog change publishes a new catalog version and that
+// showings added earlier keep their seat state across versions.
+TEST(MovieBookerTest, AddMoviePublishesNewCatalogVersion) 
+{
+    MovieBooker mb;
+    auto v0 = mb.GetCatalogVersion();
+
+    mb.AddMovie("M", {"T1"});
+    auto v1 = mb.GetCatalogVersion();
+    EXPECT_GT(v1, v0);
+
+    EXPECT_TRUE(mb.BookSeats("T1", "M", {4}));
+    mb.AddMovie("M", {"T2"});
+    EXPECT_GT(mb.GetCatalogVersion(), v1);
+
+    EXPECT_THAT(mb.GetTheatersForMovie("M"), UnorderedElementsAre("T1", "T2"));
+    EXPECT_FALSE(mb.BookSeats("T1", "M", {4}));             // booking survived the new version
+    EXPECT_EQ(mb.GetFreeSeats("T2", "M").size(), 20u);
+}
+
+// Tests that readers running while the catalog is being extended always see a
+// complete catalog version: the number of movies never goes backwards and every
+// listed movie has its theater.
+TEST(MovieBookerTest, ReadersSeeConsistentCatalogWhileAddingMovies) 
+{
+    MovieBooker mb;
+    mb.AddMovie("M0", {"T0"});
+
+    const int movies = 200;
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistencies{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() 
+        {
+            std::size_t lastCount = 0;
+            while (!done.load()) {
+                auto list = mb.GetMovies();
+                if (list.size() < lastCount)
+                    ++inconsistencies;
+                lastCount = list.size();
+                for (const auto &m : list)
+                    if (mb.GetTheatersForMovie(m).size() != 1 || mb.GetFreeSeats("T" + m.substr(1), m).empty())
+                        ++inconsistencies;
+                mb.IsTheater("T0");
+            }
+        });
+    }
+
+    for (int i = 1; i < movies; ++i)
+        mb.AddMovie("M" + std::to_string(i), {"T" + std::to_string(i)});
+    done = true;
+    for (auto &t : readers) t.join();
+
+    EXPECT_EQ(inconsistencies.load(), 0);
+    EXPECT_EQ(mb.GetMovies().size(), static_cast<std::size_t>(movies));
+}
+
+// Tests that names resolve to ids and that id based queries and bookings act
+// on the same showing as the name based ones.
+TEST(MovieBookerTest, ResolvedIdsAddressTheSameShowing) 
+{
+    MovieBooker mb;
+    mb.AddMovie("MovieA", {"T1", "T2"});
+    mb.AddMovie("MovieB", {"T2"});
+
+    auto movieA = mb.ResolveMovie("MovieA");
+    auto movieB = mb.ResolveMovie("MovieB");
+    auto t1 = mb.ResolveTheater("T1");
+    auto t2 = mb.ResolveTheater("T2");
+    ASSERT_TRUE(movieA && movieB && t1 && t2);
+    EXPECT_NE(*movieA, *movieB);
+    EXPECT_FALSE(mb.ResolveMovie("NoSuchMovie"));
+    EXPECT_FALSE(mb.ResolveTheater("NoSuchTheater"));
+    EXPECT_FALSE(mb.ResolveShowing(*movieB, *t1));         // T1 does not show MovieB
+
+    auto showingA2 = mb.ResolveShowing(*movieA, *t2);
+    auto showingB2 = mb.ResolveShowing(*movieB, *t2);
+    ASSERT_TRUE(showingA2 && showingB2);
+    EXPECT_NE(*showingA2, *showingB2);
+
+    EXPECT_TRUE(mb.BookSeats(*showingA2, {1, 2}));
+    EXPECT_FALSE(mb.BookSeats("T2", "MovieA", {2}));        // same showing by name
+    EXPECT_EQ(mb.GetFreeSeats(*showingA2).size(), 18u);
+    EXPECT_EQ(mb.GetFreeSeats(*showingB2).size(), 20u);
+
+    EXPECT_TRUE(mb.GetFreeSeats(IMovieBooker::ShowingId{999}).empty());
+    EXPECT_FALSE(mb.BookSeats(IMovieBooker::ShowingId{999}, {1}));
+}
+
+// Tests that a theater registered with its own capacity sizes every showing in
+// it, while theaters only named by AddMovie keep the default of 20 seats.
+TEST(MovieBookerTest, TheaterCapacityIsPerTheater) 
+{
+    MovieBooker mb;
+    EXPECT_TRUE(mb.AddTheater("Arena", 20000));
+    EXPECT_FALSE(mb.AddTheater("Arena", 100));               // already known
+    EXPECT_FALSE(mb.AddTheater("Empty", 0));
+    mb.AddMovie("Concert", {"Arena", "Small"});
+
+    auto concert = mb.ResolveMovie("Concert");
+    auto arena = mb.ResolveShowing(*concert, *mb.ResolveTheater("Arena"));
+    auto small = mb.ResolveShowing(*concert, *mb.ResolveTheater("Small"));
+    ASSERT_TRUE(arena && small);
+    EXPECT_EQ(mb.GetSeatCount(*arena), 20000u);
+    EXPECT_EQ(mb.GetSeatCount(*small), 20u);
+    EXPECT_EQ(mb.GetSeatCount(IMovieBooker::ShowingId{999}), 0u);
+
+    EXPECT_TRUE(mb.BookSeats(*arena, {1, 10000, 20000}));
+    EXPECT_FALSE(mb.BookSeats(*arena, {20001}));
+    EXPECT_FALSE(mb.BookSeats(*small, {21}));
+    EXPECT_FALSE(mb.AddTheater("Small", 50));                // created implicitly with 20 seats
+
+    auto free = mb.GetFreeSeats(*arena);
+    EXPECT_EQ(free.size(), 19997u);
+    EXPECT_EQ(free.front(), 2u);
+    EXPECT_EQ(free.back(), 19999u);
+    EXPECT_TRUE(std::is_sorted(free.begin(), free.end()));
+}
+
+// Tests that a batch over several showings books every item or nothing, and
+// that items naming the same showing are combined.
+TEST(MovieBookerTest, BookBatchIsAllOrNothing) 
+{
+    MovieBooker mb;
+    mb.AddMovie("A", {"T1", "T2"});
+    mb.AddMovie("B", {"T1"});
+    const auto a = *mb.ResolveMovie("A"), b = *mb.ResolveMovie("B");
+    const auto t1 = *mb.ResolveTheater("T1"), t2 = *mb.ResolveTheater("T2");
+    const auto a1 = *mb.ResolveShowing(a, t1), a2 = *mb.ResolveShowing(a, t2), b1 = *mb.ResolveShowing(b, t1);
+
+    EXPECT_TRUE(mb.BookSeats(b1, {7}));
+
+    // last item conflicts -> the earlier ones must be rolled back
+    EXPECT_FALSE(mb.BookBatch({ {a2, {1, 2}}, {a1, {3}}, {b1, {6, 7}} }));
+    EXPECT_EQ(mb.GetFreeSeats(a1).size(), 20u);
+    EXPECT_EQ(mb.GetFreeSeats(a2).size(), 20u);
+    EXPECT_EQ(mb.GetFreeSeats(b1).size(), 19u);
+
+    // unknown showing or empty seat list -> nothing booked
+    EXPECT_FALSE(mb.BookBatch({ {a1, {1}}, {999, {1}} }));
+    EXPECT_FALSE(mb.BookBatch({ {a1, {1}}, {a2, {}} }));
+    EXPECT_FALSE(mb.BookBatch({}));
+    EXPECT_EQ(mb.GetFreeSeats(a1).size(), 20u);
+
+    // same showing twice: disjoint seats are fine, overlapping seats are not
+    EXPECT_FALSE(mb.BookBatch({ {a1, {1, 2}}, {a1, {2}} }));
+    EXPECT_TRUE(mb.BookBatch({ {a2, {1, 2}}, {a1, {3}}, {a1, {4}}, {b1, {6}} }));
+    EXPECT_EQ(mb.GetFreeSeats(a1).size(), 18u);
+    EXPECT_EQ(mb.GetFreeSeats(a2).size(), 18u);
+    EXPECT_EQ(mb.GetFreeSeats(b1).size(), 18u);
+}
+
+// Tests that concurrent batches sharing showings, listed in different orders,
+// never double-book a seat: of the batches competing for a seat exactly one wins.
+TEST(MovieBookerTest, ConcurrentOverlappingBatchesDoNotDoubleBook) 
+{
+    MovieBooker mb(64);
+    mb.AddMovie("M", {"T1", "T2", "T3"});
+    const auto m = *mb.ResolveMovie("M");
+    std::vector<IMovieBooker::ShowingId> showings;
+    for (const char* t : {"T1", "T2", "T3"})
+        showings.push_back(*mb.ResolveShowing(m, *mb.ResolveTheater(t)));
+
+    const unsigned int seatsInPlay = 32;
+    const int threadsPerSeat = 4;
+    std::atomic<int> successCount{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> ths;
+    for (unsigned int seat = 1; seat <= seatsInPlay; ++seat)
+        for (int k = 0; k < threadsPerSeat; ++k)
+            ths.emplace_back([&, seat, k]()
+            {
+                while (!go.load())
+                    std::this_thread::yield();
+                // the same seat in all three showings, rotated so every thread starts elsewhere
+                std::vector<IMovieBooker::BookingItem> items;
+                for (int i = 0; i < 3; ++i)
+                    items.push_back({ showings[(i + k) % 3], { seat } });
+                if (mb.BookBatch(items))
+                    successCount.fetch_add(1, std::memory_order_relaxed);
+            });
+    go = true;
+    for (auto &t : ths) t.join();
+
+    EXPECT_EQ(successCount.load(), static_cast<int>(seatsInPlay));
+    for (auto showing : showings)
+        EXPECT_EQ(mb.GetFreeSeats(showing).size(), 64u - seatsInPlay);
+}
+
+// Tests that a batch is not refused for seats that another batch claimed only
+// for a moment and rolled back.
+TEST(MovieBookerTest, BatchRetriesSeatsOfRolledBackBatches)
+{
+    MovieBooker mb;
+    mb.AddMovie("A", {"T1"});
+    mb.AddMovie("B", {"T1"});
+    const auto t1 = *mb.ResolveTheater("T1");
+    const auto a1 = *mb.ResolveShowing(*mb.ResolveMovie("A"), t1), b1 = *mb.ResolveShowing(*mb.ResolveMovie("B"), t1);
+    // batches claim in showing id order: seats of `first` are claimed before `last` is tried
+    const auto first = std::min(a1, b1), last = std::max(a1, b1);
+    ASSERT_TRUE(mb.BookSeats(last, {7}));
+
+    // these batches keep claiming the seat being booked and always fail on `last`
+    std::atomic<unsigned int> target{1};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> doomed;
+    for (int t = 0; t < 2; ++t)
+        doomed.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed))
+                EXPECT_FALSE(mb.BookBatch({ {first, {target.load()}}, {last, {7}} }));
+        });
+    for (unsigned int seat = 1; seat <= 20; ++seat)
+    {
+        target = seat;
+        EXPECT_TRUE(mb.BookBatch({ {first, {seat}} })) << "seat " << seat;
+    }
+    stop = true;
+    for (auto &t : doomed) t.join();
+    EXPECT_TRUE(mb.GetFreeSeats(first).empty());
+}
+
+// Tests that held seats are unavailable until the hold is released or expires,
+// and that a confirmed hold stays booked past its deadline.
+TEST(MovieBookerTest, HoldsBlockSeatsUntilConfirmedReleasedOrExpired)
+{
+    using namespace std::chrono;
+    MovieBooker mb;
+    mb.AddMovie("A", {"T1"});
+    const auto showing = *mb.ResolveShowing(*mb.ResolveMovie("A"), *mb.ResolveTheater("T1"));
+
+    const auto h1 = mb.HoldSeats(showing, {1, 2}, milliseconds(50));
+    const auto h2 = mb.HoldSeats(showing, {3}, milliseconds(50));
+    const auto h3 = mb.HoldSeats(showing, {4}, seconds(60));
+    ASSERT_TRUE(h1 && h2 && h3);
+    EXPECT_FALSE(mb.HoldSeats(showing, {2, 5}, seconds(1)));        // seat 2 is held
+    EXPECT_FALSE(mb.BookSeats(showing, {3}));
+    EXPECT_FALSE(mb.HoldSeats(showing, {21}, seconds(1)));
+    EXPECT_FALSE(mb.HoldSeats(999, {1}, seconds(1)));
+    EXPECT_EQ(mb.GetFreeSeats(showing).size(), 16u);
+    EXPECT_EQ(mb.GetHeldSeatCount(showing), 4u);
+    EXPECT_EQ(mb.GetHoldCount(), 3u);
+
+    EXPECT_TRUE(mb.ConfirmHold(*h2));
+    EXPECT_FALSE(mb.ConfirmHold(*h2));
+    EXPECT_FALSE(mb.ReleaseHold(*h2));
+    EXPECT_TRUE(mb.ReleaseHold(*h3));
+    EXPECT_FALSE(mb.ReleaseHold(0));
+    EXPECT_EQ(mb.GetHeldSeatCount(showing), 2u);
+
+    // h1 expires; the confirmed h2 keeps seat 3 booked
+    const auto later = steady_clock::now() + seconds(1);
+    EXPECT_EQ(mb.ExpireHolds(later), 1u);
+    EXPECT_FALSE(mb.ConfirmHold(*h1));
+    EXPECT_EQ(mb.GetHoldCount(), 0u);
+    EXPECT_EQ(mb.GetHeldSeatCount(showing), 0u);
+    EXPECT_EQ(mb.GetFreeSeats(showing).size(), 19u);
+    EXPECT_FALSE(mb.BookSeats(showing, {3}));
+
+    // the slot of an old hold is reused under a new id; the old id stays dead
+    const auto h4 = mb.HoldSeats(showing, {1}, seconds(60));
+    ASSERT_TRUE(h4);
+    EXPECT_NE(*h4, *h1);
+    EXPECT_NE(*h4, *h3);
+    EXPECT_FALSE(mb.ReleaseHold(*h1));
+    EXPECT_FALSE(mb.ReleaseHold(*h3));
+    EXPECT_EQ(mb.ExpireHolds(later), 0u);
+    EXPECT_TRUE(mb.ReleaseHold(*h4));
+}
+
+// Tests that concurrent holders of the same seats never both succeed and that
+// every seat comes back once all holds expire.
+TEST(MovieBookerTest, ConcurrentHoldsExpireCleanly)
+{
+    using namespace std::chrono;
+    MovieBooker mb(64);
+    mb.AddMovie("A", {"T1"});
+    const auto showing = *mb.ResolveShowing(*mb.ResolveMovie("A"), *mb.ResolveTheater("T1"));
+
+    std::atomic<int> held{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+        threads.emplace_back([&]() {
+            for (unsigned int seat = 1; seat <= 64; ++seat)
+                if (mb.HoldSeats(showing, {seat}, milliseconds(10)))
+                    ++held;
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    EXPECT_EQ(held.load(), 64);
+    EXPECT_EQ(mb.GetFreeSeats(showing).size(), 0u);
+    EXPECT_EQ(mb.ExpireHolds(steady_clock::now() + seconds(1)), 64u);
+    EXPECT_EQ(mb.GetFreeSeats(showing).size(), 64u);
+    EXPECT_EQ(mb.GetHeldSeatCount(showing), 0u);
+}
+
+// Tests that BookBest books a block of adjacent seats and respects the contiguous flag.
+TEST(MovieBookerTest, BookBestPicksAdjacentSeats)
+{
+    MovieBooker mb;
+    mb.AddMovie("A", {"T1"});
+    const auto showing = *mb.ResolveShowing(*mb.ResolveMovie("A"), *mb.ResolveTheater("T1"));
+    ASSERT_TRUE(mb.BookSeats(showing, {3, 10, 15}));
+
+    std::vector<unsigned int> seats;
+    ASSERT_TRUE(mb.BookBest(showing, 4, true, seats));
+    EXPECT_THAT(seats, ::testing::ElementsAre(4u, 5u, 6u, 7u));
+    ASSERT_TRUE(mb.BookBest(showing, 5, true, seats));
+    EXPECT_THAT(seats, ::testing::ElementsAre(16u, 17u, 18u, 19u, 20u));
+    EXPECT_FALSE(mb.BookBest(showing, 5, true, seats));          // free: 1,2,8,9,11..14
+    ASSERT_TRUE(mb.BookBest(showing, 3, false, seats));          // a block is still preferred
+    EXPECT_THAT(seats, ::testing::ElementsAre(11u, 12u, 13u));
+    ASSERT_TRUE(mb.BookBest(showing, 4, false, seats));          // no block of 4: lowest seats
+    EXPECT_THAT(seats, ::testing::ElementsAre(1u, 2u, 8u, 9u));
+    EXPECT_FALSE(mb.BookBest(showing, 2, false, seats));
+    EXPECT_FALSE(mb.BookBest(999, 1, false, seats));
+    EXPECT_EQ(mb.GetFreeSeats(showing).size(), 1u);
+}
+
+// Tests that AddCatalog gives the same catalog as AddTheater / AddMovie calls,
+// in one version, skipping invalid entries.
+TEST(MovieBookerTest, AddCatalogMatchesIndividualAdds)
+{
+    MovieBooker one, bulk;
+    one.AddTheater("IMAX", 100);
+    one.AddMovie("A", {"T1", "IMAX", "T1"});
+    one.AddMovie("B", {"IMAX"});
+    one.AddMovie("A", {"T2"});
+
+    bulk.AddMovie("A", {"T1"});                                 // bulk adds extend an existing catalog
+    ASSERT_TRUE(bulk.BookSeats("T1", "A", {5}));
+    const auto version = bulk.GetCatalogVersion();
+    IMovieBooker::CatalogChunk chunk;
+    chunk.theaters = { {"IMAX", 100}, {"Empty", 0}, {"T1", 50} };   // invalid, and already known
+    chunk.movies = { {"A", {"IMAX", "T1"}}, {"B", {"IMAX"}}, {"", {"T3"}}, {"C", {}}, {"A", {"T2"}} };
+    EXPECT_FALSE(bulk.AddCatalog(chunk));
+    EXPECT_EQ(bulk.GetCatalogVersion(), version + 1);
+
+    EXPECT_THAT(bulk.GetMovies(), UnorderedElementsAre("A", "B"));
+    for (const auto &movie : { "A", "B" })
+    {
+        EXPECT_THAT(bulk.GetTheatersForMovie(movie), ::testing::UnorderedElementsAreArray(one.GetTheatersForMovie(movie)));
+        const auto mid = *bulk.ResolveMovie(movie);
+        EXPECT_EQ(mid, *one.ResolveMovie(movie));
+        for (const auto &theater : bulk.GetTheaterList(mid))
+            EXPECT_EQ(bulk.ResolveShowing(mid, theater.first), one.ResolveShowing(*one.ResolveMovie(movie), *one.ResolveTheater(theater.second)));
+    }
+    EXPECT_EQ(bulk.GetFreeSeats("IMAX", "B").size(), 100u);
+    EXPECT_EQ(bulk.GetFreeSeats("T1", "A").size(), 19u);        // seat state of earlier showings is kept
+    EXPECT_FALSE(bulk.IsTheater("Empty"));
+
+    EXPECT_TRUE(bulk.AddCatalog(IMovieBooker::CatalogChunk()));
+    EXPECT_EQ(bulk.GetCatalogVersion(), version + 1);           // nothing to publish
+}
+
+// Tests that a catalog reload keeps unchanged showings with their seats and ids and drops the rest.
+TEST(MovieBookerTest, ReplaceCatalogKeepsUnchangedShowings)
+{
+    MovieBooker mb;
+    mb.AddTheater("IMAX", 100);
+    mb.AddMovie("Matrix", {"Hall 1", "IMAX"});
+    mb.AddMovie("Up", {"Hall 2"});
+    ASSERT_TRUE(mb.BookSeats("IMAX", "Matrix", {1, 2}));
+    const auto matrix = *mb.ResolveMovie("Matrix"), up = *mb.ResolveMovie("Up");
+    const auto imax = *mb.ResolveShowing(matrix, *mb.ResolveTheater("IMAX"));
+    const auto hall2 = *mb.ResolveShowing(up, *mb.ResolveTheater("Hall 2"));
+    const auto version = mb.GetCatalogVersion();
+
+    IMovieBooker::CatalogChunk chunk;
+    chunk.theaters = { {"IMAX", 10}, {"Annex", 30} };           // known capacities do not change
+    chunk.movies = { {"Matrix", {"IMAX", "Annex"}}, {"Dune", {"Hall 2", "IMAX"}}, {"Matrix", {"IMAX"}} };
+    CatalogDiff diff;
+    mb.ReplaceCatalog(chunk, &diff);
+    EXPECT_EQ(mb.GetCatalogVersion(), version + 1);
+    EXPECT_EQ(diff.kept_showings, 1u);
+    EXPECT_EQ(diff.removed_showings, 2u);                       // Matrix in Hall 1, Up in Hall 2
+    EXPECT_EQ(diff.added_showings, 3u);
+    EXPECT_EQ(diff.added_movies, 1u);
+    EXPECT_EQ(diff.removed_movies, 1u);
+
+    EXPECT_THAT(mb.GetMovies(), UnorderedElementsAre("Matrix", "Dune"));
+    EXPECT_THAT(mb.GetTheatersForMovie("Matrix"), UnorderedElementsAre("IMAX", "Annex"));
+    EXPECT_EQ(mb.ResolveShowing(matrix, *mb.ResolveTheater("IMAX")), imax);
+    EXPECT_EQ(mb.GetFreeSeats(imax).size(), 98u);               // bookings survive the reload
+    EXPECT_EQ(mb.GetFreeSeats("Annex", "Matrix").size(), 30u);
+    EXPECT_EQ(mb.GetFreeSeats("IMAX", "Dune").size(), 100u);
+    EXPECT_FALSE(mb.ResolveMovie("Up"));
+    EXPECT_EQ(mb.GetMovieList().size(), 2u);
+    EXPECT_TRUE(mb.GetFreeSeats(hall2).empty());                // removed ids stay unused
+    EXPECT_FALSE(mb.BookSeats(hall2, {1}));
+    EXPECT_FALSE(mb.BookSeats("Hall 1", "Matrix", {1}));
+
+    // a returning movie gets its old id back, with new showings
+    chunk.movies.push_back({ "Up", {"Hall 2"} });
+    mb.ReplaceCatalog(chunk, &diff);
+    EXPECT_EQ(diff.kept_showings, 4u);
+    EXPECT_EQ(diff.added_showings, 1u);
+    EXPECT_EQ(diff.added_movies, 1u);
+    EXPECT_EQ(mb.ResolveMovie("Up"), up);
+    EXPECT_NE(mb.ResolveShowing(up, *mb.ResolveTheater("Hall 2")), hall2);
+}
+
+// Tests that bookings running during reloads are neither lost nor doubled on kept showings.
+TEST(MovieBookerTest, ReplaceCatalogDuringBookings)
+{
+    MovieBooker mb;
+    mb.AddTheater("Big", 400);
+    IMovieBooker::CatalogChunk versions[2];
+    versions[0].movies = { {"Matrix", {"Big"}}, {"Up", {"Hall 1"}} };
+    versions[1].movies = { {"Matrix", {"Big"}}, {"Dune", {"Hall 1"}} };
+    mb.AddCatalog(versions[0]);
+    const auto showing = *mb.ResolveShowing(*mb.ResolveMovie("Matrix"), *mb.ResolveTheater("Big"));
+
+    std::atomic<bool> stop{ false };
+    std::thread reloader([&]() {
+        for (int round = 1; !stop; ++round)
+            mb.ReplaceCatalog(versions[round % 2]);
+    });
+    constexpr int kThreads = 4;
+    std::atomic<int> booked{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+        threads.emplace_back([&, t]() {
+            for (unsigned int seat = t + 1; seat <= 400; seat += kThreads)
+            {
+                booked += mb.BookSeats(showing, {seat});
+                booked += mb.BookSeats("Big", "Matrix", {seat});  // already booked: must fail
+                mb.GetMovies();
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+    stop = true;
+    reloader.join();
+
+    EXPECT_EQ(booked.load(), 400);
+    EXPECT_TRUE(mb.GetFreeSeats(showing).empty());
+}